@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Measure the latency and throughput of the `LOG_*` macros
+///
+/// Usage:  `bench_log [entries_per_producer] [max_producers]`
+///
+/// Runs 1, 2, 4... `max_producers` producer threads (the number of cores by
+/// default), with and without a LogConsumer draining empire::LogQueue, logging
+/// messages with 0, 1, 3 and 6 arguments.  Every `LOG_INFO()` is timed with
+/// logClockNow().  Without a LogConsumer, the producers just lap the ring.
+///
+/// Prints one CSV line per run:
+/// `consumer,producers,args,entries,p50_ns,p99_ns,p999_ns,max_ns,mean_ns,logs_per_sec,dropped`.
+/// The percentiles are over every `LOG_INFO()` from every producer.
+/// `logs_per_sec` is every producer's LogEntry records over the wall time.
+///
+/// @file      benchmarks/bench_log.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>  // For sort() max()
+#include <atomic>     // For atomic<>
+#include <chrono>     // For steady_clock
+#include <cstdint>    // For uint64_t
+#include <cstdio>     // For printf() fprintf()
+#include <cstdlib>    // For strtoull()
+#include <memory>     // For make_unique<>()
+#include <numeric>    // For accumulate()
+#include <span>       // For span<>
+#include <thread>     // For thread
+#include <vector>     // For vector<>
+
+#include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "bench_log" };
+
+/// Logs at and above `MIN_LOG_SEVERITY` will be available.  Logs below
+/// `MIN_LOG_SEVERITY` will not be compiled into the source file.
+#define MIN_LOG_SEVERITY LOG_SEVERITY_INFO
+
+#include "../src/lib/Log.hpp"
+#include "../src/lib/LogClock.hpp"  // For calibrateLogClock() logClockNow() logNsPerTick()
+#include "../src/lib/LogConsumer.hpp"
+
+using namespace empire;
+using namespace std;
+
+
+/// Throw the LogEntry records away
+class LogSinkNull : public LogSink {
+public:
+   void write( const span< const LogEntry > /* entries */ ) override {}
+};
+
+
+/// Log one LogEntry with `Args` arguments
+///
+/// @tparam Args 0, 1, 3 or 6
+/// @param t The producer
+/// @param n The LogEntry number
+template< int Args >
+void logWith( const size_t t, const size_t n ) {
+   if constexpr( Args == 0 ) {
+      LOG_INFO( "A log entry with no arguments" );
+   } else if constexpr( Args == 1 ) {
+      LOG_INFO( "Entry %zu", n );
+   } else if constexpr( Args == 3 ) {
+      LOG_INFO( "Producer %zu entry %zu of %.2f", t, n, 1.5 );
+   } else {
+      LOG_INFO( "Producer %zu entry %zu x=%d y=%d name=%s value=%.3f", t, n, 17, -4, "sector", 2.25 );
+   }
+}
+
+
+/// Time `producers` threads that each log `entries` LogEntry records with
+/// `Args` arguments and print a CSV line
+///
+/// @tparam Args The number of arguments in each LogEntry
+/// @param consumer The running LogConsumer (or `nullptr`)
+/// @param producers The number of producer threads
+/// @param entries The number of LogEntry records each producer writes
+template< int Args >
+void bench( const LogConsumer* consumer, const size_t producers, const size_t entries ) {
+   if( consumer != nullptr ) {
+      consumer->sync();
+   }
+   const size_t dropped = ( consumer != nullptr ) ? consumer->getDroppedCount() : 0;
+
+   /// Each producer's latencies in logClockNow() ticks
+   vector< vector< uint64_t > > ticks( producers, vector< uint64_t >( entries ) );
+
+   atomic< size_t > ready { 0 };
+   atomic< bool > go { false };
+
+   vector< thread > threads;
+   for( size_t t = 0 ; t < producers ; t++ ) {
+      threads.emplace_back( [ t, entries, &ready, &go, &samples = ticks[ t ] ]() {
+         logWith< Args >( t, 0 );  // Warm up
+         ready.fetch_add( 1 );
+         while( !go.load() ) {
+            this_thread::yield();
+         }
+
+         for( size_t n = 0 ; n < entries ; n++ ) {
+            const uint64_t before = logClockNow();
+            logWith< Args >( t, n );
+            samples[ n ] = logClockNow() - before;
+         }
+      } );
+   }
+
+   while( ready.load() < producers ) {
+      this_thread::yield();
+   }
+
+   const auto start = chrono::steady_clock::now();
+   go.store( true );
+   for( thread& producer : threads ) {
+      producer.join();
+   }
+   const auto stop = chrono::steady_clock::now();
+
+   if( consumer != nullptr ) {
+      consumer->sync();
+   }
+
+   vector< uint64_t > all;
+   all.reserve( producers * entries );
+   for( const vector< uint64_t >& samples : ticks ) {
+      all.insert( all.end(), samples.begin(), samples.end() );
+   }
+   sort( all.begin(), all.end() );
+
+   const double nsPerTick = logNsPerTick();
+   /// @return The `fraction` percentile in nanoseconds
+   auto percentile = [ & ]( const double fraction ) {
+      const auto index = static_cast< size_t >( fraction * static_cast< double >( all.size() - 1 ) );
+      return static_cast< double >( all[ index ] ) * nsPerTick;
+   };
+
+   const auto wallNs = static_cast< double >( chrono::duration_cast< chrono::nanoseconds >( stop - start ).count() );
+   const double logs = static_cast< double >( all.size() );
+
+   // @NOLINTBEGIN( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The percentiles and ns per second
+   printf( "%s,%zu,%d,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f,%zu\n"
+          ,consumer != nullptr ? "yes" : "no"
+          ,producers
+          ,Args
+          ,entries
+          ,percentile( 0.50 )
+          ,percentile( 0.99 )
+          ,percentile( 0.999 )
+          ,static_cast< double >( all.back() ) * nsPerTick
+          ,static_cast< double >( accumulate( all.begin(), all.end(), uint64_t { 0 } ) ) * nsPerTick / logs
+          ,logs * 1e9 / wallNs
+          ,( consumer != nullptr ) ? consumer->getDroppedCount() - dropped : 0 );
+   // @NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+   fflush( stdout );
+}
+
+
+/// Run every producer count and argument count
+///
+/// @param consumer The running LogConsumer (or `nullptr`)
+/// @param maxProducers The most producer threads
+/// @param entries The number of LogEntry records per producer
+void benchAll( const LogConsumer* consumer, const size_t maxProducers, const size_t entries ) {
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t producers = 1 ; producers <= maxProducers ; producers *= 2 ) {
+      bench< 0 >( consumer, producers, entries );
+      bench< 1 >( consumer, producers, entries );
+      bench< 3 >( consumer, producers, entries );  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The argument counts we compare
+      bench< 6 >( consumer, producers, entries );  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The argument counts we compare
+   }
+}
+
+
+/// Run the benchmarks without and then with a LogConsumer
+///
+/// @param argc The number of arguments
+/// @param argv `argv[1]` is the number of LogEntry records per producer
+///             (default 100,000).  `argv[2]` is the most producer threads
+///             (default: the number of cores).
+/// @return 0, or 1 if an argument is 0 or not a number
+int main( int argc, char* argv[] ) {
+   // @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Command line parsing
+   const size_t entries = ( argc > 1 ) ? strtoull( argv[ 1 ], nullptr, 10 ) : 100'000;
+   const size_t maxProducers = ( argc > 2 ) ? strtoull( argv[ 2 ], nullptr, 10 ) : max( thread::hardware_concurrency(), 1U );
+   // @NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+
+   /// With no samples, there are no percentiles
+   if( entries == 0 || maxProducers == 0 ) {
+      fprintf( stderr, "Usage:  bench_log [entries_per_producer] [max_producers]  (both must be at least 1)\n" );
+      return 1;
+   }
+
+   calibrateLogClock();
+
+   printf( "consumer,producers,args,entries,p50_ns,p99_ns,p999_ns,max_ns,mean_ns,logs_per_sec,dropped\n" );
+
+   benchAll( nullptr, maxProducers, entries );
+
+   LogConsumer consumer;
+   consumer.addSink( make_unique< LogSinkNull >() );
+   consumer.restart();
+
+   benchAll( &consumer, maxProducers, entries );
+
+   consumer.stop();
+
+   return 0;
+}
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Compare the shared empire::LogQueue with the per-thread rings
+///
+/// Usage:  `bench_log_rings [entries_per_producer]`
+///
+/// Runs 1, 4, 16 and 64 producer threads in each LogQueueMode while one
+/// LogConsumer drains into a sink that counts the LogEntry records and throws
+/// them away.
+/// Prints one line per run:
+/// `mode,producers,entries,wall_ns,ns_per_log,logs_per_sec,delivered,dropped`.
+/// `ns_per_log` is the average time a producer spends in `LOG_INFO()` and
+/// `logs_per_sec` is every producer's LogEntry records over the wall time.
+/// `delivered` includes the LogEntry records that report drops.
+///
+/// @file      benchmarks/bench_log_rings.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>   // For atomic<>
+#include <chrono>   // For steady_clock
+#include <cstdio>   // For printf()
+#include <cstdlib>  // For strtoull()
+#include <memory>   // For make_unique<>()
+#include <span>     // For span<>
+#include <thread>   // For thread
+#include <vector>   // For vector<>
+
+#include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "bench_log_rings" };
+
+/// Logs at and above `MIN_LOG_SEVERITY` will be available.  Logs below
+/// `MIN_LOG_SEVERITY` will not be compiled into the source file.
+#define MIN_LOG_SEVERITY LOG_SEVERITY_INFO
+
+#include "../src/lib/Log.hpp"
+#include "../src/lib/LogConsumer.hpp"
+
+using namespace empire;
+using namespace std;
+
+
+/// Count the LogEntry records and throw them away
+class LogSinkCount : public LogSink {
+public:
+   void write( const span< const LogEntry > entries ) override {
+      m_count += entries.size();
+   }
+
+   size_t m_count { 0 };  ///< The number of LogEntry records written
+};
+
+
+/// Time `producers` threads that each log `entries` LogEntry records
+///
+/// @param consumer The running LogConsumer
+/// @param sink The LogSinkCount in `consumer`
+/// @param mode The LogQueueMode
+/// @param producers The number of producer threads
+/// @param entries The number of LogEntry records each producer writes
+void bench( const LogConsumer& consumer, const LogSinkCount& sink, const LogQueueMode mode, const size_t producers, const size_t entries ) {
+   setLogQueueMode( mode );
+   consumer.sync();
+
+   const size_t delivered = sink.m_count;
+   const size_t dropped = consumer.getDroppedCount();
+
+   atomic< size_t > ready { 0 };
+   atomic< bool > go { false };
+   atomic< size_t > producerNs { 0 };
+
+   vector< thread > threads;
+   for( size_t t = 0 ; t < producers ; t++ ) {
+      threads.emplace_back( [ t, entries, &ready, &go, &producerNs ]() {
+         LOG_INFO( "Producer %zu is warming up", t );  // Claims this thread's ring
+         ready.fetch_add( 1 );
+         while( !go.load() ) {
+            this_thread::yield();
+         }
+
+         const auto start = chrono::steady_clock::now();
+         for( size_t n = 0 ; n < entries ; n++ ) {
+            LOG_INFO( "Producer %zu entry %zu", t, n );
+         }
+         const auto stop = chrono::steady_clock::now();
+
+         producerNs.fetch_add( static_cast< size_t >( chrono::duration_cast< chrono::nanoseconds >( stop - start ).count() ) );
+      } );
+   }
+
+   while( ready.load() < producers ) {
+      this_thread::yield();
+   }
+
+   const auto start = chrono::steady_clock::now();
+   go.store( true );
+   for( thread& producer : threads ) {
+      producer.join();
+   }
+   const auto stop = chrono::steady_clock::now();
+
+   consumer.sync();
+
+   const auto wallNs = static_cast< unsigned long long >( chrono::duration_cast< chrono::nanoseconds >( stop - start ).count() );
+   const double logs = static_cast< double >( producers * entries );
+
+   printf( "%s,%zu,%zu,%llu,%.1f,%.0f,%zu,%zu\n"
+          ,mode == LogQueueMode::shared ? "shared" : "per_thread"
+          ,producers
+          ,entries
+          ,wallNs
+          ,static_cast< double >( producerNs.load() ) / logs
+          ,logs * 1e9 / static_cast< double >( wallNs )  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): ns per second
+          ,sink.m_count - delivered
+          ,consumer.getDroppedCount() - dropped );
+}
+
+
+/// Run each LogQueueMode with 1, 4, 16 and 64 producers
+///
+/// @param argc The number of arguments
+/// @param argv `argv[1]` is the number of LogEntry records per producer (default 100,000)
+/// @return 0
+int main( int argc, char* argv[] ) {
+   const size_t entries = ( argc > 1 ) ? strtoull( argv[ 1 ], nullptr, 10 ) : 100'000;  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Command line parsing
+
+   LogConsumer consumer;
+   const auto& sink = dynamic_cast< LogSinkCount& >( consumer.addSink( make_unique< LogSinkCount >() ) );
+   consumer.restart();
+
+   printf( "mode,producers,entries,wall_ns,ns_per_log,logs_per_sec,delivered,dropped\n" );
+
+   for( const size_t producers : { 1, 4, 16, 64 } ) {  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The thread counts we compare
+      bench( consumer, sink, LogQueueMode::shared, producers, entries );
+      bench( consumer, sink, LogQueueMode::perThread, producers, entries );
+   }
+
+   consumer.stop();
+
+   return 0;
+}
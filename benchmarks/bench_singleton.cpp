@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Measure the cost of Singleton::get()
+///
+/// Usage:  `bench_singleton [calls]`
+///
+/// Times `calls` calls to Singleton::get() on an instantiated Singleton, with
+/// and without Singleton::validate() (which is what every get() did before and
+/// what a debug build still does), and to StaticSingleton::get().  Then times
+/// constructing and erasing a Singleton with each identity policy.  Build it
+/// in Release.
+///
+/// Prints one CSV line per run:  `method,calls,wall_ns,ns_per_call`.
+///
+/// @file      benchmarks/bench_singleton.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>   // For steady_clock
+#include <cstdio>   // For printf()
+#include <cstdlib>  // For strtoull()
+
+#include "../src/lib/Singleton.hpp"
+#include "../src/lib/StaticSingleton.hpp"
+
+using namespace empire;
+using namespace std;
+
+
+/// A Singleton to get
+///
+/// @tparam Identity Its identity policy
+template< typename Identity >
+class BenchSingleton final : public Singleton< BenchSingleton< Identity >, Identity > {
+public:
+   /// Construct the Singleton
+   explicit BenchSingleton( [[maybe_unused]] typename Singleton< BenchSingleton< Identity >, Identity >::token singletonToken ) {}
+
+   int value { 1 };  ///< Something to read through get()
+};
+
+
+/// The same thing in a StaticSingleton
+class BenchStatic final {
+public:
+   /// Construct it
+   explicit BenchStatic( [[maybe_unused]] StaticSingleton< BenchStatic >::token singletonToken ) {}
+
+   int value { 1 };  ///< Something to read through get()
+};
+
+
+/// Time `calls` calls to `getter` and print a CSV line
+///
+/// @param method The name of the run
+/// @param calls The number of calls
+/// @param getter Returns a BenchSingleton
+template< typename Getter >
+void bench( const char* method, const size_t calls, Getter getter ) {
+   long sum = 0;
+
+   const auto start = chrono::steady_clock::now();
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < calls ; i++ ) {
+      sum += getter().value;
+      asm volatile( "" : "+r"( sum ) );  // Keep the compiler from hoisting get() out of the loop
+   }
+   const auto stop = chrono::steady_clock::now();
+
+   const auto wallNs = static_cast< double >( chrono::duration_cast< chrono::nanoseconds >( stop - start ).count() );
+   printf( "%s,%zu,%.0f,%.3f\n", method, calls, wallNs, wallNs / static_cast< double >( calls ) );
+   fflush( stdout );
+}
+
+
+/// Time constructing and erasing a BenchSingleton `calls` times
+///
+/// @tparam Identity The identity policy
+/// @param method The name of the run
+/// @param calls The number of constructions
+template< typename Identity >
+void benchConstruct( const char* method, const size_t calls ) {
+   bench( method, calls, []() -> BenchSingleton< Identity >& {
+      BenchSingleton< Identity >::erase();
+      return BenchSingleton< Identity >::get();
+   } );
+   BenchSingleton< Identity >::erase();
+}
+
+
+/// Run the benchmarks
+///
+/// @param argc The number of arguments
+/// @param argv `argv[1]` is the number of calls (default 10,000,000)
+/// @return 0
+int main( int argc, char* argv[] ) {
+   // @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Command line parsing
+   const size_t calls = ( argc > 1 ) ? strtoull( argv[ 1 ], nullptr, 10 ) : 10'000'000;
+   // @NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+
+   using Bench = BenchSingleton< SingletonUuidIdentity >;
+   Bench::get();  // Instantiate it
+
+   printf( "method,calls,wall_ns,ns_per_call\n" );
+
+   bench( "get", calls, []() -> Bench& {
+      return Bench::get();
+   } );
+
+   bench( "get+validate", calls, []() -> Bench& {
+      Bench& singleton = Bench::get();
+      Bench::validate();
+      return singleton;
+   } );
+
+   Bench::erase();
+
+   StaticSingleton< BenchStatic >::construct();
+   bench( "static_get", calls, []() -> BenchStatic& {
+      return StaticSingleton< BenchStatic >::get();
+   } );
+   StaticSingleton< BenchStatic >::destroy();
+
+   /// Constructing one allocates it, so there are fewer of them
+   const size_t constructs = calls / 10;  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): A tenth of the calls
+   benchConstruct< SingletonUuidIdentity >( "construct_uuid", constructs );
+   benchConstruct< SingletonGenerationIdentity >( "construct_generation", constructs );
+   benchConstruct< SingletonNoIdentity >( "construct_none", constructs );
+
+   return 0;
+}
@@ -135,6 +135,34 @@ void CommodityTypes::print() {
 }
 
 
+/////////////////////////                            /////////////////////////
+/////////////////////////  Commodity Status Results  /////////////////////////
+/////////////////////////                            /////////////////////////
+
+void throwCommodityResult( const CommodityResult& result, const char name1, const commodityValue maxValue ) {
+   BOOST_ASSERT( result.status != CommodityStatus::ok );
+
+   switch( result.status ) {
+      case CommodityStatus::overflow:
+         throw commodityOverflowException() << errinfo_oldValue( result.oldValue )
+                                            << errinfo_requestedValue( result.requestedValue )
+                                            << errinfo_maxValue( maxValue )
+                                            << errinfo_commodityType( name1 );
+
+      case CommodityStatus::underflow:
+         throw commodityUnderflowException() << errinfo_oldValue( result.oldValue )
+                                             << errinfo_requestedValue( result.requestedValue )
+                                             << errinfo_commodityType( name1 );
+
+      case CommodityStatus::disabled:
+         throw commodityDisabledException();
+
+      default:  // Only when NDEBUG disables the BOOST_ASSERT above
+         throw empireException();
+   }
+}
+
+
 ///////////////////////////                         ///////////////////////////
 ///////////////////////////  Commodity Definitions  ///////////////////////////
 ///////////////////////////                         ///////////////////////////
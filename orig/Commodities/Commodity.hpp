@@ -13,6 +13,8 @@
 /// @version   1.0 - Initial version
 /// @version   1.1 - Combined with CommodityTest to support inlining,
 ///                  constinit and constexpr
+/// @version   1.2 - Added the exception-free tryIncrease(), tryDecrease()
+///                  and tryGetValue()
 ///
 /// @author    Mark Nelson <mr_nelson@icloud.com>
 /// @date      29 Jan 2021
@@ -109,6 +111,54 @@ struct commodityUnderflowException: virtual empireException { };
 struct commodityDisabledException: virtual empireException { };
 
 
+/////////////////////////                            /////////////////////////
+/////////////////////////  Commodity Status Results  /////////////////////////
+/////////////////////////                            /////////////////////////
+
+/// What happened to a Commodity operation that doesn't throw.  Each status
+/// (other than ok) matches one of the Commodity exceptions.
+enum class CommodityStatus : std::uint8_t {
+    ok         ///< The Commodity was updated
+   ,overflow   ///< It went over maxValue and is now maxValue (commodityOverflowException)
+   ,underflow  ///< It went below 0 and is now 0 (commodityUnderflowException)
+   ,disabled   ///< The Commodity is disabled and nothing changed (commodityDisabledException)
+};
+
+
+/// The result of Commodity::tryIncrease(), tryDecrease() and tryGetValue().
+///
+/// It's shaped like C++23's std::expected:  It's true when the status is ok.
+/// On an overflow or underflow, it holds what the exception would have held,
+/// so the caller can report it.
+///
+/// @code
+///    if( !sector.food.tryIncrease( harvest ) ) {
+///       ++starvingSectors;  // ...or whatever the update wants to do
+///    }
+/// @endcode
+struct [[nodiscard]] CommodityResult {
+   CommodityStatus status;          ///< What happened
+   commodityValue  value;           ///< The value of the Commodity afterwards
+   commodityValue  oldValue;        ///< The value of the Commodity before
+   commodityValue  requestedValue;  ///< The value the operation asked for
+
+   /// True if the status is ok.
+   constexpr bool ok() const { return status == CommodityStatus::ok; }
+
+   /// True if the status is ok.
+   constexpr explicit operator bool() const { return ok(); }
+};
+
+
+/// Throw the exception that matches a CommodityResult that's not ok.  This is
+/// how the throwing API reports the results of the exception-free one.
+///
+/// @param result   The result of a failed operation
+/// @param name1    The 1 character mnemonic of the Commodity
+/// @param maxValue The maxValue of the Commodity (for commodityOverflowException)
+[[noreturn]] void throwCommodityResult( const CommodityResult& result, const char name1, const commodityValue maxValue );
+
+
 //////////////////////                                   //////////////////////
 //////////////////////  CommodityType Class Declaration  //////////////////////
 //////////////////////                                   //////////////////////
@@ -343,6 +393,22 @@ public:  ////////////////  Constructor and Operator Overrides  ////////////////
    /// Commodity.
    Commodity& operator -= ( const commodityValue decreaseBy );
 
+
+   /// Add to the Commodity without throwing.  This is += for the update
+   /// engine, where overflows are routine.  If the Commodity exceeds
+   /// maxValue, it's set to maxValue and the result's status is overflow.
+   /// If it's disabled, nothing changes and the status is disabled.
+   ///
+   /// BOOST_ASSERT still checks that increaseBy is in
+   /// [0, MAX_COMMODITY_VALUE].
+   CommodityResult tryIncrease( const commodityValue increaseBy );
+
+
+   /// Subtract from the Commodity without throwing.  If the Commodity goes
+   /// below 0, it's set to 0 and the result's status is underflow.  If it's
+   /// disabled, nothing changes and the status is disabled.
+   CommodityResult tryDecrease( const commodityValue decreaseBy );
+
 private:  /////////////////////////////  Members  /////////////////////////////
 
    /// Holds the type of commodity.  This is the reference into the Flyweight
@@ -385,6 +451,10 @@ public:  /////////////////////////////  Methods  /////////////////////////////
    /// Throw commodityDisabledException if the commodity is disabled.
    const commodityValue getValue() const;
 
+   /// Return the current value of this Commodity without throwing.  The
+   /// status is disabled if the commodity is disabled.
+   CommodityResult tryGetValue() const;
+
     /// Validate the commodity.
    const bool validate() const;
 
@@ -593,10 +663,10 @@ constexpr const std::string_view Commodity::getName32() const {
 }
 
 
-inline Commodity& Commodity::operator += ( const commodityValue increaseBy ) {
+inline CommodityResult Commodity::tryIncrease( const commodityValue increaseBy ) {
 
    if( !isEnabled() ) {
-      throw commodityDisabledException();
+      return { CommodityStatus::disabled, 0, 0, 0 };
    }
 
    // These will bound the size of the increase to a small enough
@@ -604,29 +674,23 @@ inline Commodity& Commodity::operator += ( const commodityValue increaseBy ) {
    BOOST_ASSERT( increaseBy >= 0 );
    BOOST_ASSERT( increaseBy <= MAX_COMMODITY_VALUE );
 
-   commodityValue newValue = value + increaseBy;
+   const commodityValue oldValue = value;
+   const commodityValue newValue = static_cast< commodityValue >( value + increaseBy );
 
-   if( newValue >= 0 && newValue <= maxValue ) {  // Is the new value OK?
+   if( newValue <= maxValue ) {  // Is the new value OK?
       value = newValue;
-      return *this;
-   }
-
-   if( newValue > maxValue ) {  // If we overflow...
-      value = maxValue;         // set value to maxValue and...
-      throw commodityOverflowException() << errinfo_oldValue( value )
-                                         << errinfo_requestedValue( newValue )
-                                         << errinfo_maxValue( maxValue )
-                                         << errinfo_commodityType( commodityType.getName1() );
+      return { CommodityStatus::ok, value, oldValue, newValue };
    }
 
-   return *this;
+   value = maxValue;  // If we overflow, set value to maxValue
+   return { CommodityStatus::overflow, value, oldValue, newValue };
 }
 
 
-inline Commodity& Commodity::operator -= ( const commodityValue decreaseBy ) {
+inline CommodityResult Commodity::tryDecrease( const commodityValue decreaseBy ) {
 
    if( !isEnabled() ) {
-      throw commodityDisabledException();
+      return { CommodityStatus::disabled, 0, 0, 0 };
    }
 
    // These will bound the size of the decrease to a small enough
@@ -634,18 +698,38 @@ inline Commodity& Commodity::operator -= ( const commodityValue decreaseBy ) {
    BOOST_ASSERT( decreaseBy >= 0 );
    BOOST_ASSERT( decreaseBy <= MAX_COMMODITY_VALUE );
 
-   commodityValue newValue = value - decreaseBy;
+   const commodityValue oldValue = value;
+   const commodityValue newValue = static_cast< commodityValue >( value - decreaseBy );
 
-   if( newValue >= 0 && newValue <= maxValue ) {  // Is the new value OK?
+   if( newValue >= 0 ) {  // Is the new value OK?
       value = newValue;
-      return *this;
+      return { CommodityStatus::ok, value, oldValue, newValue };
    }
 
-   if( newValue < 0 ) {               // If we underflow...
-      value = 0;                // set value to 0 and...
-      throw commodityUnderflowException() << errinfo_oldValue( value )
-                                          << errinfo_requestedValue( newValue )
-                                          << errinfo_commodityType( commodityType.getName1() );
+   value = 0;  // If we underflow, set value to 0
+   return { CommodityStatus::underflow, value, oldValue, newValue };
+}
+
+
+/// @internal  The throwing operators are the exception-free ones plus a
+///            throw.  throwCommodityResult() is out of line, so the inlined
+///            path stays small.
+inline Commodity& Commodity::operator += ( const commodityValue increaseBy ) {
+   const CommodityResult result = tryIncrease( increaseBy );
+
+   if( !result ) {
+      throwCommodityResult( result, commodityType.getName1(), maxValue );
+   }
+
+   return *this;
+}
+
+
+inline Commodity& Commodity::operator -= ( const commodityValue decreaseBy ) {
+   const CommodityResult result = tryDecrease( decreaseBy );
+
+   if( !result ) {
+      throwCommodityResult( result, commodityType.getName1(), maxValue );
    }
 
    return *this;
@@ -674,5 +758,14 @@ inline const commodityValue Commodity::getValue() const {
 }
 
 
+inline CommodityResult Commodity::tryGetValue() const {
+   if( !isEnabled() ) {
+      return { CommodityStatus::disabled, 0, 0, 0 };
+   }
+
+   return { CommodityStatus::ok, value, value, value };
+}
+
+
 
 } // namespace empire;
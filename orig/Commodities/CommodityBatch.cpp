@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Add or subtract arrays of deltas to Commodity values in bulk, clamping to
+/// [0, maxValue] and reporting overflows as a count and a bitmask.
+///
+//  The documentation for functions in this file are in the .hpp file.
+///
+/// @file      Commodities/CommodityBatch.cpp
+/// @version   1.0 - Initial version
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CommodityBatch.hpp"
+
+#include <algorithm>      // For fill()
+#include <bit>            // For popcount()
+
+#include <boost/assert.hpp>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+   #include <immintrin.h>  // For the SSE2 and AVX2 intrinsics
+   #define COMMODITY_BATCH_X86
+#endif
+
+using namespace std;
+
+namespace empire {
+
+/////////////////////////                          /////////////////////////
+/////////////////////////  Batch Kernel Internals  /////////////////////////
+/////////////////////////                          /////////////////////////
+
+namespace {
+
+/// The kernels process the arrays in this many elements at a time and pass
+/// the rest to the scalar version.  The mask bits for a block always land
+/// in one word because the block sizes divide 64.
+constexpr size_t AVX2_BLOCK = 16;
+constexpr size_t SSE2_BLOCK = 8;
+
+
+/// Clear the mask (if there is one) before a kernel ORs bits into it.
+void clearMask( const span< uint64_t > mask, const size_t count ) {
+   if( mask.empty() ) {
+      return;
+   }
+
+   BOOST_ASSERT( mask.size() >= ( count + 63 ) / 64 );
+   fill( mask.begin(), mask.end(), 0 );
+}
+
+
+/// Record the overflows for a block of elements starting at `first`.
+///
+/// @return The number of bits in `bits`
+size_t recordBits( const span< uint64_t > mask, const size_t first, const uint64_t bits ) {
+   if( !mask.empty() ) {
+      mask[ first / 64 ] |= bits << ( first % 64 );
+   }
+
+   return static_cast< size_t >( popcount( bits ) );
+}
+
+
+/// The scalar add, starting at `first`.  The mask must already be clear.
+size_t addScalarFrom( const span< commodityValue >       values
+                     ,const span< const commodityValue > maxValues
+                     ,const span< const commodityValue > deltas
+                     ,const span< uint64_t >             mask
+                     ,const size_t                       first ) {
+   size_t overflows = 0;
+
+   for( size_t i = first ; i < values.size() ; i++ ) {
+      const int sum = values[ i ] + deltas[ i ];
+      if( sum > maxValues[ i ] ) {
+         values[ i ] = maxValues[ i ];
+         overflows += recordBits( mask, i, 1 );
+      } else {
+         values[ i ] = static_cast< commodityValue >( sum );
+      }
+   }
+
+   return overflows;
+}
+
+
+/// The scalar subtract, starting at `first`.  The mask must already be clear.
+size_t subtractScalarFrom( const span< commodityValue >       values
+                          ,const span< const commodityValue > deltas
+                          ,const span< uint64_t >             mask
+                          ,const size_t                       first ) {
+   size_t underflows = 0;
+
+   for( size_t i = first ; i < values.size() ; i++ ) {
+      const int difference = values[ i ] - deltas[ i ];
+      if( difference < 0 ) {
+         values[ i ] = 0;
+         underflows += recordBits( mask, i, 1 );
+      } else {
+         values[ i ] = static_cast< commodityValue >( difference );
+      }
+   }
+
+   return underflows;
+}
+
+
+#ifdef COMMODITY_BATCH_X86
+
+/// The AVX2 add:  16 values at a time.
+__attribute__(( target( "avx2" ) ))
+size_t addAvx2( const span< commodityValue >       values
+               ,const span< const commodityValue > maxValues
+               ,const span< const commodityValue > deltas
+               ,const span< uint64_t >             mask ) {
+   size_t overflows = 0;
+   size_t i = 0;
+
+   for( ; i + AVX2_BLOCK <= values.size() ; i += AVX2_BLOCK ) {
+      const __m256i value = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( &values[ i ] ) );
+      const __m256i limit = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( &maxValues[ i ] ) );
+      const __m256i delta = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( &deltas[ i ] ) );
+
+      const __m256i sum  = _mm256_adds_epi16( value, delta );
+      const __m256i over = _mm256_cmpgt_epi16( sum, limit );
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( &values[ i ] ), _mm256_min_epi16( sum, limit ) );
+
+      // Pack the 16 lanes of 0 or -1 into 16 bytes so movemask gives 1 bit each
+      const __m128i packed = _mm_packs_epi16( _mm256_castsi256_si128( over ), _mm256_extracti128_si256( over, 1 ) );
+      overflows += recordBits( mask, i, static_cast< uint32_t >( _mm_movemask_epi8( packed ) ) );
+   }
+
+   return overflows + addScalarFrom( values, maxValues, deltas, mask, i );
+}
+
+
+/// The AVX2 subtract:  16 values at a time.
+__attribute__(( target( "avx2" ) ))
+size_t subtractAvx2( const span< commodityValue >       values
+                    ,const span< const commodityValue > deltas
+                    ,const span< uint64_t >             mask ) {
+   size_t underflows = 0;
+   size_t i = 0;
+   const __m256i zero = _mm256_setzero_si256();
+
+   for( ; i + AVX2_BLOCK <= values.size() ; i += AVX2_BLOCK ) {
+      const __m256i value = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( &values[ i ] ) );
+      const __m256i delta = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( &deltas[ i ] ) );
+
+      const __m256i difference = _mm256_subs_epi16( value, delta );
+      const __m256i under      = _mm256_cmpgt_epi16( zero, difference );
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( &values[ i ] ), _mm256_max_epi16( difference, zero ) );
+
+      const __m128i packed = _mm_packs_epi16( _mm256_castsi256_si128( under ), _mm256_extracti128_si256( under, 1 ) );
+      underflows += recordBits( mask, i, static_cast< uint32_t >( _mm_movemask_epi8( packed ) ) );
+   }
+
+   return underflows + subtractScalarFrom( values, deltas, mask, i );
+}
+
+
+/// The SSE2 add:  8 values at a time.
+size_t addSse2( const span< commodityValue >       values
+               ,const span< const commodityValue > maxValues
+               ,const span< const commodityValue > deltas
+               ,const span< uint64_t >             mask ) {
+   size_t overflows = 0;
+   size_t i = 0;
+   const __m128i zero = _mm_setzero_si128();
+
+   for( ; i + SSE2_BLOCK <= values.size() ; i += SSE2_BLOCK ) {
+      const __m128i value = _mm_loadu_si128( reinterpret_cast< const __m128i* >( &values[ i ] ) );
+      const __m128i limit = _mm_loadu_si128( reinterpret_cast< const __m128i* >( &maxValues[ i ] ) );
+      const __m128i delta = _mm_loadu_si128( reinterpret_cast< const __m128i* >( &deltas[ i ] ) );
+
+      const __m128i sum  = _mm_adds_epi16( value, delta );
+      const __m128i over = _mm_cmpgt_epi16( sum, limit );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( &values[ i ] ), _mm_min_epi16( sum, limit ) );
+
+      overflows += recordBits( mask, i, static_cast< uint32_t >( _mm_movemask_epi8( _mm_packs_epi16( over, zero ) ) ) );
+   }
+
+   return overflows + addScalarFrom( values, maxValues, deltas, mask, i );
+}
+
+
+/// The SSE2 subtract:  8 values at a time.
+size_t subtractSse2( const span< commodityValue >       values
+                    ,const span< const commodityValue > deltas
+                    ,const span< uint64_t >             mask ) {
+   size_t underflows = 0;
+   size_t i = 0;
+   const __m128i zero = _mm_setzero_si128();
+
+   for( ; i + SSE2_BLOCK <= values.size() ; i += SSE2_BLOCK ) {
+      const __m128i value = _mm_loadu_si128( reinterpret_cast< const __m128i* >( &values[ i ] ) );
+      const __m128i delta = _mm_loadu_si128( reinterpret_cast< const __m128i* >( &deltas[ i ] ) );
+
+      const __m128i difference = _mm_subs_epi16( value, delta );
+      const __m128i under      = _mm_cmpgt_epi16( zero, difference );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( &values[ i ] ), _mm_max_epi16( difference, zero ) );
+
+      underflows += recordBits( mask, i, static_cast< uint32_t >( _mm_movemask_epi8( _mm_packs_epi16( under, zero ) ) ) );
+   }
+
+   return underflows + subtractScalarFrom( values, deltas, mask, i );
+}
+
+#endif  // COMMODITY_BATCH_X86
+
+
+/// Which kernel to use on this CPU.
+enum class BatchKernel { scalar, sse2, avx2 };
+
+
+/// Pick the kernel once.
+BatchKernel pickKernel() {
+   #ifdef COMMODITY_BATCH_X86
+      if( __builtin_cpu_supports( "avx2" ) ) {
+         return BatchKernel::avx2;
+      }
+      if( __builtin_cpu_supports( "sse2" ) ) {
+         return BatchKernel::sse2;
+      }
+   #endif
+
+   return BatchKernel::scalar;
+}
+
+
+/// The kernel for this CPU.
+const BatchKernel kernel = pickKernel();
+
+}  // namespace
+
+
+////////////////////////                              ////////////////////////
+////////////////////////  Batch Function Definitions  ////////////////////////
+////////////////////////                              ////////////////////////
+
+size_t commodityBatchAddScalar( const span< commodityValue >       values
+                               ,const span< const commodityValue > maxValues
+                               ,const span< const commodityValue > deltas
+                               ,const span< uint64_t >             overflowMask ) {
+   BOOST_ASSERT( maxValues.size() == values.size() );
+   BOOST_ASSERT( deltas.size()    == values.size() );
+
+   clearMask( overflowMask, values.size() );
+   return addScalarFrom( values, maxValues, deltas, overflowMask, 0 );
+}
+
+
+size_t commodityBatchSubtractScalar( const span< commodityValue >       values
+                                    ,const span< const commodityValue > deltas
+                                    ,const span< uint64_t >             underflowMask ) {
+   BOOST_ASSERT( deltas.size() == values.size() );
+
+   clearMask( underflowMask, values.size() );
+   return subtractScalarFrom( values, deltas, underflowMask, 0 );
+}
+
+
+size_t commodityBatchAdd( const span< commodityValue >       values
+                         ,const span< const commodityValue > maxValues
+                         ,const span< const commodityValue > deltas
+                         ,const span< uint64_t >             overflowMask ) {
+   BOOST_ASSERT( maxValues.size() == values.size() );
+   BOOST_ASSERT( deltas.size()    == values.size() );
+
+   clearMask( overflowMask, values.size() );
+
+   #ifdef COMMODITY_BATCH_X86
+      if( kernel == BatchKernel::avx2 ) {
+         return addAvx2( values, maxValues, deltas, overflowMask );
+      }
+      if( kernel == BatchKernel::sse2 ) {
+         return addSse2( values, maxValues, deltas, overflowMask );
+      }
+   #endif
+
+   return addScalarFrom( values, maxValues, deltas, overflowMask, 0 );
+}
+
+
+size_t commodityBatchSubtract( const span< commodityValue >       values
+                              ,const span< const commodityValue > deltas
+                              ,const span< uint64_t >             underflowMask ) {
+   BOOST_ASSERT( deltas.size() == values.size() );
+
+   clearMask( underflowMask, values.size() );
+
+   #ifdef COMMODITY_BATCH_X86
+      if( kernel == BatchKernel::avx2 ) {
+         return subtractAvx2( values, deltas, underflowMask );
+      }
+      if( kernel == BatchKernel::sse2 ) {
+         return subtractSse2( values, deltas, underflowMask );
+      }
+   #endif
+
+   return subtractScalarFrom( values, deltas, underflowMask, 0 );
+}
+
+
+string_view commodityBatchKernel() {
+   switch( kernel ) {
+      case BatchKernel::avx2:  return "avx2";
+      case BatchKernel::sse2:  return "sse2";
+      default:                 return "scalar";
+   }
+}
+
+}  // namespace empire
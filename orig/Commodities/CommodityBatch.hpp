@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Add or subtract arrays of deltas to Commodity values in bulk, clamping to
+/// [0, maxValue] and reporting overflows as a count and a bitmask.
+///
+/// @internal  Production, eating and distribution all reduce to clamped adds
+///            over every sector.  Commodity::operator+= throws on every
+///            overflow, which rules out batches.  These kernels clamp with
+///            saturating `int16_t` SIMD (AVX2 or SSE2, picked at runtime)
+///            and never throw.  A scalar version handles the tails, other
+///            CPUs and the unit tests.
+///
+/// @file      Commodities/CommodityBatch.hpp
+/// @version   1.0 - Initial version
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint64_t
+#include <span>           // For the arrays
+#include <string_view>
+
+#include "Commodity.hpp"
+
+namespace empire {
+
+/// Add `deltas[i]` to `values[i]` and clamp it to [0, `maxValues[i]`].
+///
+/// This is Commodity::operator+= for a whole column without the exceptions:
+/// A value that would go over its maxValue is set to maxValue and counted.
+/// A disabled Commodity (maxValue 0) stays at 0, so a positive delta counts
+/// as an overflow.
+///
+/// The arrays must be the same size.  Each delta must be in
+/// [0, MAX_COMMODITY_VALUE] and each value in [0, maxValue].
+///
+/// @param values       The values to change (a CommodityStore column)
+/// @param maxValues    The maxValue of each value
+/// @param deltas       How much to add to each value
+/// @param overflowMask If it's not empty, bit `i % 64` of word `i / 64` is
+///                     set if value `i` overflowed.  It needs at least
+///                     `(values.size() + 63) / 64` words.
+/// @return The number of values that overflowed
+std::size_t commodityBatchAdd( std::span< commodityValue >       values
+                              ,std::span< const commodityValue > maxValues
+                              ,std::span< const commodityValue > deltas
+                              ,std::span< std::uint64_t >        overflowMask = {} );
+
+
+/// Subtract `deltas[i]` from `values[i]` and clamp it to 0.
+///
+/// This is Commodity::operator-= for a whole column without the exceptions:
+/// A value that would go below 0 is set to 0 and counted.
+///
+/// The arrays must be the same size.  Each delta must be in
+/// [0, MAX_COMMODITY_VALUE] and each value in [0, MAX_COMMODITY_VALUE].
+///
+/// @param values        The values to change (a CommodityStore column)
+/// @param deltas        How much to subtract from each value
+/// @param underflowMask Like commodityBatchAdd()'s `overflowMask`
+/// @return The number of values that underflowed
+std::size_t commodityBatchSubtract( std::span< commodityValue >       values
+                                   ,std::span< const commodityValue > deltas
+                                   ,std::span< std::uint64_t >        underflowMask = {} );
+
+
+/// The plain C++ version of commodityBatchAdd().  It's the fallback and the
+/// reference for the SIMD kernels.
+std::size_t commodityBatchAddScalar( std::span< commodityValue >       values
+                                    ,std::span< const commodityValue > maxValues
+                                    ,std::span< const commodityValue > deltas
+                                    ,std::span< std::uint64_t >        overflowMask = {} );
+
+
+/// The plain C++ version of commodityBatchSubtract().
+std::size_t commodityBatchSubtractScalar( std::span< commodityValue >       values
+                                         ,std::span< const commodityValue > deltas
+                                         ,std::span< std::uint64_t >        underflowMask = {} );
+
+
+/// Return the kernel commodityBatchAdd() and commodityBatchSubtract() use on
+/// this CPU:  `avx2`, `sse2` or `scalar`.
+std::string_view commodityBatchKernel();
+
+} // namespace empire
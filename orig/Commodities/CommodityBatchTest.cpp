@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Test class for CommodityBatch.cpp
+///
+/// @file      Commodities/CommodityBatchTest.cpp
+/// @version   1.0
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// The name of this test module is Empire_Server
+#define BOOST_TEST_MODULE Empire_Server
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/execution_monitor.hpp>
+
+#include <random>
+#include <vector>
+
+#include "../lib/EmpireExceptions.hpp"
+#include "CommodityBatch.hpp"
+#include "CommodityStore.hpp"
+
+
+using namespace std;
+using namespace empire;
+
+
+/// @internal  Name the test suite after the directory that it's in.  Also,
+/// the name should not conflict with other objects in the test suite.
+BOOST_AUTO_TEST_SUITE( CommodityBatch_test_suite )
+
+
+/// Test the clamping, the count and the mask on a small batch
+BOOST_AUTO_TEST_CASE( CommodityBatch_basics ) {
+   BOOST_TEST_MESSAGE( "Using the " << commodityBatchKernel() << " kernel" );
+
+   // 20 values:  One AVX2 block (or two SSE2 blocks) and a scalar tail
+   vector< commodityValue > values    = { 0, 10, 999, 500,   0, 1000, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 990, 0, 1 };
+   vector< commodityValue > maxValues = { 0, 20, 999, 1000, 50, 1000, 5, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 999, 0, 1 };
+   vector< commodityValue > deltas    = { 1, 10,   1, 1000, 50,    0, 0, 4, 5, 4, 4, 4, 4, 4, 4, 4, 4,  10, 0, 1 };
+   vector< uint64_t >       mask( 1, ~uint64_t { 0 } );  // It gets cleared
+
+   BOOST_CHECK( commodityBatchAdd( values, maxValues, deltas, mask ) == 6 );
+   BOOST_CHECK( values[ 0 ]  == 0 );     // Disabled, so it's an overflow
+   BOOST_CHECK( values[ 1 ]  == 20 );    // Exactly maxValue is not
+   BOOST_CHECK( values[ 2 ]  == 999 );
+   BOOST_CHECK( values[ 3 ]  == 1000 );
+   BOOST_CHECK( values[ 4 ]  == 50 );
+   BOOST_CHECK( values[ 8 ]  == 9 );
+   BOOST_CHECK( values[ 17 ] == 999 );
+   BOOST_CHECK( values[ 19 ] == 1 );
+   BOOST_CHECK( mask[ 0 ] == ( ( 1U << 0 ) | ( 1U << 2 ) | ( 1U << 3 ) | ( 1U << 8 ) | ( 1U << 17 ) | ( 1U << 19 ) ) );
+
+   deltas = { 0, 21, 998, 999, 50, 1000, 6, 9, 10, 0, 0, 0, 0, 0, 0, 0, 0, 1000, 0, 0 };
+   BOOST_CHECK( commodityBatchSubtract( values, deltas, mask ) == 4 );
+   BOOST_CHECK( values[ 1 ]  == 0 );
+   BOOST_CHECK( values[ 2 ]  == 1 );
+   BOOST_CHECK( values[ 3 ]  == 1 );
+   BOOST_CHECK( values[ 4 ]  == 0 );
+   BOOST_CHECK( values[ 5 ]  == 0 );
+   BOOST_CHECK( values[ 8 ]  == 0 );
+   BOOST_CHECK( values[ 9 ]  == 9 );
+   BOOST_CHECK( mask[ 0 ] == ( ( 1U << 1 ) | ( 1U << 6 ) | ( 1U << 8 ) | ( 1U << 17 ) ) );
+
+   // The mask is optional
+   BOOST_CHECK( commodityBatchAdd( values, maxValues, vector< commodityValue >( values.size() ) ) == 0 );
+
+   // Empty batches are fine
+   BOOST_CHECK( commodityBatchAdd( {}, {}, {} ) == 0 );
+
+   // The sizes must match
+   BOOST_CHECK_THROW( commodityBatchAdd( values, maxValues, span( deltas ).first( 3 ) ), assertionException );
+   BOOST_CHECK_THROW( commodityBatchSubtract( values, span( deltas ).first( 3 ) ), assertionException );
+
+   // The mask must have room for every value
+   vector< commodityValue > many( 65 );
+   BOOST_CHECK_THROW( commodityBatchSubtract( many, many, mask ), assertionException );
+}
+
+
+/// Test the SIMD kernels against the scalar version over many sizes, so
+/// every block boundary and tail length is covered
+BOOST_AUTO_TEST_CASE( CommodityBatch_matches_scalar ) {
+   mt19937 rng( 1 );
+   uniform_int_distribution< int > limit( 0, MAX_COMMODITY_VALUE );
+   uniform_int_distribution< int > delta( 0, MAX_COMMODITY_VALUE / 4 );
+
+   for( size_t size = 0 ; size < 300 ; size++ ) {
+      vector< commodityValue > maxValues( size );
+      vector< commodityValue > values( size );
+      vector< commodityValue > deltas( size );
+      for( size_t i = 0 ; i < size ; i++ ) {
+         maxValues[ i ] = static_cast< commodityValue >( limit( rng ) );
+         values[ i ]    = static_cast< commodityValue >( uniform_int_distribution< int >( 0, maxValues[ i ] )( rng ) );
+         deltas[ i ]    = static_cast< commodityValue >( delta( rng ) );
+      }
+
+      vector< commodityValue > expected = values;
+      vector< uint64_t >       expectedMask( ( size + 63 ) / 64 );
+      vector< uint64_t >       mask( ( size + 63 ) / 64 );
+
+      const size_t expectedOverflows = commodityBatchAddScalar( expected, maxValues, deltas, expectedMask );
+      BOOST_CHECK( commodityBatchAdd( values, maxValues, deltas, mask ) == expectedOverflows );
+      BOOST_CHECK( values == expected );
+      BOOST_CHECK( mask   == expectedMask );
+
+      const size_t expectedUnderflows = commodityBatchSubtractScalar( expected, deltas, expectedMask );
+      BOOST_CHECK( commodityBatchSubtract( values, deltas, mask ) == expectedUnderflows );
+      BOOST_CHECK( values == expected );
+      BOOST_CHECK( mask   == expectedMask );
+   }
+}
+
+
+/// Test CommodityStore's increaseAll() and decreaseAll()
+BOOST_AUTO_TEST_CASE( CommodityBatch_store ) {
+   const commodityLimits sectorLimits = { 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 0 };
+   const commodityLimits shipLimits   = { 100, 50, 0, 0, 0, 0, 0, 0, 200, 0, 0, 0, 0, 0 };
+
+   CommodityStore store;
+   for( size_t i = 0 ; i < 100 ; i++ ) {
+      store.addEntity( ( i % 2 == 0 ) ? sectorLimits : shipLimits );
+   }
+
+   const vector< commodityValue > harvest( store.size(), 150 );
+   vector< uint64_t > overflows( 2 );
+   BOOST_CHECK( store.increaseAll( FOOD, harvest ) == 0 );
+   BOOST_CHECK( store.getValue( 0, FOOD ) == 150 );
+   BOOST_CHECK( store.getValue( 1, FOOD ) == 150 );
+   BOOST_CHECK( store.increaseAll( FOOD, harvest, overflows ) == 50 );  // The ships
+   BOOST_CHECK( overflows[ 0 ] == 0xAAAA'AAAA'AAAA'AAAA );
+   BOOST_CHECK( overflows[ 1 ] == 0x0000'000A'AAAA'AAAA );
+   BOOST_CHECK( store.getValue( 0, FOOD ) == 300 );
+   BOOST_CHECK( store.getValue( 1, FOOD ) == 200 );
+
+   const vector< commodityValue > eat( store.size(), 250 );
+   BOOST_CHECK( store.decreaseAll( FOOD, eat ) == 50 );
+   BOOST_CHECK( store.getValue( 0, FOOD ) == 50 );
+   BOOST_CHECK( store.getValue( 1, FOOD ) == 0 );
+
+   BOOST_CHECK( store.increaseAll( RAD, harvest ) == 100 );  // Nobody holds RAD
+   BOOST_CHECK_NO_THROW( store.validate() );
+
+   BOOST_CHECK_THROW( store.increaseAll( FOOD, span( harvest ).first( 3 ) ), assertionException );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Compare the throwing Commodity API (+=) with the exception-free one
+/// (tryIncrease()) at several overflow rates.
+///
+/// Usage:  `CommodityBench [passes]`
+///
+/// Each pass adds to every sector's food in a 184x88 world.  A given
+/// fraction of the adds overflow.  The += loop catches each
+/// commodityOverflowException, the way an update would have to.
+///
+/// Prints one CSV line per run:  `path,overflow_pct,ops,ns_per_op,overflows`
+///
+/// @file      Commodities/CommodityBench.cpp
+/// @version   1.0 - Initial version
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>         // For steady_clock
+#include <cstdio>         // For printf()
+#include <cstdlib>        // For strtoul()
+#include <random>         // For mt19937
+#include <string_view>
+#include <vector>
+
+#include "Commodity.hpp"
+
+using namespace std;
+using namespace empire;
+
+
+/// The number of sectors in the world
+constinit const size_t SECTORS = 184 * 88;
+
+/// Every sector starts each pass with this much food...
+constinit const commodityValue START_FOOD = 500;
+
+/// ...and can hold this much
+constinit const commodityValue MAX_FOOD = 999;
+
+
+/// Time `passes` passes of adding `deltas` to `world` with += or tryIncrease()
+/// and print a CSV line
+///
+/// @param path         `throw` or `status`
+/// @param overflowRate The fraction of the adds that overflow
+/// @param world        The sectors' food
+/// @param deltas       What to add to each sector
+/// @param passes       The number of passes
+void bench( const string_view path
+           ,const double overflowRate
+           ,vector< Commodity >& world
+           ,const vector< commodityValue >& deltas
+           ,const unsigned passes ) {
+   chrono::nanoseconds elapsed { 0 };
+   size_t overflows = 0;
+
+   for( unsigned pass = 0 ; pass < passes ; pass++ ) {
+      // Put the world back where it started (not timed)
+      for( Commodity& food : world ) {
+         (void) food.tryDecrease( static_cast< commodityValue >( food.getValue() - START_FOOD ) );
+      }
+
+      const auto start = chrono::steady_clock::now();
+
+      if( path == "throw" ) {
+         for( size_t i = 0 ; i < SECTORS ; i++ ) {
+            try {
+               world[ i ] += deltas[ i ];
+            }
+            catch( const commodityOverflowException& ) {
+               overflows++;
+            }
+         }
+      } else {
+         for( size_t i = 0 ; i < SECTORS ; i++ ) {
+            if( !world[ i ].tryIncrease( deltas[ i ] ) ) {
+               overflows++;
+            }
+         }
+      }
+
+      elapsed += chrono::steady_clock::now() - start;
+   }
+
+   const double ops = static_cast< double >( SECTORS ) * passes;
+   printf( "%.*s,%.1f,%.0f,%.2f,%zu\n"
+          ,static_cast< int >( path.size() ), path.data()
+          ,overflowRate * 100
+          ,ops
+          ,static_cast< double >( elapsed.count() ) / ops
+          ,overflows );
+   fflush( stdout );
+}
+
+
+/// Run both paths at each overflow rate
+///
+/// @param argc The number of arguments
+/// @param argv `argv[1]` is the number of passes (default 200)
+/// @return 0
+int main( int argc, char* argv[] ) {
+   const unsigned passes = ( argc > 1 ) ? static_cast< unsigned >( strtoul( argv[ 1 ], nullptr, 10 ) ) : 200;
+
+   vector< Commodity > world;
+   world.reserve( SECTORS );
+   for( size_t i = 0 ; i < SECTORS ; i++ ) {
+      world.emplace_back( FOOD, MAX_FOOD );
+      world.back() += START_FOOD;
+   }
+
+   printf( "path,overflow_pct,ops,ns_per_op,overflows\n" );
+
+   mt19937 rng( 1 );
+   for( const double overflowRate : { 0.0, 0.001, 0.01, 0.1, 0.5 } ) {
+      // 100 always fits.  600 always overflows.
+      bernoulli_distribution overflow( overflowRate );
+      vector< commodityValue > deltas( SECTORS );
+      for( commodityValue& delta : deltas ) {
+         delta = overflow( rng ) ? 600 : 100;
+      }
+
+      bench( "throw",  overflowRate, world, deltas, passes );
+      bench( "status", overflowRate, world, deltas, passes );
+   }
+
+   return 0;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Holds the Commodities of every entity (sectors, ships, land units...) as a
+/// structure of arrays:  One contiguous column per CommodityEnum.
+///
+//  The documentation for classes in this file are in the .hpp file.
+///
+/// @file      Commodities/CommodityStore.cpp
+/// @version   1.0 - Initial version
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CommodityStore.hpp"
+#include "CommodityBatch.hpp"
+
+#include <boost/assert.hpp>
+
+using namespace std;
+
+namespace empire {
+
+////////////////////////                              ////////////////////////
+////////////////////////  CommodityStore Definitions  ////////////////////////
+////////////////////////                              ////////////////////////
+
+CommodityStore::CommodityStore( const size_t inReserve ) {
+   for( size_t commodity = 0 ; commodity < COMMODITY_COUNT ; commodity++ ) {
+      values[ commodity ].reserve( inReserve );
+      maxValues[ commodity ].reserve( inReserve );
+   }
+}
+
+
+entityIndex CommodityStore::addEntity( const commodityLimits& inMaxValues ) {
+   for( size_t commodity = 0 ; commodity < COMMODITY_COUNT ; commodity++ ) {
+      BOOST_ASSERT( inMaxValues[ commodity ] >= 0 );
+      BOOST_ASSERT( inMaxValues[ commodity ] <= MAX_COMMODITY_VALUE );
+   }
+
+   for( size_t commodity = 0 ; commodity < COMMODITY_COUNT ; commodity++ ) {
+      values[ commodity ].push_back( 0 );
+      maxValues[ commodity ].push_back( inMaxValues[ commodity ] );
+   }
+
+   return static_cast< entityIndex >( entityCount++ );
+}
+
+
+size_t CommodityStore::increaseAll( const CommodityEnum commodity
+                                   ,const span< const commodityValue > increaseBy
+                                   ,const span< uint64_t > overflowMask ) {
+   BOOST_ASSERT( increaseBy.size() == entityCount );
+
+   return commodityBatchAdd( values[ commodity ], maxValues[ commodity ], increaseBy, overflowMask );
+}
+
+
+size_t CommodityStore::decreaseAll( const CommodityEnum commodity
+                                   ,const span< const commodityValue > decreaseBy
+                                   ,const span< uint64_t > underflowMask ) {
+   BOOST_ASSERT( decreaseBy.size() == entityCount );
+
+   return commodityBatchSubtract( values[ commodity ], decreaseBy, underflowMask );
+}
+
+
+/// @internal  It's OK to directly access member values here as we are
+///            validating the data structure.
+bool CommodityStore::validate() const {
+   for( size_t commodity = 0 ; commodity < COMMODITY_COUNT ; commodity++ ) {
+      BOOST_ASSERT( values[ commodity ].size()    == entityCount );
+      BOOST_ASSERT( maxValues[ commodity ].size() == entityCount );
+
+      for( size_t entity = 0 ; entity < entityCount ; entity++ ) {
+         BOOST_ASSERT( maxValues[ commodity ][ entity ] >= 0 );
+         BOOST_ASSERT( maxValues[ commodity ][ entity ] <= MAX_COMMODITY_VALUE );
+         BOOST_ASSERT( values[ commodity ][ entity ] >= 0 );
+         BOOST_ASSERT( values[ commodity ][ entity ] <= maxValues[ commodity ][ entity ] );
+      }
+
+      getType( static_cast< CommodityEnum >( commodity ) ).validate();
+   }
+
+   return true;  // All tests pass
+}
+
+}  // namespace empire
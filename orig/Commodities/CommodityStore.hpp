@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Holds the Commodities of every entity (sectors, ships, land units...) as a
+/// structure of arrays:  One contiguous column per CommodityEnum.
+///
+/// @internal  A BaseEntity with 14 Commodity members is 14 small objects,
+///            each with its own CommodityType reference, spread out over
+///            memory.  The update engine wants the opposite:  All of the food
+///            in the world in one array, all of the civs in another, so a
+///            pass over a 184x88 world is a linear, vectorizable sweep.
+///
+/// @file      Commodities/CommodityStore.hpp
+/// @version   1.0 - Initial version
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>          // For the per-CommodityEnum columns
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint32_t
+#include <span>           // For the column views
+#include <vector>         // For the columns
+
+#include "Commodity.hpp"
+
+namespace empire {
+
+/// Identifies an entity (a sector, ship, land unit...) in a CommodityStore.
+/// It's the entity's row in every column.
+typedef std::uint32_t entityIndex;
+
+
+/// The maximum value of each Commodity for one entity.  Use 0 (or false) for
+/// the Commodities the entity can't hold.
+typedef std::array< commodityValue, COMMODITY_COUNT > commodityLimits;
+
+
+/////////////////////                                    /////////////////////
+/////////////////////  CommodityStore Class Declaration  /////////////////////
+/////////////////////                                    /////////////////////
+
+/// Holds the Commodities of many entities as a structure of arrays
+///
+/// Each CommodityEnum has a column of values and a column of maxValues, with
+/// one row per entity.  The intrinsic data is not copied into the store:
+/// getType() looks it up in CommodityTypes::CommodityArray.
+///
+/// @code
+///    CommodityStore world( 184 * 88 );
+///    const entityIndex sector = world.addEntity( sectorLimits );
+///    world.increase( sector, FOOD, 10 );
+///
+///    for( commodityValue& food : world.getValues( FOOD ) ) { ... }
+/// @endcode
+///
+/// increase(), decrease() and getValue() work just like Commodity's +=, -=
+/// and getValue():  They throw commodityOverflowException,
+/// commodityUnderflowException and commodityDisabledException.
+/// tryIncrease(), tryDecrease() and tryGetValue() return a CommodityResult
+/// instead, like Commodity's versions.  Code that
+/// writes straight into a column from getValues() must keep each value in
+/// [0, maxValue] itself (validate() will check).  increaseAll() and
+/// decreaseAll() update a whole column with the SIMD kernels in
+/// CommodityBatch.hpp:  They clamp and count instead of throwing.
+///
+/// Adding an entity can grow the columns, which invalidates the spans from
+/// getValues() and getMaxValues().
+///
+/// @pattern Flyweight:  CommodityStore is the "Extrinsic" part, for many
+///          entities at once.
+///
+class CommodityStore final {
+public:  ///////////////////////////  Constructor  ////////////////////////////
+
+   /// Constructor for CommodityStore.
+   ///
+   /// @param inReserve Make room for this many entities up front
+   explicit CommodityStore( const std::size_t inReserve = 0 );
+
+
+public:  /////////////////////////////  Methods  /////////////////////////////
+
+   /// Add an entity, with all of its Commodities at 0.
+   ///
+   /// @param inMaxValues The maximum value of each of its Commodities
+   /// @return The new entity's row
+   entityIndex addEntity( const commodityLimits& inMaxValues );
+
+   /// Return the number of entities in the store.
+   std::size_t size() const;
+
+   /// Return the intrinsic data for a Commodity.
+   static constexpr const CommodityType& getType( const CommodityEnum commodity );
+
+   /// Return the column of values for a Commodity, one per entity.
+   std::span< commodityValue > getValues( const CommodityEnum commodity );
+
+   /// Return the column of values for a Commodity, one per entity.
+   std::span< const commodityValue > getValues( const CommodityEnum commodity ) const;
+
+   /// Return the column of maxValues for a Commodity, one per entity.
+   std::span< const commodityValue > getMaxValues( const CommodityEnum commodity ) const;
+
+   /// True if the entity can hold the Commodity (its maxValue is > 0).
+   bool isEnabled( const entityIndex entity, const CommodityEnum commodity ) const;
+
+   /// Return the entity's value of a Commodity.
+   ///
+   /// Throw commodityDisabledException if the commodity is disabled.
+   commodityValue getValue( const entityIndex entity, const CommodityEnum commodity ) const;
+
+   /// Add to the entity's Commodity.  If it exceeds maxValue, then throw
+   /// commodityOverflowException and leave it at maxValue.
+   ///
+   /// Throw commodityDisabledException if the commodity is disabled.
+   void increase( const entityIndex entity, const CommodityEnum commodity, const commodityValue increaseBy );
+
+   /// Subtract from the entity's Commodity.  If it goes below 0, then throw
+   /// commodityUnderflowException and leave it at 0.
+   ///
+   /// Throw commodityDisabledException if the commodity is disabled.
+   void decrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue decreaseBy );
+
+   /// Return the entity's value of a Commodity without throwing.  The status
+   /// is disabled if the commodity is disabled.
+   CommodityResult tryGetValue( const entityIndex entity, const CommodityEnum commodity ) const;
+
+   /// Add to the entity's Commodity without throwing.  If it exceeds
+   /// maxValue, leave it at maxValue and return the overflow status.
+   CommodityResult tryIncrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue increaseBy );
+
+   /// Subtract from the entity's Commodity without throwing.  If it goes
+   /// below 0, leave it at 0 and return the underflow status.
+   CommodityResult tryDecrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue decreaseBy );
+
+   /// Add `increaseBy[ entity ]` to every entity's Commodity with
+   /// commodityBatchAdd().  The values that exceed maxValue are left at
+   /// maxValue and counted.  Nothing is thrown.
+   ///
+   /// @param commodity    The column to update
+   /// @param increaseBy   One delta per entity, each in [0, MAX_COMMODITY_VALUE]
+   /// @param overflowMask Optional:  One bit per entity (see commodityBatchAdd())
+   /// @return The number of entities that overflowed
+   std::size_t increaseAll( const CommodityEnum commodity
+                           ,std::span< const commodityValue > increaseBy
+                           ,std::span< std::uint64_t > overflowMask = {} );
+
+   /// Subtract `decreaseBy[ entity ]` from every entity's Commodity with
+   /// commodityBatchSubtract().  The values that go below 0 are left at 0 and
+   /// counted.  Nothing is thrown.
+   ///
+   /// @param commodity     The column to update
+   /// @param decreaseBy    One delta per entity, each in [0, MAX_COMMODITY_VALUE]
+   /// @param underflowMask Optional:  One bit per entity (see commodityBatchAdd())
+   /// @return The number of entities that underflowed
+   std::size_t decreaseAll( const CommodityEnum commodity
+                           ,std::span< const commodityValue > decreaseBy
+                           ,std::span< std::uint64_t > underflowMask = {} );
+
+   /// Validate every value in the store.
+   bool validate() const;
+
+
+private:  /////////////////////////////  Members  /////////////////////////////
+
+   /// The value of each Commodity, one column per CommodityEnum.
+   std::array< std::vector< commodityValue >, COMMODITY_COUNT > values;
+
+   /// The maximum value of each Commodity, one column per CommodityEnum.
+   std::array< std::vector< commodityValue >, COMMODITY_COUNT > maxValues;
+
+   /// The number of entities (rows).
+   std::size_t entityCount = 0;
+};
+
+
+///////////////////////                                 ///////////////////////
+///////////////////////  Inline CommodityStore Methods  ///////////////////////
+///////////////////////                                 ///////////////////////
+
+inline std::size_t CommodityStore::size() const {
+   return entityCount;
+}
+
+
+constexpr const CommodityType& CommodityStore::getType( const CommodityEnum commodity ) {
+   return CommodityTypes::CommodityArray[ commodity ];
+}
+
+
+inline std::span< commodityValue > CommodityStore::getValues( const CommodityEnum commodity ) {
+   return values[ commodity ];
+}
+
+
+inline std::span< const commodityValue > CommodityStore::getValues( const CommodityEnum commodity ) const {
+   return values[ commodity ];
+}
+
+
+inline std::span< const commodityValue > CommodityStore::getMaxValues( const CommodityEnum commodity ) const {
+   return maxValues[ commodity ];
+}
+
+
+inline bool CommodityStore::isEnabled( const entityIndex entity, const CommodityEnum commodity ) const {
+   BOOST_ASSERT( entity < entityCount );
+
+   return maxValues[ commodity ][ entity ] >= 1;
+}
+
+
+inline commodityValue CommodityStore::getValue( const entityIndex entity, const CommodityEnum commodity ) const {
+   if( !isEnabled( entity, commodity ) ) {
+      throw commodityDisabledException();
+   }
+
+   return values[ commodity ][ entity ];
+}
+
+
+inline CommodityResult CommodityStore::tryGetValue( const entityIndex entity, const CommodityEnum commodity ) const {
+   if( !isEnabled( entity, commodity ) ) {
+      return { CommodityStatus::disabled, 0, 0, 0 };
+   }
+
+   const commodityValue value = values[ commodity ][ entity ];
+   return { CommodityStatus::ok, value, value, value };
+}
+
+
+inline CommodityResult CommodityStore::tryIncrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue increaseBy ) {
+   if( !isEnabled( entity, commodity ) ) {
+      return { CommodityStatus::disabled, 0, 0, 0 };
+   }
+
+   // These will bound the size of the increase to a small enough
+   // number to prevent any wraparound issues.
+   BOOST_ASSERT( increaseBy >= 0 );
+   BOOST_ASSERT( increaseBy <= MAX_COMMODITY_VALUE );
+
+   commodityValue& value = values[ commodity ][ entity ];
+   const commodityValue maxValue = maxValues[ commodity ][ entity ];
+   const commodityValue oldValue = value;
+   const commodityValue newValue = static_cast< commodityValue >( value + increaseBy );
+
+   if( newValue <= maxValue ) {  // Is the new value OK?
+      value = newValue;
+      return { CommodityStatus::ok, value, oldValue, newValue };
+   }
+
+   value = maxValue;  // If we overflow, set value to maxValue
+   return { CommodityStatus::overflow, value, oldValue, newValue };
+}
+
+
+inline CommodityResult CommodityStore::tryDecrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue decreaseBy ) {
+   if( !isEnabled( entity, commodity ) ) {
+      return { CommodityStatus::disabled, 0, 0, 0 };
+   }
+
+   // These will bound the size of the decrease to a small enough
+   // number to prevent any wraparound issues.
+   BOOST_ASSERT( decreaseBy >= 0 );
+   BOOST_ASSERT( decreaseBy <= MAX_COMMODITY_VALUE );
+
+   commodityValue& value = values[ commodity ][ entity ];
+   const commodityValue oldValue = value;
+   const commodityValue newValue = static_cast< commodityValue >( value - decreaseBy );
+
+   if( newValue >= 0 ) {  // Is the new value OK?
+      value = newValue;
+      return { CommodityStatus::ok, value, oldValue, newValue };
+   }
+
+   value = 0;  // If we underflow, set value to 0
+   return { CommodityStatus::underflow, value, oldValue, newValue };
+}
+
+
+inline void CommodityStore::increase( const entityIndex entity, const CommodityEnum commodity, const commodityValue increaseBy ) {
+   const CommodityResult result = tryIncrease( entity, commodity, increaseBy );
+
+   if( !result ) {
+      throwCommodityResult( result, getType( commodity ).getName1(), maxValues[ commodity ][ entity ] );
+   }
+}
+
+
+inline void CommodityStore::decrease( const entityIndex entity, const CommodityEnum commodity, const commodityValue decreaseBy ) {
+   const CommodityResult result = tryDecrease( entity, commodity, decreaseBy );
+
+   if( !result ) {
+      throwCommodityResult( result, getType( commodity ).getName1(), maxValues[ commodity ][ entity ] );
+   }
+}
+
+} // namespace empire
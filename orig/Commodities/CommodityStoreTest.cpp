@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V
+//
+/// Test class for CommodityStore.cpp
+///
+/// @file      Commodities/CommodityStoreTest.cpp
+/// @version   1.0
+///
+/// @author    Mark Nelson <mr_nelson@icloud.com>
+/// @date      17 Oct 2026
+/// @copyright (c) 2026 Mark Nelson
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// The name of this test module is Empire_Server
+#define BOOST_TEST_MODULE Empire_Server
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/execution_monitor.hpp>
+
+#include "../lib/EmpireExceptions.hpp"
+#include "CommodityStore.hpp"
+
+
+using namespace empire;
+
+
+/// @internal  Name the test suite after the directory that it's in.  Also,
+/// the name should not conflict with other objects in the test suite.
+BOOST_AUTO_TEST_SUITE( CommodityStore_test_suite )
+
+
+/// A sector:  Everything but RAD
+static const commodityLimits sectorLimits = { 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 999, 0 };
+
+/// A ship that only carries civs, mil and food
+static const commodityLimits shipLimits = { 100, 50, 0, 0, 0, 0, 0, 0, 200, 0, 0, 0, 0, 0 };
+
+
+/// Test adding entities and the column layout
+BOOST_AUTO_TEST_CASE( CommodityStore_columns ) {
+   CommodityStore store( 184 * 88 );
+
+   BOOST_CHECK( store.size() == 0 );
+   const entityIndex sector = store.addEntity( sectorLimits );
+   const entityIndex ship   = store.addEntity( shipLimits );
+   BOOST_CHECK( sector == 0 );
+   BOOST_CHECK( ship   == 1 );
+   BOOST_CHECK( store.size() == 2 );
+   BOOST_CHECK_NO_THROW( store.validate() );
+
+   BOOST_CHECK( store.getValues( FOOD ).size()       == 2 );
+   BOOST_CHECK( store.getMaxValues( FOOD )[ ship ]   == 200 );
+   BOOST_CHECK( store.getMaxValues( RAD )[ sector ]  == 0 );
+   BOOST_CHECK( store.isEnabled( sector, FOOD ) );
+   BOOST_CHECK( !store.isEnabled( ship, GUN ) );
+
+   // A column is one contiguous array across entities
+   store.increase( sector, FOOD, 10 );
+   store.increase( ship, FOOD, 20 );
+   BOOST_CHECK( store.getValues( FOOD )[ 0 ] == 10 );
+   BOOST_CHECK( &store.getValues( FOOD )[ 1 ] == &store.getValues( FOOD )[ 0 ] + 1 );
+
+   for( commodityValue& food : store.getValues( FOOD ) ) {
+      food += 5;
+   }
+   BOOST_CHECK( store.getValue( sector, FOOD ) == 15 );
+   BOOST_CHECK( store.getValue( ship, FOOD )   == 25 );
+   BOOST_CHECK( store.getValue( ship, CIV )    == 0 );
+   BOOST_CHECK_NO_THROW( store.validate() );
+
+   // The intrinsic data comes from CommodityTypes
+   BOOST_CHECK( &CommodityStore::getType( LCM ) == &CommodityTypes::CommodityArray[ LCM ] );
+   BOOST_CHECK( CommodityStore::getType( FOOD ).getName3() == "eat" );
+}
+
+
+/// Test the bounds and exceptions, which match Commodity
+BOOST_AUTO_TEST_CASE( CommodityStore_bounds ) {
+   CommodityStore store;
+   const entityIndex ship = store.addEntity( shipLimits );
+
+   store.increase( ship, MIL, 50 );
+   BOOST_CHECK( store.getValue( ship, MIL ) == 50 );
+
+   try {
+      store.increase( ship, MIL, 1 );
+      BOOST_CHECK_MESSAGE( false, "The line above should have thrown an exception" );
+   }
+   catch( boost::exception & e ) {
+      BOOST_CHECK( *boost::get_error_info<errinfo_oldValue>( e )       == 50 );
+      BOOST_CHECK( *boost::get_error_info<errinfo_requestedValue>( e ) == 51 );
+      BOOST_CHECK( *boost::get_error_info<errinfo_maxValue>( e )       == 50 );
+      BOOST_CHECK( *boost::get_error_info<errinfo_commodityType>( e )  == 'm' );
+   }
+   BOOST_CHECK( store.getValue( ship, MIL ) == 50 );
+
+   store.decrease( ship, MIL, 50 );
+   BOOST_CHECK_THROW( store.decrease( ship, MIL, 1 ), commodityUnderflowException );
+   BOOST_CHECK( store.getValue( ship, MIL ) == 0 );
+
+   BOOST_CHECK_THROW( store.getValue( ship, GUN ), commodityDisabledException );
+   BOOST_CHECK_THROW( store.increase( ship, GUN, 1 ), commodityDisabledException );
+   BOOST_CHECK_THROW( store.increase( ship, CIV, -1 ), assertionException );
+
+   commodityLimits badLimits = shipLimits;
+   badLimits[ CIV ] = MAX_COMMODITY_VALUE + 1;
+   BOOST_CHECK_THROW( store.addEntity( badLimits ), assertionException );
+   BOOST_CHECK( store.size() == 1 );
+
+   BOOST_CHECK_NO_THROW( store.validate() );
+}
+
+
+/// Test tryIncrease(), tryDecrease() and tryGetValue(), which don't throw
+BOOST_AUTO_TEST_CASE( CommodityStore_try_operations ) {
+   CommodityStore store;
+   const entityIndex ship = store.addEntity( shipLimits );
+
+   BOOST_CHECK( store.tryIncrease( ship, MIL, 40 ) );
+
+   const CommodityResult result = store.tryIncrease( ship, MIL, 20 );
+   BOOST_CHECK( result.status == CommodityStatus::overflow );
+   BOOST_CHECK( result.value == 50 );
+   BOOST_CHECK( result.oldValue == 40 );
+   BOOST_CHECK( result.requestedValue == 60 );
+   BOOST_CHECK( store.getValue( ship, MIL ) == 50 );
+
+   BOOST_CHECK( store.tryDecrease( ship, MIL, 51 ).status == CommodityStatus::underflow );
+   BOOST_CHECK( store.tryGetValue( ship, MIL ).value == 0 );
+
+   BOOST_CHECK( store.tryIncrease( ship, GUN, 1 ).status == CommodityStatus::disabled );
+   BOOST_CHECK( store.tryDecrease( ship, GUN, 1 ).status == CommodityStatus::disabled );
+   BOOST_CHECK( store.tryGetValue( ship, GUN ).status   == CommodityStatus::disabled );
+   BOOST_CHECK_THROW( (void) store.tryIncrease( ship, CIV, -1 ), assertionException );
+
+   BOOST_CHECK_NO_THROW( store.validate() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -192,6 +192,61 @@ BOOST_AUTO_TEST_CASE( Commodity_underflow ) {
 }
 
 
+/// Exercise tryIncrease(), tryDecrease() and tryGetValue(), which return a
+/// CommodityResult instead of throwing
+BOOST_AUTO_TEST_CASE( Commodity_try_operations ) {
+   Commodity testCommodity( IRON_ORE, 100 );
+
+   CommodityResult result = testCommodity.tryIncrease( 60 );
+   BOOST_CHECK( result );
+   BOOST_CHECK( result.status == CommodityStatus::ok );
+   BOOST_CHECK( result.value == 60 );
+   BOOST_CHECK( testCommodity.getValue() == 60 );
+
+   // An overflow leaves it at maxValue and reports what += would have thrown
+   result = testCommodity.tryIncrease( 50 );
+   BOOST_CHECK( !result );
+   BOOST_CHECK( result.status == CommodityStatus::overflow );
+   BOOST_CHECK( result.value == 100 );
+   BOOST_CHECK( result.oldValue == 60 );
+   BOOST_CHECK( result.requestedValue == 110 );
+   BOOST_CHECK( testCommodity.getValue() == 100 );
+
+   result = testCommodity.tryDecrease( 30 );
+   BOOST_CHECK( result.ok() );
+   BOOST_CHECK( result.value == 70 );
+
+   // An underflow leaves it at 0
+   result = testCommodity.tryDecrease( 71 );
+   BOOST_CHECK( result.status == CommodityStatus::underflow );
+   BOOST_CHECK( result.value == 0 );
+   BOOST_CHECK( result.oldValue == 70 );
+   BOOST_CHECK( result.requestedValue == -1 );
+   BOOST_CHECK( testCommodity.getValue() == 0 );
+
+   BOOST_CHECK( testCommodity.tryGetValue() );
+   BOOST_CHECK( testCommodity.tryGetValue().value == 0 );
+
+   // The arguments are still bounds checked
+   BOOST_CHECK_THROW( (void) testCommodity.tryIncrease( -1 ), assertionException );
+   BOOST_CHECK_THROW( (void) testCommodity.tryDecrease( MAX_COMMODITY_VALUE + 1 ), assertionException );
+   BOOST_CHECK_NO_THROW( testCommodity.validate() );
+
+   // A disabled Commodity doesn't change
+   Commodity testCommodity2( UCW, false );
+   BOOST_CHECK( testCommodity2.tryIncrease( 1 ).status == CommodityStatus::disabled );
+   BOOST_CHECK( testCommodity2.tryDecrease( 1 ).status == CommodityStatus::disabled );
+   BOOST_CHECK( testCommodity2.tryGetValue().status   == CommodityStatus::disabled );
+   BOOST_CHECK_NO_THROW( testCommodity2.validate() );
+
+   // throwCommodityResult() turns a result back into the exception
+   BOOST_CHECK_THROW( throwCommodityResult( { CommodityStatus::overflow, 100, 60, 110 }, 'i', 100 ), commodityOverflowException );
+   BOOST_CHECK_THROW( throwCommodityResult( { CommodityStatus::underflow, 0, 70, -1 }, 'i', 100 ), commodityUnderflowException );
+   BOOST_CHECK_THROW( throwCommodityResult( { CommodityStatus::disabled, 0, 0, 0 }, 'u', 0 ), commodityDisabledException );
+   BOOST_CHECK_THROW( throwCommodityResult( { CommodityStatus::ok, 1, 0, 1 }, 'i', 100 ), assertionException );
+}
+
+
 /// Exercise the CommodityTypes validate function
 BOOST_AUTO_TEST_CASE( CommodityType_Basics ) {
 	CommodityTypes::validate();
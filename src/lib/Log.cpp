@@ -8,12 +8,26 @@
 /// @copyright (c) 2021 Mark Nelson.  All rights reserved.
 ///////////////////////////////////////////////////////////////////////////////
 
-#include <array>    // For array<>
-#include <atomic>   // For atomic_size_t
-#include <cstring>  // For memset()
+#include <array>      // For array<>
+#include <atomic>     // For atomic_size_t atomic_flag atomic_ref<> atomic_thread_fence()
+#include <bit>        // For countr_zero() countr_one()
+#include <cerrno>     // For errno EINTR
+#include <cstring>    // For memcpy() memset()
+#include <span>       // For span<>
+#include <stdexcept>  // For range_error
+#include <thread>     // For this_thread::yield()
+#include <unistd.h>   // For write() lseek() ftruncate()
 
 #include "../version.hpp"  // For CACHE_LINE_BYTES
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "Log" };
+
 #include "Log.hpp"
+#include "LogConsumer.hpp"  // For the LogConsumer interface to LogQueue
+#include "LogCrash.hpp"     // For LogCrashHeader installLogCrashStack()
+#include "LogRing.hpp"      // For LogRing<>
 
 using namespace std;
 
@@ -29,7 +43,14 @@ namespace empire {
 ///
 /// The logger is not stateful between application restarts.  In other words,
 /// the LogQueue does not try to save/restore anything to/from disk.
-static std::array< empire::LogEntry, empire::SIZE_OF_QUEUE > LogQueue;  /// @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): We are deliberately making this static to act like a member variable.
+///
+/// Its size comes from empire::LOG_RING_PRESET.
+static LogRing< SIZE_OF_QUEUE > LogQueue;  /// @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): We are deliberately making this static to act like a member variable.
+
+/// Ask for huge pages for LogQueue when Log.cpp is initialized.  A module that
+/// logs from its own static initializer before then only costs us the pages
+/// it touched.
+[[maybe_unused]] static const bool LogQueueHugePages { ( LogQueue.adviseHugePages(), true ) };
 
 /// Essentially, this is a pointer to the next available entry in LogQueue.
 /// In fact, it holds both the generation counter (the number of times LogQueue
@@ -39,19 +60,377 @@ alignas( empire::CACHE_LINE_BYTES ) static atomic_size_t LogIndex { 0 };
 
 
 /// This is roughly equivalent to Windows' WaitForSingleObject() signalling
-/// mechanism.  When we have a new event, we set this `atomic_flag`.  The
-/// LogConsumer objects wait on this flag and start when it's set.
-alignas( empire::CACHE_LINE_BYTES ) static std::atomic_flag hasNewLogs = ATOMIC_FLAG_INIT;
+/// mechanism.  Each running LogConsumer owns one doorbell in this array.  When
+/// we have a new event, we set the doorbells.  The LogConsumer objects wait on
+/// their doorbell and start draining LogQueue when it's set.
+///
+/// Each LogConsumer needs its own doorbell.  If they shared one, a consumer
+/// that clears the flag could hide a new log from a consumer that's asleep.
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): hasNewLogs is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static std::array< std::atomic_flag, MAX_LOG_CONSUMERS > hasNewLogs;
+
+/// A bitmask of the slots in hasNewLogs that belong to a running LogConsumer
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogConsumerSlots is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static atomic_size_t LogConsumerSlots { 0 };
+
+static_assert( MAX_LOG_CONSUMERS <= sizeof( size_t ) * 8, "LogConsumerSlots can't hold MAX_LOG_CONSUMERS bits" );
+
+/// The tail pointer of each running LogConsumer, indexed by its slot in
+/// LogConsumerSlots.  Producers use the slowest one to decide if LogQueue is
+/// full.
+///
+/// The LogConsumer publishes its tail pointer here (rather than us holding a
+/// pointer to the LogConsumer) so a producer never touches a LogConsumer that's
+/// been destroyed.
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogConsumerIndexes is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static std::array< atomic_size_t, MAX_LOG_CONSUMERS > LogConsumerIndexes {};
+
+/// What producers do when LogQueue is full
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogPolicy is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static atomic< LogOverrunPolicy > LogPolicy { DEFAULT_LOG_OVERRUN_POLICY };
+
+/// The number of LogEntry records producers discarded because LogQueue was
+/// full and LogPolicy is LogOverrunPolicy::dropNewest
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogDropped is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static atomic_size_t LogDropped { 0 };
+
+/// Where producers put their LogEntry records
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogMode is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static atomic< LogQueueMode > LogMode { DEFAULT_LOG_QUEUE_MODE };
+
+
+/// A ring buffer of LogEntry records with a single producer
+///
+/// Under LogQueueMode::perThread, each producer thread owns one of these.
+/// It works like LogQueue, except only the owner moves #head, so it's a plain
+/// load and store instead of a contended read-modify-write on LogIndex.
+struct LogThreadRing {
+   /// The LogEntry records
+   LogRing< SIZE_OF_THREAD_RING > entries;
+
+   /// The index of the next LogEntry the owner will claim (like LogIndex)
+   alignas( CACHE_LINE_BYTES ) atomic_size_t head { 0 };
+
+   /// The tail pointer of each running LogConsumer into this ring (like
+   /// LogConsumerIndexes)
+   alignas( CACHE_LINE_BYTES ) std::array< atomic_size_t, MAX_LOG_CONSUMERS > consumerIndexes {};
+
+   /// `true` while a thread owns this ring
+   std::atomic< bool > owned { false };
+};
+
+/// The per-thread rings.  They are never freed:  When a thread exits, its ring
+/// (and anything the LogConsumer threads haven't drained yet) is handed to
+/// the next thread that needs one.
+///
+/// It's zero-initialized, so the pages aren't touched until a thread uses them.
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogThreadRings is static, so it's not really a global
+static std::array< LogThreadRing, MAX_LOG_THREAD_RINGS > LogThreadRings;
+
+/// The number of LogThreadRings that have ever been handed out.  The
+/// LogConsumer threads only look at these.
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): LogThreadRingCount is static, so it's not really a global
+alignas( empire::CACHE_LINE_BYTES ) static atomic_size_t LogThreadRingCount { 0 };
+
+
+/// The LogThreadRing that belongs to this thread.  It gives the ring back when
+/// the thread exits.
+class LogThreadRingOwner {
+public:
+   LogThreadRingOwner() = default;
 
+   LogThreadRingOwner(LogThreadRingOwner &src)                    = delete; // Copy constructor
+   LogThreadRingOwner(const LogThreadRingOwner &src)              = delete; // Const copy constructor
+   LogThreadRingOwner &operator=(LogThreadRingOwner &src)         = delete; // Copy assignment
+   LogThreadRingOwner &operator=(const LogThreadRingOwner &src)   = delete; // Const copy assignment
+   LogThreadRingOwner (LogThreadRingOwner&& src)                  = delete; // Move constructor
+   LogThreadRingOwner (const LogThreadRingOwner&& src)            = delete; // Const move constructor
+   LogThreadRingOwner& operator= (LogThreadRingOwner&& src)       = delete; // Move assignment operator
+   LogThreadRingOwner& operator= (const LogThreadRingOwner&& src) = delete; // Const move assignment operator
 
-/// Need to document this someday
+   ~LogThreadRingOwner() {
+      if( m_ring != nullptr ) {
+         m_ring->owned.store( false, memory_order_release );
+      }
+   }
+
+   /// Get this thread's LogThreadRing, claiming one the first time
+   ///
+   /// @return The LogThreadRing or `nullptr` if they are all taken
+   LogThreadRing* get() {
+      if( m_ring == nullptr && !m_exhausted ) {
+         m_ring = claim();
+         m_exhausted = ( m_ring == nullptr );
+         if( m_ring != nullptr ) {
+            installLogCrashStack();  // So a stack overflow in this thread is dumped
+         }
+      }
+      return m_ring;
+   }
+
+private:
+   /// Claim a LogThreadRing that no thread owns
+   ///
+   /// @return The LogThreadRing or `nullptr` if they are all taken
+   static LogThreadRing* claim() {
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t i = 0 ; i < MAX_LOG_THREAD_RINGS ; i++ ) {
+         bool expected = false;
+         /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `i` is always < MAX_LOG_THREAD_RINGS
+         if( LogThreadRings[ i ].owned.compare_exchange_strong( expected, true, memory_order_acquire ) ) {
+            /// Let the LogConsumer threads see it before we write anything
+            size_t count = LogThreadRingCount.load();
+            // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+            while( count < i + 1 && !LogThreadRingCount.compare_exchange_weak( count, i + 1 ) ) {}
+
+            /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `i` is always < MAX_LOG_THREAD_RINGS
+            return &LogThreadRings[ i ];
+         }
+      }
+      return nullptr;
+   }
+
+   LogThreadRing* m_ring { nullptr };  ///< This thread's ring
+   bool m_exhausted { false };         ///< There were no rings left when we asked
+};
+
+/// This thread's LogThreadRing
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): ThisThreadRing is thread_local, so it's not really a global
+static thread_local LogThreadRingOwner ThisThreadRing;
+
+
+/// Ring the doorbell of every running LogConsumer
+///
+/// Called by the producer after it publishes a LogEntry.  A doorbell that's
+/// already ringing is left alone, so the usual cost is one fence and a few
+/// loads.
 void postNewLog() {
-//   hasNewLogs.
+   size_t consumers = LogConsumerSlots.load( memory_order_relaxed );
+   if( consumers == 0 ) {
+      return;
+   }
+
+   /// Order the LogEntry::ready store before the doorbell loads.  This pairs
+   /// with the fence in logArmDoorbell().
+   atomic_thread_fence( memory_order_seq_cst );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( consumers != 0 ) {
+      const auto slot = static_cast< size_t >( countr_zero( consumers ) );
+      consumers &= consumers - 1;
+
+      /// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+      if( !hasNewLogs[ slot ].test( memory_order_relaxed ) && !hasNewLogs[ slot ].test_and_set( memory_order_release ) ) {
+         hasNewLogs[ slot ].notify_one();
+      }
+      // @NOLINTEND( cppcoreguidelines-pro-bounds-constant-array-index )
+   }
+}
+
+
+size_t registerLogConsumer( const size_t consumerIndex, const span< const atomic_size_t > ringIndexes ) {
+   BOOST_ASSERT_MSG( ringIndexes.size() == MAX_LOG_THREAD_RINGS, "There must be a tail pointer for each LogThreadRing" );
+
+   size_t slots = LogConsumerSlots.load();
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( ;; ) {
+      const auto slot = static_cast< size_t >( countr_one( slots ) );
+      if( slot >= MAX_LOG_CONSUMERS ) {
+         /// @throws range_error if MAX_LOG_CONSUMERS are already running
+         throw range_error( "There are already MAX_LOG_CONSUMERS LogConsumers running" );
+      }
+
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+      hasNewLogs[ slot ].clear();
+      LogConsumerIndexes[ slot ].store( consumerIndex );
+
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t ring = 0 ; ring < MAX_LOG_THREAD_RINGS ; ring++ ) {
+         /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS and `slot` is always < MAX_LOG_CONSUMERS
+         LogThreadRings[ ring ].consumerIndexes[ slot ].store( ringIndexes[ ring ].load( memory_order_relaxed ) );
+      }
+
+      if( LogConsumerSlots.compare_exchange_weak( slots, slots | ( size_t { 1 } << slot ) ) ) {
+         return slot;
+      }
+   }
+}
+
+
+void unregisterLogConsumer( const size_t slot ) {
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   LogConsumerSlots.fetch_and( ~( size_t { 1 } << slot ) );
+}
+
+
+void logSetConsumerIndex( const size_t slot, const size_t consumerIndex ) {
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+   LogConsumerIndexes[ slot ].store( consumerIndex, memory_order_release );
+}
+
+
+void logSetThreadRingConsumerIndex( const size_t ring, const size_t slot, const size_t ringIndex ) {
+   BOOST_ASSERT_MSG( ring < MAX_LOG_THREAD_RINGS, "LogThreadRing out of range" );
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS and `slot` is always < MAX_LOG_CONSUMERS
+   LogThreadRings[ ring ].consumerIndexes[ slot ].store( ringIndex, memory_order_release );
+}
+
+
+void logArmDoorbell( const size_t slot ) {
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+   hasNewLogs[ slot ].clear( memory_order_relaxed );
+
+   /// Order the doorbell store before the LogEntry::ready loads.  This pairs
+   /// with the fence in postNewLog().
+   atomic_thread_fence( memory_order_seq_cst );
+}
+
+
+void logWaitForDoorbell( const size_t slot ) {
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+   hasNewLogs[ slot ].wait( false, memory_order_acquire );
+}
+
+
+void logRingDoorbell( const size_t slot ) {
+   BOOST_ASSERT_MSG( slot < MAX_LOG_CONSUMERS, "LogConsumer slot out of range" );
+
+   /// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+   hasNewLogs[ slot ].test_and_set( memory_order_release );
+   hasNewLogs[ slot ].notify_one();
+   // @NOLINTEND( cppcoreguidelines-pro-bounds-constant-array-index )
+}
+
+
+size_t logHead() {
+   return LogIndex.load( memory_order_acquire );
+}
+
+
+size_t logThreadRingCount() {
+   return LogThreadRingCount.load( memory_order_acquire );
 }
 
+
+size_t logThreadRingHead( const size_t ring ) {
+   BOOST_ASSERT_MSG( ring < MAX_LOG_THREAD_RINGS, "LogThreadRing out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   return LogThreadRings[ ring ].head.load( memory_order_acquire );
+}
+
+
+size_t logDroppedCount() {
+   return LogDropped.load( memory_order_acquire );
+}
+
+
+void setLogOverrunPolicy( const LogOverrunPolicy policy ) {
+   LogPolicy.store( policy );
+}
+
+
+LogOverrunPolicy getLogOverrunPolicy() {
+   return LogPolicy.load();
+}
+
+
+void setLogQueueMode( const LogQueueMode mode ) {
+   LogMode.store( mode );
+}
+
+
+LogQueueMode getLogQueueMode() {
+   return LogMode.load();
+}
+
+
+/// Get the tail pointer of the slowest running LogConsumer
+///
+/// @param head The current value of LogIndex (or LogThreadRing::head)
+/// @param consumerIndexes The tail pointers (LogConsumerIndexes or
+///                        LogThreadRing::consumerIndexes)
+/// @return The oldest LogIndex that a running LogConsumer still needs, or
+///         `head` if there are no running LogConsumers
+static size_t logTail( const size_t head, const std::array< atomic_size_t, MAX_LOG_CONSUMERS >& consumerIndexes = LogConsumerIndexes ) {
+   size_t tail = head;
+   size_t consumers = LogConsumerSlots.load( memory_order_acquire );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( consumers != 0 ) {
+      const auto slot = static_cast< size_t >( countr_zero( consumers ) );
+      consumers &= consumers - 1;
+
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `slot` is always < MAX_LOG_CONSUMERS
+      tail = min( tail, consumerIndexes[ slot ].load( memory_order_acquire ) );
+   }
+
+   return tail;
+}
+
+
+/// Safely copy a LogEntry out of LogQueue or a LogThreadRing
+///
+/// @param entry The LogEntry in the ring
+/// @param index The index the LogEntry should hold
+/// @param copy Where to copy the LogEntry
+/// @return LogSnapshot::ready if `copy` holds the LogEntry at `index`
+static LogSnapshot snapshotLogEntry( LogEntry& entry, const size_t index, LogEntry& copy ) {
+   const uint64_t sequence = atomic_ref< uint64_t >( entry.sequence ).load( memory_order_acquire );
+   if( sequence > index ) {
+      return LogSnapshot::lost;
+   }
+
+   if( sequence < index || !atomic_ref< bool >( entry.ready ).load( memory_order_acquire ) ) {
+      return LogSnapshot::pending;
+   }
+
+   memcpy( &copy, &entry, sizeof( LogEntry ) );
+
+   /// If a producer started to overwrite the LogEntry while we were copying
+   /// it, then it changed LogEntry::sequence or LogEntry::ready before it
+   /// wrote anything else, and the copy is no good
+   atomic_thread_fence( memory_order_acquire );
+   if( atomic_ref< uint64_t >( entry.sequence ).load( memory_order_relaxed ) != index
+    || !atomic_ref< bool >( entry.ready ).load( memory_order_relaxed ) ) {
+      return LogSnapshot::lost;
+   }
+
+   return LogSnapshot::ready;
+}
+
+
+LogSnapshot logSnapshot( const size_t index, LogEntry& copy ) {
+   return snapshotLogEntry( LogQueue[ index ], index, copy );
+}
+
+
+LogSnapshot logThreadRingSnapshot( const size_t ring, const size_t index, LogEntry& copy ) {
+   BOOST_ASSERT_MSG( ring < MAX_LOG_THREAD_RINGS, "LogThreadRing out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   return snapshotLogEntry( LogThreadRings[ ring ].entries[ index ], index, copy );
+}
+
+
+const LogEntry& logEntryAt( const size_t index ) {
+   return LogQueue[ index ];
+}
+
+
 /// Reset the logger
 void logReset() {
-   /// - Stop the handler threads
+   /// - The handler threads must be stopped before the reset
 
    /// - Zero out LogQueue
    // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
@@ -59,31 +438,220 @@ void logReset() {
       memset( &i, 0, sizeof( LogEntry ) );
    }
 
-   /// - Reset the LogIndex
+   /// - Reset the LogIndex and the dropped counter
    LogIndex.store( 0 );
+   LogDropped.store( 0 );
 
-   /// - Start the handler threads
+   /// - Empty the LogThreadRings (the threads that own them keep them)
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( LogThreadRing& ring : LogThreadRings ) {
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( LogEntry& i : ring.entries ) {
+         memset( &i, 0, sizeof( LogEntry ) );
+      }
+      ring.head.store( 0 );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( atomic_size_t& consumerIndex : ring.consumerIndexes ) {
+         consumerIndex.store( 0 );
+      }
+   }
 
    cout << "Reset the logger" << endl;
    cout << "SIZE_OF_QUEUE=" << SIZE_OF_QUEUE << endl;
 }
 
 
-LogEntry& getNextLogEntry() {
-   /// Get the LogEntry and increment the queue (thread safe because LogIndex is
-   /// an atomic)
-   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): Temporarily disable static bounds checking
-   LogEntry& thisEntry = LogQueue[ LogIndex++ & LOG_QUEUE_INDEX_MASK ];
+/// Write all of a buffer to a file descriptor (async-signal-safe)
+///
+/// @param fd The file descriptor
+/// @param data The buffer
+/// @param size The size of `data`
+/// @return `false` if `write()` failed
+static bool writeAll( const int fd, const void* data, size_t size ) noexcept {
+   const auto* bytes = static_cast< const char* >( data );
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( size > 0 ) {
+      const ssize_t written = write( fd, bytes, size );
+      if( written < 0 && errno == EINTR ) {
+         continue;
+      }
+      if( written <= 0 ) {
+         return false;
+      }
+      bytes += written;  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): Walking the buffer
+      size -= static_cast< size_t >( written );
+   }
+   return true;
+}
+
+
+bool writeLogCrashDump( const int fd, const int signal, const LogCrashClock& clock ) noexcept {
+   const size_t threadRingCount = LogThreadRingCount.load( memory_order_acquire );
+   const size_t moduleCount = logModuleCount();
+
+   LogCrashHeader header {};
+   header.magic = LOG_CRASH_MAGIC;
+   header.version = LOG_CRASH_VERSION;
+   header.recordSize = sizeof( LogEntry );
+   header.logIndex = LogIndex.load( memory_order_acquire );
+   header.queueSize = SIZE_OF_QUEUE;
+   header.threadRingCount = threadRingCount;
+   header.threadRingSize = SIZE_OF_THREAD_RING;
+   header.moduleCount = static_cast< uint32_t >( moduleCount );
+   header.signal = signal;
+   header.clock = clock;
+
+   if( lseek( fd, 0, SEEK_SET ) != 0 || !writeAll( fd, &header, sizeof( header ) ) ) {
+      return false;
+   }
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t id = 0 ; id < moduleCount ; id++ ) {
+      /// No strlen() or strncpy() here:  Copy the name by hand
+      std::array< char, MODULE_NAME_LENGTH > name {};
+      const char* const moduleName = logModuleName( static_cast< LogModuleId >( id ) );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t i = 0 ; i < MODULE_NAME_LENGTH - 1 && moduleName[ i ] != '\0' ; i++ ) {  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): A C string
+         name[ i ] = moduleName[ i ];  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-bounds-constant-array-index ): `i` < MODULE_NAME_LENGTH
+      }
+      if( !writeAll( fd, name.data(), name.size() ) ) {
+         return false;
+      }
+   }
+
+   if( !writeAll( fd, LogQueue.data(), LogQueue.BYTES ) ) {
+      return false;
+   }
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < threadRingCount ; i++ ) {
+      const LogThreadRing& ring = LogThreadRings[ i ];  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `i` < LogThreadRingCount <= MAX_LOG_THREAD_RINGS
+      const uint64_t head = ring.head.load( memory_order_acquire );
+      if( !writeAll( fd, &head, sizeof( head ) ) || !writeAll( fd, ring.entries.data(), ring.entries.BYTES ) ) {
+         return false;
+      }
+   }
+
+   /// A dump can be shorter than the last one
+   const off_t size = lseek( fd, 0, SEEK_CUR );
+   return size >= 0 && ftruncate( fd, size ) == 0;
+}
+
+
+/// Claim the next LogEntry in this thread's LogThreadRing
+///
+/// The same as getNextLogEntry(), except nobody else claims LogEntry records
+/// from `ring`, so there's no read-modify-write and no `writing` latch.
+///
+/// @param ring This thread's LogThreadRing
+/// @param policy The LogOverrunPolicy
+/// @return A pointer to the LogEntry or `nullptr` if it should be dropped
+static LogEntry* getNextThreadRingEntry( LogThreadRing& ring, const LogOverrunPolicy policy ) {
+   const size_t index = ring.head.load( memory_order_relaxed );  // Only this thread writes it
+
+   if( policy != LogOverrunPolicy::dropOldest ) {
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( index - logTail( index, ring.consumerIndexes ) >= SIZE_OF_THREAD_RING ) {
+         if( policy == LogOverrunPolicy::dropNewest ) {
+            LogDropped.fetch_add( 1, memory_order_release );
+            return nullptr;
+         }
+
+         /// LogOverrunPolicy::block:  Let the LogConsumers catch up
+         this_thread::yield();
+      }
+   }
+
+   LogEntry& thisEntry = ring.entries[ index ];
+
+   /// Disable the LogEntry and claim it for this generation, just like
+   /// getNextLogEntry() does, before we move the head
+   atomic_ref< bool >( thisEntry.ready ).store( false, memory_order_relaxed );
+   atomic_ref< uint64_t >( thisEntry.sequence ).store( index, memory_order_release );
+   atomic_thread_fence( memory_order_release );
+
+   ring.head.store( index + 1, memory_order_release );
+
+   /// For performance reasons, we are not zeroing out the LogEntry
+   BOOST_ASSERT_MSG( thisEntry.msg_end == 0, "LogEntry::msg_end marker is not 0" );
+
+   return &thisEntry;
+}
+
+
+LogEntry* getNextLogEntry() {
+   const LogOverrunPolicy policy = LogPolicy.load( memory_order_relaxed );
+   size_t index = 0;
+
+   if( LogMode.load( memory_order_relaxed ) == LogQueueMode::perThread ) {
+      LogThreadRing* const ring = ThisThreadRing.get();
+      if( ring != nullptr ) {
+         return getNextThreadRingEntry( *ring, policy );
+      }
+      /// All of the LogThreadRings are taken.  Use LogQueue.
+   }
+
+   if( policy == LogOverrunPolicy::dropOldest ) {
+      /// Get the LogEntry and increment the queue (thread safe because LogIndex
+      /// is an atomic).  If we lap a LogConsumer, it will notice the
+      /// LogEntry::sequence has changed and count the LogEntry records it lost.
+      index = LogIndex++;
+   } else {
+      /// Only claim a LogEntry if every running LogConsumer is done with it
+      index = LogIndex.load( memory_order_relaxed );
+
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( ;; ) {
+         if( index - logTail( index ) >= SIZE_OF_QUEUE ) {
+            if( policy == LogOverrunPolicy::dropNewest ) {
+               LogDropped.fetch_add( 1, memory_order_release );
+               return nullptr;
+            }
+
+            /// LogOverrunPolicy::block:  Let the LogConsumers catch up
+            this_thread::yield();
+            index = LogIndex.load( memory_order_relaxed );
+            continue;
+         }
+
+         if( LogIndex.compare_exchange_weak( index, index + 1 ) ) {
+            break;
+         }
+      }
+   }
+
+   LogEntry& thisEntry = LogQueue[ index ];
+
+   /// Take ownership of the LogEntry.  It's only held by another producer if
+   /// that producer was lapped while it was composing, so this is rare and
+   /// short.
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( atomic_ref< bool >( thisEntry.writing ).exchange( true, memory_order_acquire ) ) {
+      this_thread::yield();
+   }
+
+   /// If a faster producer already lapped us, our LogEntry is gone.  The
+   /// LogConsumer threads will count it as lost.
+   if( atomic_ref< uint64_t >( thisEntry.sequence ).load( memory_order_relaxed ) > index ) {
+      atomic_ref< bool >( thisEntry.writing ).store( false, memory_order_release );
+      return nullptr;
+   }
+
+   /// Disable the LogEntry, then claim it for this generation of LogQueue.
+   /// The `release` store pairs with the `acquire` load in logSnapshot(), so a
+   /// LogConsumer that sees the new sequence also sees `ready == false`.
+   atomic_ref< bool >( thisEntry.ready ).store( false, memory_order_relaxed );
+   atomic_ref< uint64_t >( thisEntry.sequence ).store( index, memory_order_release );
 
-   /// Disable the LogEntry
-   thisEntry.ready = false;
+   /// Don't let the producer's writes into the LogEntry get ahead of the
+   /// stores above.  This pairs with the `acquire` fence in logSnapshot().
+   atomic_thread_fence( memory_order_release );
 
    /// For performance reasons, we are not zeroing out the LogEntry
    BOOST_ASSERT_MSG( thisEntry.msg_end == 0, "LogEntry::msg_end marker is not 0" );
-   BOOST_ASSERT_MSG( thisEntry.module_end == 0, "LogEntry::module_end marker is not 0" );
 
-   /// Return a reference to the LogEntry
-   return thisEntry;
+   /// Return a pointer to the LogEntry
+   return &thisEntry;
 }
 
 /// Peek at the top of the log
@@ -91,8 +659,7 @@ LogEntry& getNextLogEntry() {
 /// @return A reference to a LogEntry record that's just before LogQueue's
 ///         head pointer
 LogEntry& logPeek() {
-   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): Temporarily disable static bounds checking
-   return LogQueue[ (LogIndex - 1) & LOG_QUEUE_INDEX_MASK ];
+   return LogQueue[ LogIndex - 1 ];
 }
 
 
@@ -18,8 +18,8 @@
 ///      performance.  Log pre-allocates an array of #empire::LogEntry structures,
 ///      managed in a circular queue.  Each #empire::LogEntry is aligned on a
 ///      large boundary and its largest element #empire::LogEntry::msg is aligned
-///      on the same half-boundary. We also map several char-arrays to `(void*)`,
-///      which is generally considered bad practice in modern C++.
+///      on the same half-boundary.  `LOG_MODULE` is registered once and
+///      each #empire::LogEntry just holds its LogModuleId (see LogModule.hpp).
 ///
 /// Be sure to define `LOG_MODULE` and `MIN_LOG_SEVERITY` before including Log.hpp:
 ///
@@ -33,21 +33,41 @@
 ///
 ///     #include "../src/lib/Log.hpp"
 ///
+/// Define `LOG_DEFERRED` before including Log.hpp to have the LogConsumer
+/// threads do the formatting (see queueDeferredLogEntry()).  The `LOG_*`
+/// macros will only take string literals for the format.
+///
+/// Define `LOG_RATE_LIMIT` before including Log.hpp to rate-limit each `LOG_*`
+/// macro and collapse its repeated messages (see LogRateLimit.hpp).
+///
+/// The `LOG_*_KV` macros log structured fields instead of a formatted message
+/// (see LogKv.hpp):
+///
+///     LOG_INFO_KV( "sector moved", "nation", id, "x", x, "y", y );
+///
 /// @file      lib/Log.hpp
 /// @author    Mark Nelson <mr_nelson@icloud.com>
 /// @copyright (c) 2023 Mark Nelson.  All rights reserved.
 ///////////////////////////////////////////////////////////////////////////////
 
-#include <chrono>   // For system_clock
-#include <cstdarg>  // For va_list, va_start() va_end()
-#include <cstdint>  // For uint16_t, uint64_t
-#include <cstdio>   // For vsnprintf()
-#include <cstring>  // For memcpy()
+#include <algorithm>  // For min()
+#include <array>      // For array<>
+#include <atomic>     // For atomic_ref<>
+#include <chrono>     // For system_clock
+#include <cstdarg>    // For va_list, va_start() va_end()
+#include <cstdint>    // For uint16_t, uint64_t
+#include <cstdio>     // For snprintf() vsnprintf()
+#include <cstring>    // For memcpy() strnlen()
 
 #include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
 
+#include "LogArgs.hpp"
+#include "LogClock.hpp"
 #include "LogConfig.hpp"
 #include "LogEntry.hpp"
+#include "LogKv.hpp"
+#include "LogModule.hpp"
+#include "LogRateLimit.hpp"
 #include "LogSeverity.hpp"
 
 namespace empire {
@@ -56,8 +76,107 @@ namespace empire {
 
 /// Retrieve the next available LogEntry from empire::LogQueue
 ///
-/// @return A reference to a LogEntry record that's ready to be written to
-extern LogEntry& getNextLogEntry();
+/// What happens when empire::LogQueue is full depends on the
+/// LogOverrunPolicy.  See setLogOverrunPolicy().
+///
+/// Under LogQueueMode::perThread, the LogEntry comes from this thread's own
+/// ring instead.  See setLogQueueMode().
+///
+/// The producer owns the LogEntry until it calls publishLogEntry().
+///
+/// @return A pointer to a LogEntry record that's ready to be written to or
+///         `nullptr` if the LogEntry should be dropped
+extern LogEntry* getNextLogEntry();
+
+
+/// Set what producers do when they would overwrite a LogEntry that a running
+/// LogConsumer hasn't processed yet
+///
+/// Be careful with LogOverrunPolicy::block:  A LogSink that logs can deadlock
+/// its own LogConsumer.
+///
+/// @param policy The new LogOverrunPolicy
+extern void setLogOverrunPolicy( LogOverrunPolicy policy );
+
+
+/// Get what producers do when empire::LogQueue is full
+///
+/// @return The current LogOverrunPolicy
+extern LogOverrunPolicy getLogOverrunPolicy();
+
+
+/// Set where producers put their LogEntry records
+///
+/// Under LogQueueMode::perThread, each thread registers its own
+/// single-producer ring the first time it logs, so producers never touch the
+/// shared empire::LogIndex.  The LogConsumer threads merge the rings in
+/// LogEntry::logTimestamp order.  The LogOverrunPolicy applies to each ring.
+///
+/// The mode can change while threads are logging.  A LogConsumer drains
+/// empire::LogQueue and the rings separately, so LogEntry records written
+/// before and after the change aren't merged with each other.
+///
+/// @param mode The new LogQueueMode
+extern void setLogQueueMode( LogQueueMode mode );
+
+
+/// Get where producers put their LogEntry records
+///
+/// @return The current LogQueueMode
+extern LogQueueMode getLogQueueMode();
+
+
+/// Wake up the LogConsumer threads after a LogEntry is ready
+extern void postNewLog();
+
+
+/// Dump the raw log rings to the file from installLogCrashHandler()
+///
+/// `LOG_FATAL` calls this after it queues its LogEntry.  It does nothing if
+/// there's no crash handler installed (see LogCrash.hpp).
+extern void logCrashDump() noexcept;
+
+
+/// Tell the LogConsumer threads that a LogEntry from getNextLogEntry() is ready
+///
+/// The `release` store to LogEntry::ready guarantees that a LogConsumer that
+/// sees `ready == true` (with an `acquire` load) also sees everything the
+/// producer wrote into the LogEntry.
+///
+/// @param thisEntry The LogEntry to publish
+inline void publishLogEntry( LogEntry& thisEntry ) {
+   std::atomic_ref< bool >( thisEntry.ready ).store( true, std::memory_order_release );  // Tell the LogConsumer routines that this LogEntry is ready
+   std::atomic_ref< bool >( thisEntry.writing ).store( false, std::memory_order_release );  // Let the next producer have it
+
+   postNewLog();
+}
+
+
+/// Claim the next LogEntry and fill in everything but the message
+///
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @return The LogEntry (owned by the caller until it calls
+///         publishLogEntry()) or `nullptr` if it should be dropped
+inline LogEntry* beginLogEntry( const LogSeverity severity
+                              , const LogModuleId moduleId ) {
+   BOOST_ASSERT_MSG( severity >= LogSeverity::test && severity <= LogSeverity::fatal, "Log severity not in range" );
+
+   LogEntry* const nextEntry = getNextLogEntry();
+   if( nextEntry == nullptr ) {
+      return nullptr;  // LogOverrunPolicy::dropNewest discarded this LogEntry (or a faster producer lapped us)
+   }
+
+   LogEntry& thisEntry = *nextEntry;
+   BOOST_ASSERT_MSG( thisEntry.msg_end == 0, "LogEntry::msg_end marker is not 0" );
+   BOOST_ASSERT_MSG( std::atomic_ref< bool >( thisEntry.ready ).load( std::memory_order_relaxed ) == false, "LogEntry::ready is not false" );
+
+   thisEntry.logSeverity = severity;
+   thisEntry.moduleId = moduleId;
+   thisEntry.schema = nullptr;
+
+   return nextEntry;
+}
 
 
 /// Add a new log entry to empire::LogQueue
@@ -71,41 +190,25 @@ extern LogEntry& getNextLogEntry();
 ///    the `LOG_MODULE` and `MIN_LOG_SEVERITY` definitions.
 ///
 /// @param severity The severity of the LogEntry
-/// @param module_name The name of the module responsible for this LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
 /// @param fmt The `printf`-style format string
 /// @NOLINTBEGIN( cert-dcl50-cpp, cppcoreguidelines-pro-type-vararg, hicpp-vararg ): We will allow a C-style variadic function
 /// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
 /// @NOLINTBEGIN( cert-err33-c ): No need to check the return value from `vsnprintf()`
 inline void queueLogEntry( const LogSeverity severity
-                         , const char* module_name
+                         , const LogModuleId moduleId
                          , const char* fmt
                          , ... ) {
 
-   BOOST_ASSERT_MSG( module_name != nullptr , "Module name can't be NULL" );
-   BOOST_ASSERT_MSG( strlen( module_name ) < MODULE_NAME_LENGTH, "Module name must be < MODULE_NAME_LENGTH" );
    BOOST_ASSERT_MSG( fmt != nullptr, "Log format parameter can't be NULL" );
-   BOOST_ASSERT_MSG( severity >= LogSeverity::test && severity <= LogSeverity::fatal, "Log severity not in range" );
-
-   LogEntry& thisEntry = getNextLogEntry();
-   BOOST_ASSERT_MSG( thisEntry.msg_end == 0, "LogEntry::msg_end marker is not 0" );
-   BOOST_ASSERT_MSG( thisEntry.module_end == 0, "LogEntry::module_end marker is not 0" );
-   BOOST_ASSERT_MSG( thisEntry.ready == false, "LogEntry::ready is not false" );
-
-   thisEntry.logSeverity = severity;
 
-   /// Use an efficient copy command to populate the module_name
-   // @API{ memcpy, https://en.cppreference.com/w/cpp/string/byte/memcpy }
-   // memcpy( thisEntry.module_name, module_name, MODULE_NAME_LENGTH );
+   LogEntry* const nextEntry = beginLogEntry( severity, moduleId );
+   if( nextEntry == nullptr ) {
+      return;
+   }
 
-   /// @NOLINTBEGIN( cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): Need to cast for inline assembly
-   asm( "vmovdqa %0, %%ymm8 ;"  // Copy module_name into YMM8
-        "vmovdqa %%ymm8, %1 ;"  // Copy YMM8 into thisEntry.module_name
-         :
-         :  "m" (*reinterpret_cast<const char (*)[sizeof( module_name )]>(module_name))                      // Input %0
-         ,  "m" (*reinterpret_cast<const char (*)[sizeof( thisEntry.module_name )]>(thisEntry.module_name))  // Input %1
-         :  "%ymm8"           // Clobbered
-   );
-   // @NOLINTEND( cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays )
+   LogEntry& thisEntry = *nextEntry;
+   thisEntry.fmt = nullptr;
 
    /// @API{ va_list, https://en.cppreference.com/w/cpp/utility/variadic/va_list }
    va_list args;
@@ -114,73 +217,337 @@ inline void queueLogEntry( const LogSeverity severity
    vsnprintf( thisEntry.msg, LOG_MSG_LENGTH, fmt, args );  /// @NOLINT( clang-analyzer-valist.Uninitialized ): `va_start()` initializes `args`.
    va_end( args );
 
-   thisEntry.logTimestamp = std::time( nullptr );
+   thisEntry.logTimestamp = logClockNow();
+
+   publishLogEntry( thisEntry );
+}
+
+
+/// Add a new log entry to empire::LogQueue, but let the LogConsumer format it
+///
+/// The producer copies the arguments (see packLogArgs()) and the pointer to
+/// `fmt` into the LogEntry.  The LogConsumer calls expandLogEntry() before
+/// it hands the LogEntry to its LogSink objects.  If the arguments don't fit
+/// in LogEntry::msg, it falls back to formatting the LogEntry here.
+///
+/// `fmt` must outlive the LogEntry.  The `LOG_*` macros only take string
+/// literals in this mode.
+///
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @param fmt The `printf`-style format string
+/// @param args The arguments for `fmt`
+template< typename... Args >
+inline void queueDeferredLogEntry( const LogSeverity severity
+                                 , const LogModuleId moduleId
+                                 , const char* fmt
+                                 , const Args&... args ) {
+
+   BOOST_ASSERT_MSG( fmt != nullptr, "Log format parameter can't be NULL" );
+
+   LogEntry* const nextEntry = beginLogEntry( severity, moduleId );
+   if( nextEntry == nullptr ) {
+      return;
+   }
+
+   LogEntry& thisEntry = *nextEntry;
+
+   if( packLogArgs( thisEntry.msg, args... ) ) {
+      thisEntry.fmt = fmt;
+   } else {
+      if constexpr( sizeof...( Args ) > 0 ) {
+         /// @API{ snprintf, https://en.cppreference.com/w/cpp/io/c/fprintf }
+         const int length = snprintf( thisEntry.msg, LOG_MSG_LENGTH, fmt, args... );
+
+         /// A longer message is cut to `LOG_MSG_LENGTH - 1` characters, just
+         /// like queueLogEntry().  An encoding error leaves an empty message.
+         if( length < 0 ) {
+            thisEntry.msg[ 0 ] = '\0';
+         }
+      }
+      thisEntry.fmt = nullptr;
+   }
+
+   thisEntry.logTimestamp = logClockNow();
+
+   publishLogEntry( thisEntry );
+}
+
+
+/// Copy a message into a new LogEntry and queue it
+///
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @param fmt The format string to put in LogEntry::fmt (or `nullptr` if
+///            `msg` is already formatted)
+/// @param msg The message or the packed arguments (empire::LOG_MSG_LENGTH bytes)
+inline void queueLogMessage( const LogSeverity severity
+                           , const LogModuleId moduleId
+                           , const char* fmt
+                           , const char* msg ) {
+   LogEntry* const nextEntry = beginLogEntry( severity, moduleId );
+   if( nextEntry == nullptr ) {
+      return;
+   }
+
+   LogEntry& thisEntry = *nextEntry;
+   memcpy( thisEntry.msg, msg, LOG_MSG_LENGTH );
+   thisEntry.fmt = fmt;
+
+   thisEntry.logTimestamp = logClockNow();
+
+   publishLogEntry( thisEntry );
+}
+
+
+/// Add a new log entry to empire::LogQueue, subject to its call site's rate
+/// limit (see LogRateLimit.hpp)
+///
+/// The message is formatted on the stack, so it can be compared with the call
+/// site's last message before it takes a LogEntry.
+///
+/// @param site The `static` LogCallSite of the `LOG_*` macro
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @param fmt The `printf`-style format string
+inline void queueLimitedLogEntry( LogCallSite& site
+                                , const LogSeverity severity
+                                , const LogModuleId moduleId
+                                , const char* fmt
+                                , ... ) {
+
+   BOOST_ASSERT_MSG( fmt != nullptr, "Log format parameter can't be NULL" );
+
+   std::array< char, LOG_MSG_LENGTH > msg;  // NOLINT( cppcoreguidelines-pro-type-member-init, hicpp-member-init ): vsnprintf() fills it
+
+   va_list args;
+   va_start( args, fmt );
+   const int length = vsnprintf( msg.data(), msg.size(), fmt, args );  /// @NOLINT( clang-analyzer-valist.Uninitialized ): `va_start()` initializes `args`.
+   va_end( args );
+
+   const size_t hashed = ( length < 0 ) ? 0 : std::min( static_cast< size_t >( length ), msg.size() - 1 );
+   if( logCallSiteAdmit( site, severity, moduleId, logHashMessage( fmt, msg.data(), hashed ) ) ) {
+      queueLogMessage( severity, moduleId, nullptr, msg.data() );
+   }
+}
+
+
+/// Add a new log entry to empire::LogQueue, subject to its call site's rate
+/// limit (see LogRateLimit.hpp), and let the LogConsumer format it (see
+/// queueDeferredLogEntry())
+///
+/// The arguments are packed on the stack, so they can be compared with the
+/// call site's last LogEntry before it takes a LogEntry.
+///
+/// @param site The `static` LogCallSite of the `LOG_*` macro
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @param fmt The `printf`-style format string
+/// @param args The arguments for `fmt`
+template< typename... Args >
+inline void queueLimitedDeferredLogEntry( LogCallSite& site
+                                        , const LogSeverity severity
+                                        , const LogModuleId moduleId
+                                        , const char* fmt
+                                        , const Args&... args ) {
+
+   BOOST_ASSERT_MSG( fmt != nullptr, "Log format parameter can't be NULL" );
+
+   std::array< char, LOG_MSG_LENGTH > msg;  // NOLINT( cppcoreguidelines-pro-type-member-init, hicpp-member-init ): It's packed or formatted below
+
+   const char* entryFmt = fmt;
+   size_t length = ( size_t { 0 } + ... + logArgPackedSize( args ) );
+   if( !packLogArgs( msg.data(), args... ) ) {
+      length = 0;
+      if constexpr( sizeof...( Args ) > 0 ) {
+         const int formatted = snprintf( msg.data(), msg.size(), fmt, args... );
 
-   thisEntry.ready = true;  // Tell the LogConsumer routines that this LogEntry is ready
+         /// Just like queueLimitedLogEntry():  An encoding error leaves an
+         /// empty message.
+         if( formatted < 0 ) {
+            msg[ 0 ] = '\0';
+         } else {
+            length = std::min( static_cast< size_t >( formatted ), msg.size() - 1 );
+         }
+      }
+      entryFmt = nullptr;
+   }
+
+   if( logCallSiteAdmit( site, severity, moduleId, logHashMessage( fmt, msg.data(), length ) ) ) {
+      queueLogMessage( severity, moduleId, entryFmt, msg.data() );
+   }
 }
 
 
+/// Add a new structured LogEntry to empire::LogQueue
+///
+/// The values are packed into LogEntry::msg (see packLogKvValues()) and
+/// LogEntry::schema points to the call site's LogKvSchema.  Nothing is
+/// formatted here:  A LogSink decodes it (see LogKv.hpp).  Use the `LOG_*_KV`
+/// macros, which build the LogKvSchema at compile time.
+///
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the module responsible for this LogEntry
+/// @param schema The call site's LogKvSchema.  It must outlive the LogEntry.
+/// @param values The value of each field in `schema`
+template< typename... Values >
+inline void queueKvLogEntry( const LogSeverity severity
+                           , const LogModuleId moduleId
+                           , const LogKvSchema& schema
+                           , const Values&... values ) {
+
+   BOOST_ASSERT_MSG( schema.fieldCount == sizeof...( Values ), "The LogKvSchema doesn't match the values" );
+
+   LogEntry* const nextEntry = beginLogEntry( severity, moduleId );
+   if( nextEntry == nullptr ) {
+      return;
+   }
+
+   LogEntry& thisEntry = *nextEntry;
+   thisEntry.fmt = nullptr;
+
+   packLogKvValues( thisEntry.msg, values... );
+   thisEntry.schema = &schema;
+
+   thisEntry.logTimestamp = logClockNow();
+
+   publishLogEntry( thisEntry );
+}
+
+
+/// The LogModuleId of `LOG_MODULE` in this source file
+///
+/// Each source file that includes Log.hpp registers its `LOG_MODULE` once,
+/// when it's statically initialized.  It's defined here, ahead of anything
+/// in the source file that could log, so it's always ready before it's used.
+[[maybe_unused]] static const LogModuleId LOG_MODULE_ID { registerLogModule( LOG_MODULE ) };
+
+
+/// Queue a LogEntry if its module logs at `severity` (see setLogSeverity()).
+/// Use deferred formatting if `LOG_DEFERRED` is defined before including Log.hpp.
+/// Give each call site a LogCallSite if `LOG_RATE_LIMIT` is defined.
+#if defined( LOG_RATE_LIMIT ) && defined( LOG_DEFERRED )
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_QUEUE_ENTRY( severity, fmt, ... ) ( logSeverityEnabled( LOG_MODULE_ID, severity ) ? [ & ]() { static LogCallSite site {}; queueLimitedDeferredLogEntry( site, severity, LOG_MODULE_ID, "" fmt __VA_OPT__(,) __VA_ARGS__ ); }() : void() )
+#elif defined( LOG_RATE_LIMIT )
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_QUEUE_ENTRY( severity, fmt, ... ) ( logSeverityEnabled( LOG_MODULE_ID, severity ) ? [ & ]() { static LogCallSite site {}; queueLimitedLogEntry( site, severity, LOG_MODULE_ID, fmt __VA_OPT__(,) __VA_ARGS__ ); }() : void() )
+#elif defined( LOG_DEFERRED )
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_QUEUE_ENTRY( severity, fmt, ... ) ( logSeverityEnabled( LOG_MODULE_ID, severity ) ? queueDeferredLogEntry( severity, LOG_MODULE_ID, "" fmt __VA_OPT__(,) __VA_ARGS__ ) : void() )
+#else
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_QUEUE_ENTRY( severity, fmt, ... ) ( logSeverityEnabled( LOG_MODULE_ID, severity ) ? queueLogEntry( severity, LOG_MODULE_ID, fmt __VA_OPT__(,) __VA_ARGS__ ) : void() )
+#endif
+
+
+/// Queue a structured LogEntry if its module logs at `severity`
+///
+/// The arguments after `message` are `key, value` pairs (at least 1 and at
+/// most empire::MAX_LOG_KV_FIELDS).  `message` and the keys must be string
+/// literals.  Each value is evaluated once.  The LogKvSchema is a `static
+/// constexpr` in the lambda, so there's one per call site.
+/// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+#define LOG_KV_ENTRY( severity, message, ... )                                                                                    \
+   ( logSeverityEnabled( LOG_MODULE_ID, severity ) ? [ & ]() {                                                                   \
+      static_assert( LOG_KV_COUNT( __VA_ARGS__ ) <= empire::MAX_LOG_KV_FIELDS, "Too many structured log fields" );               \
+      static constexpr std::array< const char*, LOG_KV_COUNT( __VA_ARGS__ ) > keys { LOG_KV_FOR_EACH( LOG_KV_KEY, __VA_ARGS__ ) };  \
+      static constexpr std::array< empire::LogArgType, keys.size() > types { LOG_KV_FOR_EACH( LOG_KV_TYPE, __VA_ARGS__ ) };     \
+      static constexpr empire::LogKvSchema schema { "" message, keys.size(), keys.data(), types.data() };                       \
+      queueKvLogEntry( severity, LOG_MODULE_ID, schema, LOG_KV_FOR_EACH( LOG_KV_VALUE, __VA_ARGS__ ) );                         \
+   }() : void() )
+
+
 /// Use for Boost Unit Tests
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_TEST
     /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_TEST( fmt, ... ) queueLogEntry( LogSeverity::test, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_TEST( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::test, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_TEST_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::test, message, __VA_ARGS__ )
 #else
    /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_TEST( fmt, ... )
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_TEST_KV( message, ... )
 #endif
 
 /// Use when trying follow the thread of execution through code
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_TRACE
     /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_TRACE( fmt, ... ) queueLogEntry( LogSeverity::trace, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_TRACE( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::trace, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_TRACE_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::trace, message, __VA_ARGS__ )
 #else
    /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_TRACE( fmt, ... )
+   /// @NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_TRACE_KV( message, ... )
 #endif
 
 /// Information that is diagnostically helpful
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_DEBUG
     /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_DEBUG( fmt, ... ) queueLogEntry( LogSeverity::debug, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_DEBUG( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::debug, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_DEBUG_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::debug, message, __VA_ARGS__ )
 #else
    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_DEBUG( fmt, ... )
+   /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_DEBUG_KV( message, ... )
 #endif
 
 /// Generally useful information
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_INFO
     /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_INFO( fmt, ... ) queueLogEntry( LogSeverity::info, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_INFO( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::info, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_INFO_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::info, message, __VA_ARGS__ )
 #else
    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_INFO( fmt, ... )
+   /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_INFO_KV( message, ... )
 #endif
 
 /// Anything that can potentially cause application oddities
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_WARNING
     /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_WARN( fmt, ... ) queueLogEntry( LogSeverity::warning, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_WARN( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::warning, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_WARN_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::warning, message, __VA_ARGS__ )
 #else
    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_WARN( fmt, ... )
+   /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_WARN_KV( message, ... )
 #endif
 
 /// Any error which is fatal to an **operation**
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_ERROR
     /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_ERROR( fmt, ... ) queueLogEntry( LogSeverity::error, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_ERROR( fmt, ... ) LOG_QUEUE_ENTRY( LogSeverity::error, fmt __VA_OPT__(,) __VA_ARGS__ )
+    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_ERROR_KV( message, ... ) LOG_KV_ENTRY( LogSeverity::error, message, __VA_ARGS__ )
 #else
    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_ERROR( fmt, ... )
+   /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_ERROR_KV( message, ... )
 #endif
 
-/// Any error which is fatal to the **process**
+/// Any error which is fatal to the **process**.  It also writes a crash dump
+/// (see logCrashDump()).
 #if MIN_LOG_SEVERITY <= LOG_SEVERITY_FATAL
     /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
-   #define LOG_FATAL( fmt, ... ) queueLogEntry( LogSeverity::fatal, LOG_MODULE, fmt __VA_OPT__(,) __VA_ARGS__ )
+   #define LOG_FATAL( fmt, ... ) ( LOG_QUEUE_ENTRY( LogSeverity::fatal, fmt __VA_OPT__(,) __VA_ARGS__ ), logCrashDump() )
+    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_FATAL_KV( message, ... ) ( LOG_KV_ENTRY( LogSeverity::fatal, message, __VA_ARGS__ ), logCrashDump() )
 #else
    /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
    #define LOG_FATAL( fmt, ... )
+   /// NOLINTNEXTLINE( cppcoreguidelines-macro-usage ): We intend to use a macro here
+   #define LOG_FATAL_KV( message, ... )
 #endif
 
 // NOLINTEND( cert-err33-c )
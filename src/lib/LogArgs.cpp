@@ -0,0 +1,229 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Format the packed arguments of a deferred LogEntry
+///
+/// @file      LogArgs.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>    // For array<>
+#include <cstdio>   // For snprintf()
+#include <cstring>  // For memcpy() memchr() strchr()
+
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+
+#include "LogArgs.hpp"
+
+using namespace std;
+
+namespace empire {
+
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the format and the packed arguments with pointers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): We are using `snprintf()`
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+
+namespace {
+
+/// Read an `int` argument for a `*` width or precision
+///
+/// @param reader The packed arguments
+/// @param value Where to put the value
+/// @return `false` if the next argument is not an `int`
+bool readStar( LogArgReader& reader, int& value ) {
+   if( reader.peek() != LogArgType::signedInt && reader.peek() != LogArgType::unsignedInt ) {
+      return false;
+   }
+   return reader.read( value );
+}
+
+} // namespace
+
+
+size_t formatLogArgs( const char* fmt, const char* args, const size_t argsSize, char* buffer, const size_t bufferSize ) {
+   BOOST_ASSERT_MSG( fmt != nullptr, "Log format parameter can't be NULL" );
+   BOOST_ASSERT_MSG( buffer != nullptr, "Buffer can't be NULL" );
+   BOOST_ASSERT_MSG( bufferSize > 0, "Buffer must have room for a null" );
+
+   LogArgReader reader( args, argsSize );
+   size_t length = 0;
+
+   /// Append to `buffer` (if there's room) and keep track of the length
+   auto append = [ & ]( const int written ) {
+      if( written > 0 ) {
+         length += static_cast< size_t >( written );
+      }
+      if( length >= bufferSize ) {
+         length = bufferSize - 1;
+      }
+   };
+
+   const char* p = fmt;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( *p != '\0' && length < bufferSize - 1 ) {
+      if( *p != '%' ) {
+         buffer[ length++ ] = *p++;
+         continue;
+      }
+
+      if( p[ 1 ] == '%' ) {
+         buffer[ length++ ] = '%';
+         p += 2;
+         continue;
+      }
+
+      /// Copy the flags, width and precision of the conversion into `spec`
+      /// and then add the length modifier for the type that was packed
+      array< char, 32 > spec {};  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Longer than any sane conversion
+      size_t specLength = 0;
+      array< int, 2 > stars {};
+      size_t starCount = 0;
+      bool ok = true;
+
+      spec[ specLength++ ] = *p++;  // The `%`
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( *p != '\0' && strchr( "-+ #0123456789.*'", *p ) != nullptr ) {
+         if( *p == '*' ) {
+            if( starCount < stars.size() && readStar( reader, stars[ starCount ] ) ) {  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `starCount` is checked
+               starCount += 1;
+            } else {
+               ok = false;
+            }
+         }
+         if( specLength < spec.size() - 4 ) {
+            spec[ specLength++ ] = *p;
+         }
+         p += 1;
+      }
+
+      /// Skip the caller's length modifier, but remember `h` and `hh`
+      const char* const modifier = p;
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( *p != '\0' && strchr( "hlLqjzt", *p ) != nullptr ) {
+         p += 1;
+      }
+      const bool isShort = ( modifier[ 0 ] == 'h' );
+      const bool isChar  = isShort && modifier[ 1 ] == 'h';
+
+      const char conversion = *p;
+      if( conversion == '\0' ) {
+         break;  // A dangling `%`
+      }
+      p += 1;
+
+      if( conversion == 'n' ) {
+         reader.skip();  // Never write through a pointer from a LogEntry
+         continue;
+      }
+
+      const LogArgType type = reader.peek();
+      const bool isInteger  = strchr( "diouxX", conversion ) != nullptr
+                           || ( conversion == 'c' && ( type == LogArgType::signedInt || type == LogArgType::unsignedInt ) );
+      const bool isFloat    = strchr( "fFeEgGaA", conversion ) != nullptr;
+
+      ok = ok && ( ( isInteger && type >= LogArgType::signedInt && type <= LogArgType::unsignedLongLong )
+                || ( isFloat && ( type == LogArgType::floatingPoint || type == LogArgType::longDouble ) )
+                || ( conversion == 's' && type == LogArgType::string )
+                || ( conversion == 'p' && type == LogArgType::pointer ) );
+
+      if( !ok ) {
+         if( type != LogArgType::end ) {
+            reader.skip();
+         }
+         append( snprintf( buffer + length, bufferSize - length, "(?)" ) );
+         continue;
+      }
+
+      /// The right length modifier for the packed type
+      switch( type ) {
+         case LogArgType::signedInt:
+         case LogArgType::unsignedInt:
+            if( isChar && conversion != 'c' ) {
+               spec[ specLength++ ] = 'h';
+            }
+            if( isShort && conversion != 'c' ) {
+               spec[ specLength++ ] = 'h';
+            }
+            break;
+         case LogArgType::signedLong:
+         case LogArgType::unsignedLong:
+            spec[ specLength++ ] = 'l';
+            break;
+         case LogArgType::signedLongLong:
+         case LogArgType::unsignedLongLong:
+            spec[ specLength++ ] = 'l';
+            spec[ specLength++ ] = 'l';
+            break;
+         case LogArgType::longDouble:
+            spec[ specLength++ ] = 'L';
+            break;
+         default:
+            break;
+      }
+      spec[ specLength++ ] = conversion;
+      spec[ specLength ] = '\0';
+
+      char* const out = buffer + length;
+      const size_t room = bufferSize - length;
+
+      /// Call `snprintf()` with the `*` arguments (if any) and then the value
+      auto print = [ & ]( auto value ) {
+         switch( starCount ) {
+            case 0:  return snprintf( out, room, spec.data(), value );
+            case 1:  return snprintf( out, room, spec.data(), stars[ 0 ], value );
+            default: return snprintf( out, room, spec.data(), stars[ 0 ], stars[ 1 ], value );
+         }
+      };
+
+      /// Read the packed value as `T` and print it
+      auto readAndPrint = [ & ]< typename T >( T value ) {
+         if( reader.read( value ) ) {
+            append( print( value ) );
+         } else {
+            append( snprintf( out, room, "(?)" ) );
+         }
+      };
+
+      switch( type ) {
+         case LogArgType::signedInt:        readAndPrint( int {} );                break;
+         case LogArgType::unsignedInt:      readAndPrint( static_cast< unsigned int >( 0 ) ); break;
+         case LogArgType::signedLong:       readAndPrint( long {} );               break;
+         case LogArgType::unsignedLong:     readAndPrint( static_cast< unsigned long >( 0 ) ); break;
+         case LogArgType::signedLongLong:   readAndPrint( static_cast< long long >( 0 ) );    break;
+         case LogArgType::unsignedLongLong: readAndPrint( static_cast< unsigned long long >( 0 ) ); break;
+         case LogArgType::floatingPoint:    readAndPrint( double {} );             break;
+         case LogArgType::longDouble:       readAndPrint( static_cast< long double >( 0 ) );  break;
+         case LogArgType::pointer:          readAndPrint( static_cast< const void* >( nullptr ) ); break;
+         case LogArgType::string: {
+            const char* const str = reader.readString();
+            append( str != nullptr ? print( str ) : snprintf( out, room, "(?)" ) );
+            break;
+         }
+         case LogArgType::end:
+            break;
+      }
+   }
+
+   buffer[ length ] = '\0';
+   return length;
+}
+
+
+void expandLogEntry( LogEntry& entry ) {
+   if( entry.fmt == nullptr ) {
+      return;
+   }
+
+   array< char, LOG_MSG_LENGTH > formatted {};
+   formatLogArgs( entry.fmt, entry.msg, LOG_MSG_LENGTH, formatted.data(), formatted.size() );
+
+   memcpy( entry.msg, formatted.data(), LOG_MSG_LENGTH );
+   entry.fmt = nullptr;
+}
+
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+} // namespace empire
@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Pack `printf` arguments into a LogEntry so a LogConsumer can format them
+///
+/// A deferred LogEntry holds its format string in LogEntry::fmt and its
+/// arguments, packed, in LogEntry::msg.  Each argument is a one-byte
+/// LogArgType followed by the argument's bytes.  Strings are copied (with
+/// their null terminator) because the caller's string won't be around when
+/// the LogConsumer gets to it.  A LogArgType::end byte follows the last
+/// argument if there's room.
+///
+/// The argument types are captured at compile time, after C's default
+/// argument promotions, so the LogConsumer hands `snprintf()` exactly the
+/// types the producer would have passed to it.
+///
+/// @file      LogArgs.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t
+#include <cstring>      // For memcpy() memchr() strlen()
+#include <type_traits>  // For decay_t<> is_same_v<> underlying_type_t<>
+
+#include "LogConfig.hpp"  // For LOG_MSG_LENGTH
+#include "LogEntry.hpp"
+
+namespace empire {
+
+/// The type of each packed argument in a deferred LogEntry
+enum class LogArgType : uint8_t {
+   end = 0,           ///< There are no more arguments
+   signedInt,         ///< `int` (and everything that promotes to it)
+   unsignedInt,       ///< `unsigned int`
+   signedLong,        ///< `long`
+   unsignedLong,      ///< `unsigned long`
+   signedLongLong,    ///< `long long`
+   unsignedLongLong,  ///< `unsigned long long`
+   floatingPoint,     ///< `double` (and `float`)
+   longDouble,        ///< `long double`
+   pointer,           ///< Any pointer that's not a string
+   string             ///< A null-terminated string copied into the LogEntry
+};
+
+
+/// The argument type `printf()` would see after the default argument promotions
+///
+/// @tparam T The type of the argument
+template< typename T >
+struct LogArgTraits {
+   /// The promoted type
+   using Decayed = std::decay_t< T >;
+
+   static_assert( std::is_arithmetic_v< Decayed > || std::is_enum_v< Decayed > || std::is_pointer_v< Decayed > || std::is_null_pointer_v< Decayed >
+                , "Log arguments must be arithmetic types, enums, pointers or strings" );
+
+   /// Get the LogArgType for `T`
+   ///
+   /// @return The LogArgType that `T` is packed as
+   static consteval LogArgType type() {
+      if constexpr( std::is_null_pointer_v< Decayed > ) {
+         return LogArgType::pointer;
+      } else if constexpr( std::is_pointer_v< Decayed > ) {
+         if constexpr( std::is_same_v< std::remove_cv_t< std::remove_pointer_t< Decayed > >, char > ) {
+            return LogArgType::string;
+         } else {
+            return LogArgType::pointer;
+         }
+      } else if constexpr( std::is_enum_v< Decayed > ) {
+         return LogArgTraits< std::underlying_type_t< Decayed > >::type();
+      } else if constexpr( std::is_floating_point_v< Decayed > ) {
+         return std::is_same_v< Decayed, long double > ? LogArgType::longDouble : LogArgType::floatingPoint;
+      } else {
+         /// Unary `+` applies the integer promotions
+         using Promoted = decltype( +Decayed {} );
+         if constexpr( std::is_same_v< Promoted, int > )                     { return LogArgType::signedInt; }
+         else if constexpr( std::is_same_v< Promoted, unsigned int > )       { return LogArgType::unsignedInt; }
+         else if constexpr( std::is_same_v< Promoted, long > )               { return LogArgType::signedLong; }
+         else if constexpr( std::is_same_v< Promoted, unsigned long > )      { return LogArgType::unsignedLong; }
+         else if constexpr( std::is_same_v< Promoted, long long > )          { return LogArgType::signedLongLong; }
+         else                                                                { return LogArgType::unsignedLongLong; }
+      }
+   }
+};
+
+
+/// The number of bytes a packed value of `type` takes (not including its
+/// LogArgType byte).  Strings are variable length and return 0.
+///
+/// @param type The LogArgType
+/// @return The size of the packed value
+constexpr size_t logArgSize( const LogArgType type ) {
+   switch( type ) {
+      case LogArgType::signedInt:        return sizeof( int );
+      case LogArgType::unsignedInt:      return sizeof( unsigned int );
+      case LogArgType::signedLong:       return sizeof( long );
+      case LogArgType::unsignedLong:     return sizeof( unsigned long );
+      case LogArgType::signedLongLong:   return sizeof( long long );
+      case LogArgType::unsignedLongLong: return sizeof( unsigned long long );
+      case LogArgType::floatingPoint:    return sizeof( double );
+      case LogArgType::longDouble:       return sizeof( long double );
+      case LogArgType::pointer:          return sizeof( const void* );
+      case LogArgType::end:
+      case LogArgType::string:           return 0;
+   }
+   return 0;
+}
+
+
+/// The number of bytes an argument will take in LogEntry::msg
+///
+/// @param arg The argument
+/// @return The packed size, including its LogArgType byte
+template< typename T >
+inline size_t logArgPackedSize( const T& arg ) {
+   constexpr LogArgType type = LogArgTraits< T >::type();
+   if constexpr( type == LogArgType::string ) {
+      const char* const str = arg;
+      return 1 + ( str == nullptr ? sizeof( "(null)" ) : strlen( str ) + 1 );
+   } else {
+      return 1 + logArgSize( type );
+   }
+}
+
+
+/// Pack one argument into `buffer`
+///
+/// @param buffer Where to put the argument.  The caller checked that it fits.
+/// @param arg The argument
+/// @return The number of bytes written
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the packed buffer with pointers
+template< typename T >
+inline size_t packLogArg( char* buffer, const T& arg ) {
+   constexpr LogArgType type = LogArgTraits< T >::type();
+   buffer[ 0 ] = static_cast< char >( type );
+
+   if constexpr( type == LogArgType::string ) {
+      const char* str = arg;
+      if( str == nullptr ) {
+         str = "(null)";
+      }
+      const size_t length = strlen( str ) + 1;
+      memcpy( buffer + 1, str, length );
+      return 1 + length;
+   } else if constexpr( type == LogArgType::pointer ) {
+      const void* const ptr = arg;
+      memcpy( buffer + 1, &ptr, sizeof( ptr ) );
+      return 1 + sizeof( ptr );
+   } else if constexpr( type == LogArgType::floatingPoint ) {
+      const double value = arg;
+      memcpy( buffer + 1, &value, sizeof( value ) );
+      return 1 + sizeof( value );
+   } else if constexpr( std::is_enum_v< std::decay_t< T > > ) {
+      return packLogArg( buffer, static_cast< std::underlying_type_t< std::decay_t< T > > >( arg ) );
+   } else {
+      const auto value = +arg;  // Unary `+` applies the integer promotions
+      memcpy( buffer + 1, &value, sizeof( value ) );
+      return 1 + sizeof( value );
+   }
+}
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+
+/// Pack the arguments of a `LOG_*` macro into `buffer`
+///
+/// @param buffer Where to pack the arguments.  Usually LogEntry::msg.
+/// @param args The arguments
+/// @return `true` if they fit in empire::LOG_MSG_LENGTH bytes.  If they
+///         don't, nothing is written and the caller should format the
+///         LogEntry itself.
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the packed buffer with pointers
+template< typename... Args >
+inline bool packLogArgs( char* buffer, const Args&... args ) {
+   const size_t needed = ( size_t { 0 } + ... + logArgPackedSize( args ) );
+   if( needed > LOG_MSG_LENGTH ) {
+      return false;
+   }
+
+   size_t offset = 0;
+   ( ( offset += packLogArg( buffer + offset, args ) ), ... );
+
+   if( offset < LOG_MSG_LENGTH ) {
+      buffer[ offset ] = static_cast< char >( LogArgType::end );
+   }
+   return true;
+}
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+
+/// Read the arguments packed by packLogArgs() one at a time
+///
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the packed arguments with pointers
+class LogArgReader {
+public:
+   /// @param args The packed arguments
+   /// @param argsSize The size of `args`
+   LogArgReader( const char* args, const size_t argsSize ) : m_args( args ), m_size( argsSize ) {}
+
+   /// @return The LogArgType of the next argument (LogArgType::end if there
+   ///         are no more)
+   [[nodiscard]] LogArgType peek() const {
+      if( m_offset >= m_size ) {
+         return LogArgType::end;
+      }
+      return static_cast< LogArgType >( m_args[ m_offset ] );
+   }
+
+   /// Read the value of the next argument and move past it
+   ///
+   /// @param value Where to put the value.  It must match peek().
+   /// @return `false` if the argument is cut off
+   template< typename T >
+   bool read( T& value ) {
+      if( m_offset + 1 + sizeof( T ) > m_size ) {
+         m_offset = m_size;
+         return false;
+      }
+      memcpy( &value, m_args + m_offset + 1, sizeof( T ) );
+      m_offset += 1 + sizeof( T );
+      return true;
+   }
+
+   /// Copy the packed bytes of the next (non-string) argument and move past it
+   ///
+   /// @param value Where to put the bytes.  It must hold logArgSize( peek() ).
+   /// @return `false` if the argument is cut off
+   bool readBytes( void* value ) {
+      const size_t size = logArgSize( peek() );
+      if( m_offset + 1 + size > m_size ) {
+         m_offset = m_size;
+         return false;
+      }
+      memcpy( value, m_args + m_offset + 1, size );
+      m_offset += 1 + size;
+      return true;
+   }
+
+   /// Read the next argument as a string and move past it
+   ///
+   /// @return A pointer to the string (in the packed arguments) or `nullptr`
+   ///         if it's not terminated
+   const char* readString() {
+      if( m_offset + 1 >= m_size ) {
+         m_offset = m_size;
+         return nullptr;
+      }
+      const char* const str = m_args + m_offset + 1;
+      const char* const end = static_cast< const char* >( memchr( str, '\0', m_size - m_offset - 1 ) );
+      if( end == nullptr ) {
+         m_offset = m_size;
+         return nullptr;
+      }
+      m_offset = static_cast< size_t >( end - m_args ) + 1;
+      return str;
+   }
+
+   /// Skip the next argument
+   void skip() {
+      const LogArgType type = peek();
+      if( type == LogArgType::string ) {
+         readString();
+      } else {
+         m_offset += 1 + logArgSize( type );
+      }
+   }
+
+private:
+   const char* m_args;     ///< The packed arguments
+   size_t      m_size;     ///< The size of #m_args
+   size_t      m_offset{}; ///< The next argument in #m_args
+};
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+
+/// Format `fmt` with the arguments packed by packLogArgs()
+///
+/// Each conversion is checked against the type that was packed, and its
+/// length modifier is replaced with the right one for that type, so a
+/// mismatched format can't read past an argument.  A conversion without a
+/// matching argument prints `(?)`.  `%n` is ignored.
+///
+/// @param fmt The `printf`-style format string
+/// @param args The packed arguments
+/// @param argsSize The size of `args`
+/// @param buffer Where to put the formatted string
+/// @param bufferSize The size of `buffer`
+/// @return The length of the formatted string (not including the null
+///         terminator).  It's truncated if it doesn't fit in `buffer`.
+extern size_t formatLogArgs( const char* fmt, const char* args, size_t argsSize, char* buffer, size_t bufferSize );
+
+
+/// Format a deferred LogEntry in place
+///
+/// Does nothing if LogEntry::fmt is `nullptr`.  Otherwise, LogEntry::msg is
+/// replaced by the formatted message and LogEntry::fmt is cleared.
+///
+/// @param entry The LogEntry to format
+extern void expandLogEntry( LogEntry& entry );
+
+} // namespace empire
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A cheap, high-resolution clock for LogEntry timestamps
+///
+/// @file      LogClock.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>   // For milliseconds
+#include <cstdint>  // For int64_t UINT64_MAX
+#include <thread>   // For this_thread::sleep_for()
+
+#include "LogClock.hpp"
+
+using namespace std;
+
+namespace empire {
+
+/// Pairs a logClockNow() reading with the wall-clock time it was taken
+struct LogClockSample {
+   uint64_t ticks;   ///< From logClockNow()
+   uint64_t wallNs;  ///< From `CLOCK_REALTIME`
+};
+
+/// How to convert logClockNow() ticks to wall-clock time
+struct LogClockCalibration {
+   LogClockSample base;  ///< Ticks and wall-clock time at calibration
+   double nsPerTick;     ///< The rate of empire::LOG_CLOCK_SOURCE
+};
+
+
+/// Read logClockNow() and `CLOCK_REALTIME` as close together as we can
+///
+/// The wall clock is read between two tick readings.  Of a few tries, the
+/// one with the shortest gap between the tick readings wins.
+///
+/// @return The sample
+static LogClockSample sampleLogClock() {
+   LogClockSample best {};
+   uint64_t bestGap = UINT64_MAX;
+
+   for( int i = 0 ; i < 5 ; i++ ) {  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): A few tries is plenty
+      const uint64_t before = logClockNow();
+      const uint64_t wallNs = logReadClockNs( CLOCK_REALTIME );
+      const uint64_t after  = logClockNow();
+
+      if( after - before < bestGap ) {
+         bestGap = after - before;
+         best = { before + ( after - before ) / 2, wallNs };
+      }
+   }
+
+   return best;
+}
+
+
+/// Calibrate empire::LOG_CLOCK_SOURCE
+///
+/// The POSIX clocks already count nanoseconds, so they just need a base.  A
+/// cycle counter is timed over 20ms.
+///
+/// @return The calibration
+static LogClockCalibration measureLogClock() {
+   const LogClockSample start = sampleLogClock();
+
+   if constexpr( LOG_CLOCK_SOURCE != LogClockSource::cycleCounter || !LOG_CLOCK_HAS_CYCLE_COUNTER ) {
+      return { start, 1.0 };
+   }
+
+   this_thread::sleep_for( 20ms );
+   const LogClockSample stop = sampleLogClock();
+
+   return { start, static_cast< double >( stop.wallNs - start.wallNs ) / static_cast< double >( stop.ticks - start.ticks ) };
+}
+
+
+/// Get the calibration, measuring it the first time
+///
+/// @return The calibration
+static const LogClockCalibration& logClockCalibration() {
+   static const LogClockCalibration calibration { measureLogClock() };
+   return calibration;
+}
+
+
+void calibrateLogClock() {
+   logClockCalibration();
+}
+
+
+uint64_t logTicksToNs( const uint64_t ticks ) {
+   const LogClockCalibration& calibration = logClockCalibration();
+
+   /// Only the offset goes through a `double`.  A `double` can't hold
+   /// nanoseconds since the epoch to better than 256ns.
+   ///
+   /// Ticks can be a little before the base (from a producer that read the
+   /// clock before the calibration did), so the offset can be negative.
+   const auto offsetNs = ( ticks >= calibration.base.ticks )
+                       ?  static_cast< int64_t >( static_cast< double >( ticks - calibration.base.ticks ) * calibration.nsPerTick )
+                       : -static_cast< int64_t >( static_cast< double >( calibration.base.ticks - ticks ) * calibration.nsPerTick );
+
+   return calibration.base.wallNs + static_cast< uint64_t >( offsetNs );
+}
+
+
+double logNsPerTick() {
+   return logClockCalibration().nsPerTick;
+}
+
+} // namespace empire
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A cheap, high-resolution clock for LogEntry timestamps
+///
+/// Producers stamp each LogEntry with logClockNow(), which is a raw tick
+/// count from empire::LOG_CLOCK_SOURCE.  On x86 and ARM64 that's a single
+/// instruction, with no system call and no vDSO.  The clock is calibrated
+/// against `CLOCK_REALTIME` once and the LogConsumer converts the ticks to
+/// wall-clock nanoseconds with logTicksToNs() before any LogSink sees them.
+///
+/// @file      LogClock.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>      // For uint64_t
+#include <ctime>        // For clock_gettime() timespec
+#include <string_view>  // For string_view
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+   #include <x86intrin.h>  // For __rdtsc()
+#endif
+
+#include "LogConfig.hpp"  // For LOG_CLOCK_SOURCE
+
+namespace empire {
+
+/// The number of nanoseconds in a second
+constinit const uint64_t NS_PER_SECOND { 1'000'000'000 };
+
+/// `true` if this target has a cycle counter logClockNow() can read
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( __aarch64__ )
+   constinit const bool LOG_CLOCK_HAS_CYCLE_COUNTER { true };
+#else
+   constinit const bool LOG_CLOCK_HAS_CYCLE_COUNTER { false };
+#endif
+
+
+/// Read a POSIX clock in nanoseconds
+///
+/// @param clock A clock like `CLOCK_MONOTONIC` or `CLOCK_REALTIME`
+/// @return The time in nanoseconds
+inline uint64_t logReadClockNs( const clockid_t clock ) {
+   timespec now {};
+   clock_gettime( clock, &now );
+   return static_cast< uint64_t >( now.tv_sec ) * NS_PER_SECOND + static_cast< uint64_t >( now.tv_nsec );
+}
+
+
+/// Get the current time from empire::LOG_CLOCK_SOURCE
+///
+/// @return The raw tick count.  Use logTicksToNs() to convert it.
+inline uint64_t logClockNow() {
+   if constexpr( LOG_CLOCK_SOURCE == LogClockSource::cycleCounter && LOG_CLOCK_HAS_CYCLE_COUNTER ) {
+#if defined( __x86_64__ ) || defined( __i386__ )
+      return __rdtsc();
+#elif defined( __aarch64__ )
+      uint64_t ticks {};
+      asm volatile( "mrs %0, cntvct_el0" : "=r" ( ticks ) );
+      return ticks;
+#endif
+   } else if constexpr( LOG_CLOCK_SOURCE == LogClockSource::monotonicCoarse ) {
+      return logReadClockNs( CLOCK_MONOTONIC_COARSE );
+   }
+   return logReadClockNs( CLOCK_MONOTONIC );
+}
+
+
+/// Measure the rate of empire::LOG_CLOCK_SOURCE against `CLOCK_REALTIME`
+///
+/// It only does the work the first time it's called.  That takes about
+/// 20ms on a cycle counter (and nothing on the other clocks), so
+/// LogConsumer::restart() calls it before it starts its thread.
+extern void calibrateLogClock();
+
+
+/// Convert logClockNow() ticks to wall-clock time
+///
+/// @param ticks A value from logClockNow()
+/// @return Nanoseconds since the Unix epoch
+extern uint64_t logTicksToNs( uint64_t ticks );
+
+
+/// Get the number of nanoseconds per tick of empire::LOG_CLOCK_SOURCE
+///
+/// @return The calibrated rate
+extern double logNsPerTick();
+
+} // namespace empire
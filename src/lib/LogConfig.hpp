@@ -12,17 +12,76 @@
 #include <cstddef>  // For size_t
 #include <cstdint>  // For uint16_t
 
+#include "LogSeverity.hpp"  // For LogSeverity
+
 namespace empire {
 
-/// The alignment of each LogEntry
-constinit const uint16_t LOG_ALIGNMENT { 256 };
+/// The size of empire::LogQueue and of each LogEntry in it
+struct LogRingPreset {
+   unsigned char slotsBase2;  ///< empire::LogQueue holds 2^slotsBase2 LogEntry records
+   uint16_t      slotBytes;   ///< The size (and alignment) of a LogEntry
+};
 
-/// The maximum size of LogEntry::msg is exactly 1/2 of the size of a LogEntry
-constinit const size_t LOG_MSG_LENGTH { LOG_ALIGNMENT >> 1U };
+/// The LogRingPreset for this build.  Pick one with the `LOG_PRESET` CMake
+/// option (for example `cmake -DLOG_PRESET=server`).
+#if defined( LOG_PRESET_SERVER )
+   constinit const LogRingPreset LOG_RING_PRESET { 16, 512 };  ///< 64K LogEntry records of 512 bytes (32 MiB)
+#elif defined( LOG_PRESET_LARGE )
+   constinit const LogRingPreset LOG_RING_PRESET { 13, 256 };  ///< 8K LogEntry records of 256 bytes (2 MiB)
+#else
+   constinit const LogRingPreset LOG_RING_PRESET { 7, 256 };   ///< 128 LogEntry records of 256 bytes (32 KiB)
+#endif
+
+/// The alignment of each LogEntry
+constinit const uint16_t LOG_ALIGNMENT { LOG_RING_PRESET.slotBytes };
 
-/// The maximum size of LogEntry::module_name
+/// The maximum length of a module name (including the null terminator)
 constinit const size_t MODULE_NAME_LENGTH { 32 };
 
+/// The bytes in a LogEntry that aren't LogEntry::msg:  64 for the other
+/// fields and 24 spare (so a 256-byte LogEntry keeps the layout it had when
+/// LogEntry::msg was 1/2 of it plus the 40 bytes that used to hold a copy of
+/// the module name)
+constinit const size_t LOG_ENTRY_OVERHEAD { 88 };
+
+/// Get the size of LogEntry::msg in a LogEntry of `slotBytes` bytes
+///
+/// @param slotBytes The size of the LogEntry
+/// @return The maximum size of LogEntry::msg
+consteval size_t logMsgLength( const size_t slotBytes ) {
+   return slotBytes - LOG_ENTRY_OVERHEAD;
+}
+
+/// The maximum size of LogEntry::msg
+constinit const size_t LOG_MSG_LENGTH { logMsgLength( LOG_ALIGNMENT ) };
+
+/// The maximum number of modules (distinct `LOG_MODULE` names) that can
+/// register with registerLogModule()
+constinit const size_t MAX_LOG_MODULES { 256 };
+
+/// Where LogEntry::logTimestamp comes from
+enum class LogClockSource {
+   cycleCounter,    ///< The CPU's cycle counter (the TSC on x86, `CNTVCT_EL0` on ARM64).  Falls back to `monotonic` elsewhere.
+   monotonic,       ///< `clock_gettime( CLOCK_MONOTONIC )`
+   monotonicCoarse  ///< `clock_gettime( CLOCK_MONOTONIC_COARSE )`.  Cheaper, but only accurate to a few milliseconds.
+};
+
+/// The clock producers use to stamp each LogEntry.  The LogConsumer converts
+/// it to wall-clock nanoseconds.
+constinit const LogClockSource LOG_CLOCK_SOURCE { LogClockSource::cycleCounter };
+
+/// The runtime severity threshold each module starts with.  `MIN_LOG_SEVERITY`
+/// decides what's compiled in; setLogSeverity() decides what's logged.
+constinit const LogSeverity DEFAULT_LOG_SEVERITY { LogSeverity::test };
+
+/// The maximum size of a LogEntry after it's been formatted for a LogSink
+constinit const size_t LOG_LINE_LENGTH { LOG_ALIGNMENT };
+
+/// The maximum size of a LogEntry after formatLogEntryJson() or
+/// encodeLogEntryBinary().  JSON escapes can make a string up to 6 times
+/// longer, and the keys come from the LogKvSchema, not LogEntry::msg.
+constinit const size_t LOG_STRUCTURED_LENGTH { 8 * LOG_LINE_LENGTH };
+
 /// empire::LogQueue is a ring buffer modeled after the Linux kernel's DMESG buffer.
 /// The size of empire::LogQueue must be a power of 2 (8, 16, 32, ...) entries.
 /// This variable enforces that rule.
@@ -38,7 +97,7 @@ constinit const size_t MODULE_NAME_LENGTH { 32 };
 /// |               7              |                    64 |
 /// |               8              |                   128 |
 ///
-constinit const unsigned char SIZE_OF_QUEUE_BASE_2 { 7 };
+constinit const unsigned char SIZE_OF_QUEUE_BASE_2 { LOG_RING_PRESET.slotsBase2 };
 
 /// The size of the empire::LogQueue ring buffer
 constinit const size_t SIZE_OF_QUEUE { 1U << SIZE_OF_QUEUE_BASE_2 };
@@ -46,4 +105,78 @@ constinit const size_t SIZE_OF_QUEUE { 1U << SIZE_OF_QUEUE_BASE_2 };
 /// Mask the actual index into empire::LogQueue from empire::LogIndex
 constinit const size_t LOG_QUEUE_INDEX_MASK { SIZE_OF_QUEUE - 1 };
 
+/// A LogRing at least this big is aligned to (and backed by) huge pages
+constinit const size_t LOG_HUGE_PAGE_BYTES { 2 * 1024 * 1024 };
+
+/// What producers do when empire::LogQueue is full (when the next LogEntry
+/// still holds a record that a running LogConsumer hasn't processed)
+enum class LogOverrunPolicy {
+   dropOldest,  ///< Overwrite the oldest LogEntry.  Lapped LogConsumers count what they lost.
+   dropNewest,  ///< Discard the new LogEntry and count it
+   block        ///< Wait for the LogConsumers to catch up
+};
+
+/// The LogOverrunPolicy the logger starts with
+constinit const LogOverrunPolicy DEFAULT_LOG_OVERRUN_POLICY { LogOverrunPolicy::dropOldest };
+
+/// Where producers put their LogEntry records
+enum class LogQueueMode {
+   shared,    ///< Every thread claims its LogEntry from empire::LogQueue through empire::LogIndex
+   perThread  ///< Each thread writes to its own single-producer ring.  The LogConsumer merges them by timestamp.
+};
+
+/// The LogQueueMode the logger starts with
+constinit const LogQueueMode DEFAULT_LOG_QUEUE_MODE { LogQueueMode::shared };
+
+/// Each per-thread ring holds 2^SIZE_OF_THREAD_RING_BASE_2 LogEntry records
+/// (see empire::SIZE_OF_QUEUE_BASE_2)
+constinit const unsigned char SIZE_OF_THREAD_RING_BASE_2 { 6 };
+
+/// The size of each per-thread ring
+constinit const size_t SIZE_OF_THREAD_RING { 1U << SIZE_OF_THREAD_RING_BASE_2 };
+
+/// Mask the actual index into a per-thread ring from its head pointer
+constinit const size_t LOG_THREAD_RING_INDEX_MASK { SIZE_OF_THREAD_RING - 1 };
+
+/// The maximum number of per-thread rings.  A thread that exits gives its
+/// ring back.  Threads that can't get one use empire::LogQueue.
+constinit const size_t MAX_LOG_THREAD_RINGS { 128 };
+
+/// The number of records in a new LogSinkMapped file (16 MiB of LogEntry
+/// records)
+constinit const size_t LOG_MAPPED_CAPACITY { 65536 };
+
+/// LogSinkRotatingFile starts a new file when the current one reaches this
+/// many bytes (0 turns size-based rotation off)
+constinit const size_t LOG_ROTATE_BYTES { 64 * 1024 * 1024 };
+
+/// LogSinkRotatingFile starts a new file when the current one has been logged
+/// to for this many seconds (0 turns time-based rotation off)
+constinit const uint64_t LOG_ROTATE_SECONDS { 24 * 60 * 60 };
+
+/// The number of closed files LogSinkRotatingFile keeps.  The oldest are
+/// deleted.
+constinit const size_t LOG_ROTATE_KEEP { 10 };
+
+/// The number of LogEntry records per second a `LOG_RATE_LIMIT` call site
+/// can queue over the long run (0 turns the rate limit off).  See
+/// setLogRateLimit().
+constinit const uint32_t LOG_RATE_LIMIT_PER_SECOND { 100 };
+
+/// The number of LogEntry records a quiet `LOG_RATE_LIMIT` call site can
+/// queue back-to-back before the rate limit kicks in
+constinit const uint32_t LOG_RATE_LIMIT_BURST { 200 };
+
+/// While a `LOG_RATE_LIMIT` call site keeps repeating the same message, it
+/// reports how many times it was repeated this often
+constinit const uint64_t LOG_REPEAT_REPORT_SECONDS { 10 };
+
+/// The maximum number of LogConsumer threads that can drain empire::LogQueue
+/// at the same time.  Each one gets its own doorbell in empire::hasNewLogs.
+constinit const size_t MAX_LOG_CONSUMERS { 4 };
+
+/// The maximum number of LogEntry records a LogConsumer hands to its
+/// LogSink objects in one batch
+constinit const size_t LOG_CONSUMER_BATCH_SIZE { 16 };
+
 } // namespace empire
@@ -1,13 +1,425 @@
 ///////////////////////////////////////////////////////////////////////////////
 //  Empire V - What you do is what you do
 //
-/// Abstract class for log consumers
+/// A thread that drains empire::LogQueue into one or more LogSink objects
 ///
 /// @file      LogConsumer.cpp
 /// @author    Mark Nelson <marknels@hawaii.edu>
 /// @copyright (c) 2023 Mark Nelson.  All rights reserved.
 ///////////////////////////////////////////////////////////////////////////////
+
+#include <array>             // For array<>
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+#include <cstdio>            // For snprintf()
+#include <ctime>             // For CLOCK_REALTIME
+
+#include "LogArgs.hpp"
+#include "LogClock.hpp"
 #include "LogConsumer.hpp"
 
+using namespace std;
+
 namespace empire {
+
+/// The LogModuleId for the LogEntry records a LogConsumer writes itself
+static const LogModuleId LOG_CONSUMER_MODULE_ID { registerLogModule( "LogConsumer" ) };
+
+
+LogConsumer::~LogConsumer() {
+   stop();
+}
+
+
+LogSink& LogConsumer::addSink( unique_ptr< LogSink > sink ) {
+   BOOST_ASSERT_MSG( sink != nullptr, "LogSink can't be NULL" );
+   BOOST_ASSERT_MSG( !isRunning(), "LogSinks can only be added to a stopped LogConsumer" );
+
+   sinks.push_back( std::move( sink ) );
+   return *sinks.back();
+}
+
+
+void LogConsumer::restart() {
+   stop();
+
+   /// Don't hold back the producers for LogEntry records that are already gone
+   const size_t head = logHead();
+   size_t index = consumerIndex.load();
+   if( index > head ) {
+      index = 0;
+   }
+   if( head - index > SIZE_OF_QUEUE ) {
+      index = head - SIZE_OF_QUEUE;
+   }
+   consumerIndex.store( index );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t ring = 0 ; ring < logThreadRingCount() ; ring++ ) {
+      const size_t ringHead = logThreadRingHead( ring );
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+      size_t ringIndex = ringIndexes[ ring ].load();
+      if( ringIndex > ringHead ) {
+         ringIndex = 0;
+      }
+      if( ringHead - ringIndex > SIZE_OF_THREAD_RING ) {
+         ringIndex = ringHead - SIZE_OF_THREAD_RING;
+      }
+      ringIndexes[ ring ].store( ringIndex );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   }
+   isStaged.reset();
+
+   lastLogDropped = logDroppedCount();
+
+   /// Calibrating the clock takes a moment.  Do it now, not in drain().
+   calibrateLogClock();
+
+   slot = registerLogConsumer( index, ringIndexes );
+   continueRunning.store( true );
+   thread = std::thread( &LogConsumer::run, this );
+}
+
+
+void LogConsumer::stop() {
+   if( !thread.joinable() ) {
+      return;
+   }
+
+   continueRunning.store( false );
+   logRingDoorbell( slot );
+   thread.join();
+
+   unregisterLogConsumer( slot );
+   slot = MAX_LOG_CONSUMERS;
+
+   /// Wake up anyone stuck in sync()
+   notifyProgress();
+}
+
+
+bool LogConsumer::isRunning() const {
+   return continueRunning.load();
+}
+
+
+size_t LogConsumer::getConsumerIndex() const {
+   return consumerIndex.load( memory_order_acquire );
+}
+
+
+size_t LogConsumer::getDroppedCount() const {
+   return droppedCount.load( memory_order_acquire );
+}
+
+
+void LogConsumer::sync() const {
+   const size_t target = logHead();
+
+   const size_t rings = logThreadRingCount();
+   array< size_t, MAX_LOG_THREAD_RINGS > ringTargets {};
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t ring = 0 ; ring < rings ; ring++ ) {
+      ringTargets[ ring ] = logThreadRingHead( ring );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   }
+
+   /// @return `true` if every tail pointer has reached its target
+   auto caughtUp = [ & ]() {
+      if( consumerIndex.load( memory_order_acquire ) < target ) {
+         return false;
+      }
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t ring = 0 ; ring < rings ; ring++ ) {
+         /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+         if( ringIndexes[ ring ].load( memory_order_acquire ) < ringTargets[ ring ] ) {
+            return false;
+         }
+      }
+      return true;
+   };
+
+   /// Read #progress before we check, so we can't miss a notification
+   size_t seen = progress.load( memory_order_acquire );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( isRunning() && !caughtUp() ) {
+      progress.wait( seen, memory_order_acquire );
+      seen = progress.load( memory_order_acquire );
+   }
+}
+
+
+void LogConsumer::notifyProgress() {
+   progress.fetch_add( 1, memory_order_release );
+   progress.notify_all();
+}
+
+
+void LogConsumer::process( const span< const LogEntry > entries ) {
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const unique_ptr< LogSink >& sink : sinks ) {
+      sink->write( entries );
+   }
+}
+
+
+void LogConsumer::run() {
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( ;; ) {
+      /// Clear the doorbell *before* draining, so a LogEntry that's published
+      /// while we drain will ring it again
+      logArmDoorbell( slot );
+
+      if( drain() == 0 ) {
+         /// Only flush when we've run out of work
+         // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+         for( const unique_ptr< LogSink >& sink : sinks ) {
+            sink->flush();
+         }
+      }
+
+      if( !continueRunning.load() ) {
+         break;
+      }
+
+      logWaitForDoorbell( slot );
+   }
+
+   drain();
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const unique_ptr< LogSink >& sink : sinks ) {
+      sink->flush();
+   }
+}
+
+
+size_t LogConsumer::drain() {
+   size_t processed = 0;
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( ;; ) {
+      /// Read the dropped counter before empire::LogIndex, so every LogEntry
+      /// a producer discarded came after `head`
+      const size_t logDropped = logDroppedCount();
+      const size_t head = logHead();
+      size_t index = consumerIndex.load( memory_order_relaxed );
+
+      /// If empire::LogQueue was reset, start over
+      if( index > head ) {
+         index = 0;
+      }
+      if( logDropped < lastLogDropped ) {
+         lastLogDropped = 0;
+      }
+
+      /// If the producers lapped us, skip to the oldest LogEntry that's left
+      if( head - index > SIZE_OF_QUEUE ) {
+         undeliveredDrops += head - SIZE_OF_QUEUE - index;
+         index = head - SIZE_OF_QUEUE;
+      }
+
+      size_t count = 0;
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( index < head && count < LOG_CONSUMER_BATCH_SIZE ) {
+         if( undeliveredDrops > 0 ) {
+            reportDrops( count, index );
+            count += 1;
+            continue;
+         }
+
+         /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < LOG_CONSUMER_BATCH_SIZE
+         const LogSnapshot snapshot = logSnapshot( index, batch[ count ] );
+
+         if( snapshot == LogSnapshot::pending ) {
+            break;  // A producer is still composing it.  It'll ring the doorbell when it's done.
+         }
+
+         if( snapshot == LogSnapshot::lost ) {
+            /// A producer lapped us after we read empire::LogIndex
+            undeliveredDrops += 1;
+            index += 1;
+            continue;
+         }
+
+         /// Format a deferred LogEntry and convert its timestamp here, off
+         /// the producer's thread
+         expandLogEntry( batch[ count ] );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < LOG_CONSUMER_BATCH_SIZE
+         batch[ count ].logTimestamp = logTicksToNs( batch[ count ].logTimestamp );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < LOG_CONSUMER_BATCH_SIZE
+
+         count += 1;
+         index += 1;
+      }
+
+      /// The LogEntry records producers discarded go after everything that's
+      /// in empire::LogQueue
+      if( index == head ) {
+         undeliveredDrops += logDropped - lastLogDropped;
+         lastLogDropped = logDropped;
+      }
+
+      /// Report drops at the head of empire::LogQueue
+      if( undeliveredDrops > 0 && count < LOG_CONSUMER_BATCH_SIZE ) {
+         reportDrops( count, index );
+         count += 1;
+      }
+
+      if( slot < MAX_LOG_CONSUMERS ) {
+         logSetConsumerIndex( slot, index );
+      }
+
+      if( count == 0 ) {
+         consumerIndex.store( index, memory_order_release );
+         notifyProgress();
+         break;
+      }
+
+      process( span< const LogEntry >( batch.data(), count ) );
+      processed += count;
+
+      consumerIndex.store( index, memory_order_release );
+      notifyProgress();
+   }
+
+   return processed + drainThreadRings();
+}
+
+
+size_t LogConsumer::drainThreadRings() {
+   const size_t rings = logThreadRingCount();
+   size_t processed = 0;
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( ;; ) {
+      /// Read each head once per batch.  Looking at them costs a cache miss
+      /// while their owners are logging.
+      array< size_t, MAX_LOG_THREAD_RINGS > heads {};
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t ring = 0 ; ring < rings ; ring++ ) {
+         heads[ ring ] = logThreadRingHead( ring );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+      }
+
+      size_t count = 0;
+
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( count < LOG_CONSUMER_BATCH_SIZE ) {
+         /// Find the ring with the oldest LogEntry, staging the next LogEntry
+         /// from any ring that doesn't have one yet
+         size_t oldest = MAX_LOG_THREAD_RINGS;
+         // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+         for( size_t ring = 0 ; ring < rings ; ring++ ) {
+            /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+            if( !isStaged[ ring ] && ( ringIndexes[ ring ].load( memory_order_relaxed ) == heads[ ring ] || !stageThreadRingEntry( ring, heads[ ring ] ) ) ) {
+               continue;
+            }
+            /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` and `oldest` are always < MAX_LOG_THREAD_RINGS
+            if( oldest == MAX_LOG_THREAD_RINGS || staged[ ring ].logTimestamp < staged[ oldest ].logTimestamp ) {
+               oldest = ring;
+            }
+         }
+
+         /// Report what was lost before the LogEntry that came after it
+         if( undeliveredDrops > 0 ) {
+            reportDrops( count, consumerIndex.load( memory_order_relaxed ) );
+            count += 1;
+            continue;
+         }
+
+         if( oldest == MAX_LOG_THREAD_RINGS ) {
+            break;  // Nothing is ready
+         }
+
+         /// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < LOG_CONSUMER_BATCH_SIZE and `oldest` is < MAX_LOG_THREAD_RINGS
+         batch[ count ] = staged[ oldest ];
+         expandLogEntry( batch[ count ] );
+         batch[ count ].logTimestamp = logTicksToNs( batch[ count ].logTimestamp );
+
+         isStaged.reset( oldest );
+         ringIndexes[ oldest ].fetch_add( 1, memory_order_release );
+         // @NOLINTEND( cppcoreguidelines-pro-bounds-constant-array-index )
+
+         count += 1;
+      }
+
+      if( slot < MAX_LOG_CONSUMERS ) {
+         // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+         for( size_t ring = 0 ; ring < rings ; ring++ ) {
+            /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+            logSetThreadRingConsumerIndex( ring, slot, ringIndexes[ ring ].load( memory_order_relaxed ) );
+         }
+      }
+
+      if( count == 0 ) {
+         notifyProgress();
+         return processed;
+      }
+
+      process( span< const LogEntry >( batch.data(), count ) );
+      processed += count;
+
+      notifyProgress();
+   }
+}
+
+
+bool LogConsumer::stageThreadRingEntry( const size_t ring, const size_t head ) {
+   BOOST_ASSERT_MSG( ring < MAX_LOG_THREAD_RINGS, "LogThreadRing out of range" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   size_t index = ringIndexes[ ring ].load( memory_order_relaxed );
+
+   /// If the ring was reset, start over
+   if( index > head ) {
+      index = 0;
+   }
+
+   /// If the owner lapped us, skip to the oldest LogEntry that's left
+   if( head - index > SIZE_OF_THREAD_RING ) {
+      undeliveredDrops += head - SIZE_OF_THREAD_RING - index;
+      index = head - SIZE_OF_THREAD_RING;
+   }
+
+   bool found = false;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( index < head ) {
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+      const LogSnapshot snapshot = logThreadRingSnapshot( ring, index, staged[ ring ] );
+
+      if( snapshot == LogSnapshot::ready ) {
+         found = true;
+         break;
+      }
+      if( snapshot == LogSnapshot::pending ) {
+         break;  // The owner is still composing it
+      }
+
+      /// The owner lapped us after we read its head
+      undeliveredDrops += 1;
+      index += 1;
+   }
+
+   ringIndexes[ ring ].store( index, memory_order_release );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `ring` is always < MAX_LOG_THREAD_RINGS
+   isStaged.set( ring, found );
+   return found;
+}
+
+
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay, cppcoreguidelines-pro-type-vararg, hicpp-vararg ): We use `snprintf()` into `char[]` arrays
+void LogConsumer::reportDrops( const size_t count, const size_t index ) {
+   BOOST_ASSERT_MSG( count < LOG_CONSUMER_BATCH_SIZE, "There's no room in the batch" );
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < LOG_CONSUMER_BATCH_SIZE
+   LogEntry& entry = batch[ count ];
+   entry = LogEntry {};
+
+   snprintf( entry.msg, LOG_MSG_LENGTH, "Dropped %zu log entries", undeliveredDrops );  // NOLINT( cert-err33-c ): The message always fits
+   entry.moduleId = LOG_CONSUMER_MODULE_ID;
+   entry.logSeverity = LogSeverity::warning;
+   entry.logTimestamp = logReadClockNs( CLOCK_REALTIME );
+   entry.sequence = index;
+   entry.ready = true;
+
+   droppedCount.fetch_add( undeliveredDrops, memory_order_release );
+   undeliveredDrops = 0;
+}
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay, cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+
 } // namespace empire
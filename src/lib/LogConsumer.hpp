@@ -1,7 +1,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 //  Empire V - What you do is what you do
 //
-/// Abstract class for log consumers
+/// A thread that drains empire::LogQueue into one or more LogSink objects
 ///
 /// @file      LogConsumer.hpp
 /// @author    Mark Nelson <marknels@hawaii.edu>
@@ -9,17 +9,56 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 
-#include <thread>
+#include <array>   // For array<>
+#include <atomic>  // For atomic<>
+#include <bitset>  // For bitset<>
+#include <memory>  // For unique_ptr<>
+#include <span>    // For span<>
+#include <thread>  // For thread
+#include <vector>  // For vector<>
 
-#include "LogConsumer.hpp"
+#include "LogConfig.hpp"  // For MAX_LOG_CONSUMERS LOG_CONSUMER_BATCH_SIZE MAX_LOG_THREAD_RINGS
+#include "LogEntry.hpp"
+#include "LogSink.hpp"
 
 namespace empire {
 
+/// Drain empire::LogQueue on a background thread
 ///
 /// @pattern Consumer-Producer
-/// The descendents of this class are the consumers for this pattern.
-class [[maybe_unused]] LogConsumer : public std::thread {
-public:
+/// This class is the consumer for this pattern.
+///
+/// Each LogConsumer runs its own thread with its own tail pointer
+/// (#consumerIndex) into empire::LogQueue, so a slow LogConsumer (say, one
+/// writing to a file) never holds up a fast one (say, one writing to memory).
+/// Up to empire::MAX_LOG_CONSUMERS can run at the same time.
+///
+/// When a LogConsumer catches up to empire::LogIndex, it sleeps on its
+/// doorbell in empire::hasNewLogs until a producer rings it.  It never spins.
+///
+/// The LogEntry records are copied out of empire::LogQueue in batches of up to
+/// empire::LOG_CONSUMER_BATCH_SIZE and each batch is handed to every LogSink
+/// in the order they were added.
+///
+/// Under LogQueueMode::perThread, the LogConsumer also keeps a tail pointer
+/// into each thread's ring.  It holds the next LogEntry from each ring and
+/// always hands on the one with the oldest LogEntry::logTimestamp, so the
+/// rings come out merged in time order (as far as what's been published when
+/// it drains).
+///
+/// If LogEntry records are lost (a producer lapped this LogConsumer or
+/// discarded them under LogOverrunPolicy::dropNewest), the LogConsumer counts
+/// them and puts a `warning` LogEntry that says how many were dropped into
+/// the batch, where the gap was.
+///
+///     LogConsumer consumer;
+///     consumer.addSink( std::make_unique< LogSinkConsole >() );
+///     consumer.restart();
+class LogConsumer {
+public:  // /////////////////// Constructors & Destructors /////////////////////
+   /// Make a LogConsumer.  The thread isn't started until restart().
+   LogConsumer() = default;
+
    LogConsumer(LogConsumer &src)                    = delete; // Copy constructor
    LogConsumer(const LogConsumer &src)              = delete; // Const copy constructor
    LogConsumer &operator=(LogConsumer &src)         = delete; // Copy assignment
@@ -29,26 +68,237 @@ public:
    LogConsumer& operator= (LogConsumer&& src)       = delete; // Move assignment operator
    LogConsumer& operator= (const LogConsumer&& src) = delete; // Const move assignment operator
 
+   /// Stop the thread (after it drains empire::LogQueue)
+   virtual ~LogConsumer();
+
 private:
-   /// The ID of the thread or 0 if the thread is not running
-   [[maybe_unused]] alignas( size_t ) std::thread::id thread_id { 0 };
+   /// The consumer thread.  It's not joinable when the LogConsumer is stopped.
+   std::thread thread;
 
    /// A flag to indicate if the thread should continue running.  Set to
    /// `false` if you want the thread to stop
-   [[maybe_unused]] alignas( size_t ) bool continueRunning { true };
+   alignas( size_t ) std::atomic< bool > continueRunning { false };
+
+   /// The thread-specific tail pointer into empire::LogQueue.  This is the
+   /// empire::LogIndex of the next LogEntry this LogConsumer will process.
+   alignas( size_t ) std::atomic< size_t > consumerIndex { 0 };
+
+   /// The tail pointer into each per-thread ring (see LogQueueMode::perThread)
+   std::array< std::atomic< size_t >, MAX_LOG_THREAD_RINGS > ringIndexes {};
+
+   /// The next LogEntry from each per-thread ring, waiting to be merged.  It's
+   /// still at the ring's tail pointer in #ringIndexes.
+   std::array< LogEntry, MAX_LOG_THREAD_RINGS > staged {};
+
+   /// The per-thread rings that have a LogEntry in #staged
+   std::bitset< MAX_LOG_THREAD_RINGS > isStaged;
+
+   /// Counts up every time this LogConsumer moves its tail pointers.  sync()
+   /// waits on it.
+   alignas( size_t ) std::atomic< size_t > progress { 0 };
+
+   /// This LogConsumer's doorbell in empire::hasNewLogs (when it's running)
+   size_t slot { MAX_LOG_CONSUMERS };
+
+   /// The number of LogEntry records this LogConsumer has lost
+   alignas( size_t ) std::atomic< size_t > droppedCount { 0 };
+
+   /// The LogEntry records we've lost, but haven't reported to the LogSink
+   /// objects yet
+   size_t undeliveredDrops { 0 };
 
-   /// The thread-specific tail pointer into empire::LogQueue
-   [[maybe_unused]] alignas( size_t ) size_t consumerIndex { 0 };
+   /// The value of logDroppedCount() the last time we looked at it
+   size_t lastLogDropped { 0 };
 
-public:
-   /// Default destructor
-   virtual ~LogConsumer() = default;
+   /// The LogSink objects that process each batch
+   std::vector< std::unique_ptr< LogSink > > sinks;
+
+   /// The batch of LogEntry records copied out of empire::LogQueue
+   std::array< LogEntry, LOG_CONSUMER_BATCH_SIZE > batch {};
+
+public:  // ///////////////////////// Public Methods ///////////////////////////
+   /// Add a LogSink to this LogConsumer
+   ///
+   /// LogSink objects can only be added while the LogConsumer is stopped.
+   ///
+   /// @param sink The LogSink.  The LogConsumer takes ownership of it.
+   /// @return A reference to the LogSink
+   LogSink& addSink( std::unique_ptr< LogSink > sink );
 
    /// Restart (or start) this LogConsumer thread
-   [[maybe_unused]] virtual void restart();
+   ///
+   /// The LogConsumer picks up where it left off.  The first time it starts,
+   /// it processes everything that's still in empire::LogQueue.
+   ///
+   /// @throws range_error if empire::MAX_LOG_CONSUMERS are already running
+   virtual void restart();
+
+   /// Drain empire::LogQueue, flush the LogSink objects and stop the thread
+   void stop();
+
+   /// Determine if this LogConsumer's thread is running
+   ///
+   /// @return `true` if the thread is running
+   [[nodiscard]] bool isRunning() const;
+
+   /// Get the empire::LogIndex of the next LogEntry this LogConsumer will
+   /// process
+   ///
+   /// @return This LogConsumer's tail pointer into empire::LogQueue
+   [[nodiscard]] size_t getConsumerIndex() const;
+
+   /// Get the number of LogEntry records this LogConsumer has lost because a
+   /// producer lapped it or discarded them
+   ///
+   /// @return The number of LogEntry records this LogConsumer never processed
+   [[nodiscard]] size_t getDroppedCount() const;
+
+   /// Wait until this LogConsumer has processed every LogEntry that was queued
+   /// before the call (in empire::LogQueue and in the per-thread rings)
+   void sync() const;
+
+protected:  // ////////////////////// Protected Methods ////////////////////////
+   /// Hand a batch of LogEntry records to each LogSink
+   ///
+   /// Descendents can override this to filter or transform the batch.
+   ///
+   /// @param entries The LogEntry records, oldest first
+   virtual void process( std::span< const LogEntry > entries );
+
+private:  // ////////////////////////// Private Methods ////////////////////////
+   /// The body of the consumer thread
+   void run();
+
+   /// Process every ready LogEntry between #consumerIndex and empire::LogIndex,
+   /// then every ready LogEntry in the per-thread rings
+   ///
+   /// @return The number of LogEntry records processed
+   size_t drain();
+
+   /// Process every ready LogEntry in the per-thread rings, oldest first
+   ///
+   /// @return The number of LogEntry records processed
+   size_t drainThreadRings();
+
+   /// Copy the next ready LogEntry in a per-thread ring into #staged
+   ///
+   /// @param ring The per-thread ring
+   /// @param head The ring's head pointer (from logThreadRingHead())
+   /// @return `true` if there's a LogEntry in #staged for `ring`
+   bool stageThreadRingEntry( size_t ring, size_t head );
+
+   /// Tell sync() that a tail pointer moved
+   void notifyProgress();
+
+   /// Put a LogEntry that reports #undeliveredDrops into #batch
+   ///
+   /// @param count The position in #batch
+   /// @param index The empire::LogIndex where the gap was
+   void reportDrops( size_t count, size_t index );
+};
 
 
+/* ****************************************************************************
+   The interface between LogConsumer and empire::LogQueue
 
+   These are implemented in Log.cpp, next to empire::LogQueue.               */
+
+/// Claim a doorbell in empire::hasNewLogs for a running LogConsumer
+///
+/// @param consumerIndex The LogConsumer's tail pointer into empire::LogQueue
+/// @param ringIndexes The LogConsumer's tail pointer into each per-thread ring
+///                    (empire::MAX_LOG_THREAD_RINGS of them)
+/// @return The slot of the doorbell
+/// @throws range_error if empire::MAX_LOG_CONSUMERS are already running
+extern size_t registerLogConsumer( size_t consumerIndex, std::span< const std::atomic< size_t > > ringIndexes );
+
+/// Release a doorbell claimed by registerLogConsumer()
+///
+/// @param slot The slot of the doorbell
+extern void unregisterLogConsumer( size_t slot );
+
+/// Tell the producers how far a LogConsumer has gotten
+///
+/// @param slot The slot of the LogConsumer's doorbell
+/// @param consumerIndex The LogConsumer's tail pointer into empire::LogQueue
+extern void logSetConsumerIndex( size_t slot, size_t consumerIndex );
+
+/// Tell the owner of a per-thread ring how far a LogConsumer has gotten
+///
+/// @param ring The per-thread ring
+/// @param slot The slot of the LogConsumer's doorbell
+/// @param ringIndex The LogConsumer's tail pointer into the ring
+extern void logSetThreadRingConsumerIndex( size_t ring, size_t slot, size_t ringIndex );
+
+/// Clear a doorbell before draining empire::LogQueue
+///
+/// @param slot The slot of the doorbell
+extern void logArmDoorbell( size_t slot );
+
+/// Sleep until a doorbell rings
+///
+/// @param slot The slot of the doorbell
+extern void logWaitForDoorbell( size_t slot );
+
+/// Ring a doorbell (to wake up its LogConsumer)
+///
+/// @param slot The slot of the doorbell
+extern void logRingDoorbell( size_t slot );
+
+/// Get the value of empire::LogIndex
+///
+/// @return The empire::LogIndex of the next LogEntry a producer will claim
+extern size_t logHead();
+
+/// Get the number of per-thread rings that have ever been handed out
+///
+/// @return The per-thread rings a LogConsumer needs to look at
+extern size_t logThreadRingCount();
+
+/// Get the head pointer of a per-thread ring
+///
+/// @param ring The per-thread ring
+/// @return The index of the next LogEntry the ring's owner will claim
+extern size_t logThreadRingHead( size_t ring );
+
+/// Get the number of LogEntry records producers have discarded under
+/// LogOverrunPolicy::dropNewest
+///
+/// @return The number of discarded LogEntry records
+extern size_t logDroppedCount();
+
+/// The result of logSnapshot()
+enum class LogSnapshot {
+   ready,    ///< The copy is good
+   pending,  ///< A producer has claimed the LogEntry, but hasn't published it yet
+   lost      ///< A producer overwrote the LogEntry
 };
 
+/// Safely copy a LogEntry out of empire::LogQueue
+///
+/// Producers never wait for a LogSnapshot, so the LogEntry can be overwritten
+/// while we copy it.  LogEntry::sequence and LogEntry::ready are checked
+/// before and after the copy, so a torn copy is never reported as ready.
+///
+/// @param index An empire::LogIndex value
+/// @param copy Where to copy the LogEntry
+/// @return LogSnapshot::ready if `copy` holds the LogEntry at `index`
+extern LogSnapshot logSnapshot( size_t index, LogEntry& copy );
+
+/// Safely copy a LogEntry out of a per-thread ring (see logSnapshot())
+///
+/// @param ring The per-thread ring
+/// @param index An index into the ring (from logThreadRingHead())
+/// @param copy Where to copy the LogEntry
+/// @return LogSnapshot::ready if `copy` holds the LogEntry at `index`
+extern LogSnapshot logThreadRingSnapshot( size_t ring, size_t index, LogEntry& copy );
+
+/// Get a LogEntry from empire::LogQueue
+///
+/// This is not safe if producers are running.  Use logSnapshot().
+///
+/// @param index An empire::LogIndex value (it will be masked)
+/// @return The LogEntry in that slot of empire::LogQueue
+extern const LogEntry& logEntryAt( size_t index );
+
 } // namespace empire
@@ -0,0 +1,336 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Dump the in-memory log when the process crashes (or calls `LOG_FATAL`)
+///
+/// @file      LogCrash.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>     // For sort()
+#include <atomic>        // For atomic<>
+#include <cerrno>        // For errno
+#include <csignal>       // For sigaction() sigaltstack() raise() SIGSEGV SIGABRT SIGBUS
+#include <cstring>       // For memcpy() strncpy() strnlen()
+#include <fcntl.h>       // For open()
+#include <fstream>       // For ifstream
+#include <iterator>      // For istreambuf_iterator<>
+#include <memory>        // For unique_ptr<>
+#include <new>           // For nothrow
+#include <system_error>  // For system_error generic_category()
+#include <unistd.h>      // For close() gettid()
+#include <vector>        // For vector<>
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "LogCrash" };
+
+#include "Log.hpp"       // For logCrashDump()
+#include "LogClock.hpp"  // For calibrateLogClock() logClockNow() logTicksToNs() logNsPerTick()
+#include "LogCrash.hpp"
+
+using namespace std;
+
+namespace empire {
+
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast ): We pick the dump apart in place
+/// @NOLINTBEGIN( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): `open()` is variadic
+
+namespace {
+
+/// The signals we catch
+constinit const array< int, 3 > CRASH_SIGNALS { SIGSEGV, SIGABRT, SIGBUS };
+
+/// The pre-opened dump file (-1 if there's no crash handler)
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): It's in an anonymous namespace
+constinit atomic< int > CrashFd { -1 };
+
+/// The thread that's writing a dump (0 if none).  Only one thread dumps at a
+/// time.  A thread that crashes while another one is dumping waits for it.  A
+/// thread that crashes in its own dump skips it (waiting would hang).
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): It's in an anonymous namespace
+constinit atomic< pid_t > DumpingThread { 0 };
+
+/// The clock calibration for the dump
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): It's in an anonymous namespace
+LogCrashClock CrashClock {};
+
+/// The handlers we replaced, in the same order as CRASH_SIGNALS
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): It's in an anonymous namespace
+array< struct sigaction, CRASH_SIGNALS.size() > OldHandlers {};
+
+/// The size of a CrashStack
+constinit const size_t CRASH_STACK_SIZE { 64 * 1024 };
+
+
+/// The alternate stack the handler runs on in one thread, so we can still dump
+/// after a stack overflow.  It's freed when the thread exits.
+class CrashStack {
+public:
+   CrashStack() = default;
+
+   CrashStack(CrashStack &src)                    = delete; // Copy constructor
+   CrashStack(const CrashStack &src)              = delete; // Const copy constructor
+   CrashStack &operator=(CrashStack &src)         = delete; // Copy assignment
+   CrashStack &operator=(const CrashStack &src)   = delete; // Const copy assignment
+   CrashStack (CrashStack&& src)                  = delete; // Move constructor
+   CrashStack (const CrashStack&& src)            = delete; // Const move constructor
+   CrashStack& operator= (CrashStack&& src)       = delete; // Move assignment operator
+   CrashStack& operator= (const CrashStack&& src) = delete; // Const move assignment operator
+
+   ~CrashStack() {
+      stack_t current {};
+      if( m_stack != nullptr && sigaltstack( nullptr, &current ) == 0 && current.ss_sp == m_stack->data() ) {
+         stack_t disable {};
+         disable.ss_flags = SS_DISABLE;
+         sigaltstack( &disable, nullptr );  // NOLINT( cert-err33-c ): The thread is exiting
+      }
+   }
+
+   /// Give this thread the alternate stack, unless it already has one
+   void install() noexcept {
+      stack_t current {};
+      if( sigaltstack( nullptr, &current ) != 0 || ( current.ss_flags & SS_DISABLE ) == 0 ) {
+         return;
+      }
+      m_stack.reset( new( nothrow ) array< char, CRASH_STACK_SIZE > );
+      if( m_stack == nullptr ) {
+         return;  // Without it, the handler runs on the thread's own stack
+      }
+
+      stack_t stack {};
+      stack.ss_sp = m_stack->data();
+      stack.ss_size = m_stack->size();
+      if( sigaltstack( &stack, nullptr ) != 0 ) {
+         m_stack.reset();
+      }
+   }
+
+private:
+   unique_ptr< array< char, CRASH_STACK_SIZE > > m_stack;  ///< The stack (`nullptr` until install())
+};
+
+/// This thread's CrashStack
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-non-const-global-variables ): It's thread_local
+thread_local CrashStack ThisCrashStack;
+
+
+/// Write the dump, then let the signal do what it would have done
+///
+/// @param signal The signal
+void crashHandler( const int signal ) {
+   const pid_t self = gettid();
+   pid_t owner = 0;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( !DumpingThread.compare_exchange_weak( owner, self ) && owner != self ) {
+      owner = 0;  // Wait for the other thread's dump, so it isn't cut short
+   }
+
+   if( owner == 0 ) {
+      const int fd = CrashFd.load();
+      if( fd >= 0 ) {
+         writeLogCrashDump( fd, signal, CrashClock );
+      }
+      DumpingThread.store( 0 );
+   }
+
+   /// SA_RESETHAND put back the default action.  The signal is blocked until
+   /// we return, then it's delivered again.
+   raise( signal );  // NOLINT( cert-err33-c ): There's nothing we can do if it fails
+}
+
+
+/// @param path The dump file
+/// @return The `system_error` for a file that's not a crash dump
+system_error notALogCrashDump( const filesystem::path& path ) {
+   return system_error( make_error_code( errc::invalid_argument ), "Not a crash dump [" + path.string() + "]" );
+}
+
+
+/// Copy the good LogEntry records out of a ring in the dump
+///
+/// @param records The ring
+/// @param size The number of records in the ring (a power of 2)
+/// @param head The ring's head pointer when it was dumped
+/// @param entries Where to put them
+void collectEntries( const char* records, const uint64_t size, const uint64_t head, vector< LogEntry >& entries ) {
+   const uint64_t oldest = ( head > size ) ? head - size : 0;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( uint64_t index = oldest ; index < head ; index++ ) {
+      LogEntry entry {};
+      memcpy( &entry, records + ( index & ( size - 1 ) ) * sizeof( LogEntry ), sizeof( LogEntry ) );
+      if( !entry.ready || entry.writing || entry.sequence != index || entry.msg_end != 0 ) {
+         continue;  // Never written, being written or overwritten
+      }
+      if( entry.fmt != nullptr ) {
+         /// A `LOG_DEFERRED` LogEntry holds packed arguments and a pointer to
+         /// a format string in the crashed process
+         strncpy( entry.msg, "(deferred arguments not decoded)", sizeof( entry.msg ) - 1 );  // NOLINT( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): `char[]` arrays are used in the Log module
+         entry.fmt = nullptr;
+      }
+      if( entry.schema != nullptr ) {
+         /// LogEntry::schema points into the crashed process
+         strncpy( entry.msg, "(structured fields not decoded)", sizeof( entry.msg ) - 1 );  // NOLINT( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): `char[]` arrays are used in the Log module
+         entry.schema = nullptr;
+      }
+      entries.push_back( entry );
+   }
+}
+
+
+/// Convert a LogEntry::logTimestamp in a dump to wall-clock time (like
+/// logTicksToNs())
+///
+/// @param clock The dump's clock calibration
+/// @param ticks A raw logClockNow() reading
+/// @return Nanoseconds since the Unix epoch
+uint64_t crashTicksToNs( const LogCrashClock& clock, const uint64_t ticks ) {
+   const auto offsetNs = ( ticks >= clock.ticks )
+                       ?  static_cast< int64_t >( static_cast< double >( ticks - clock.ticks ) * clock.nsPerTick )
+                       : -static_cast< int64_t >( static_cast< double >( clock.ticks - ticks ) * clock.nsPerTick );
+   return clock.wallNs + static_cast< uint64_t >( offsetNs );
+}
+
+} // namespace
+
+
+void installLogCrashHandler( const filesystem::path& path ) {
+   calibrateLogClock();
+   const uint64_t ticks = logClockNow();
+   CrashClock = { ticks, logTicksToNs( ticks ), logNsPerTick() };
+
+   const int fd = open( path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644 );  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): rw-r--r--
+   if( fd < 0 ) {
+      throw system_error( errno, generic_category(), "Unable to open crash dump file [" + path.string() + "]" );
+   }
+
+   installLogCrashStack();
+
+   const int oldFd = CrashFd.exchange( fd );
+   if( oldFd >= 0 ) {
+      close( oldFd );
+      return;  // The handlers are already installed
+   }
+
+
+   struct sigaction action {};
+   action.sa_handler = crashHandler;
+   action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+   sigemptyset( &action.sa_mask );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < CRASH_SIGNALS.size() ; i++ ) {
+      if( sigaction( CRASH_SIGNALS[ i ], &action, &OldHandlers[ i ] ) != 0 ) {  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `i` < CRASH_SIGNALS.size()
+         const int error = errno;
+         uninstallLogCrashHandler();
+         throw system_error( error, generic_category(), "Unable to install the crash handler" );
+      }
+   }
+}
+
+
+void uninstallLogCrashHandler() {
+   const int fd = CrashFd.exchange( -1 );
+   if( fd < 0 ) {
+      return;
+   }
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < CRASH_SIGNALS.size() ; i++ ) {
+      sigaction( CRASH_SIGNALS[ i ], &OldHandlers[ i ], nullptr );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `i` < CRASH_SIGNALS.size()
+   }
+
+   /// Wait out a `LOG_FATAL` that's dumping
+   pid_t none = 0;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( !DumpingThread.compare_exchange_weak( none, gettid() ) ) {
+      none = 0;
+   }
+   close( fd );
+   DumpingThread.store( 0 );
+}
+
+
+void installLogCrashStack() noexcept {
+   ThisCrashStack.install();
+}
+
+
+void logCrashDump() noexcept {
+   pid_t none = 0;
+   if( DumpingThread.compare_exchange_strong( none, gettid() ) ) {
+      const int fd = CrashFd.load();
+      if( fd >= 0 ) {
+         writeLogCrashDump( fd, 0, CrashClock );
+      }
+      DumpingThread.store( 0 );
+   }
+}
+
+
+LogMappedFile readLogCrashDump( const filesystem::path& path ) {
+   ifstream file( path, ios::binary );
+   if( !file ) {
+      throw system_error( errno, generic_category(), "Unable to open crash dump file [" + path.string() + "]" );
+   }
+   const vector< char > dump { istreambuf_iterator< char >( file ), istreambuf_iterator< char >() };
+
+   LogCrashHeader header {};
+   if( dump.size() < sizeof( header ) ) {
+      throw notALogCrashDump( path );
+   }
+   memcpy( &header, dump.data(), sizeof( header ) );
+
+   const uint64_t queueSize = header.queueSize;
+   const uint64_t ringSize = header.threadRingSize;
+   const bool isPowerOf2 = queueSize > 0 && ringSize > 0 && ( queueSize & ( queueSize - 1 ) ) == 0 && ( ringSize & ( ringSize - 1 ) ) == 0;
+   if( header.magic != LOG_CRASH_MAGIC
+    || header.version != LOG_CRASH_VERSION
+    || header.recordSize != sizeof( LogEntry )
+    || header.moduleCount > MAX_LOG_MODULES
+    || header.threadRingCount > MAX_LOG_THREAD_RINGS
+    || !isPowerOf2
+    || dump.size() != sizeof( header )
+                    + header.moduleCount * MODULE_NAME_LENGTH
+                    + queueSize * sizeof( LogEntry )
+                    + header.threadRingCount * ( sizeof( uint64_t ) + ringSize * sizeof( LogEntry ) ) ) {
+      throw notALogCrashDump( path );
+   }
+
+   LogMappedFile result;
+   const char* next = dump.data() + sizeof( header );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( uint32_t id = 0 ; id < header.moduleCount ; id++ ) {
+      result.moduleNames.emplace_back( next, strnlen( next, MODULE_NAME_LENGTH ) );
+      next += MODULE_NAME_LENGTH;
+   }
+
+   collectEntries( next, queueSize, header.logIndex, result.entries );
+   next += queueSize * sizeof( LogEntry );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( uint64_t ring = 0 ; ring < header.threadRingCount ; ring++ ) {
+      uint64_t head = 0;
+      memcpy( &head, next, sizeof( head ) );
+      next += sizeof( head );
+      collectEntries( next, ringSize, head, result.entries );
+      next += ringSize * sizeof( LogEntry );
+   }
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( LogEntry& entry : result.entries ) {
+      entry.logTimestamp = crashTicksToNs( header.clock, entry.logTimestamp );
+   }
+
+   /// The rings each have their own sequence, so put them in time order
+   sort( result.entries.begin(), result.entries.end(), logEntryTimeOrder );
+
+   return result;
+}
+
+// NOLINTEND( cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast )
+
+} // namespace empire
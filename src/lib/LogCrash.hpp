@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Dump the in-memory log when the process crashes (or calls `LOG_FATAL`)
+///
+/// When the server dies, the LogEntry records in empire::LogQueue (and the
+/// per-thread rings) that the LogConsumer threads haven't written yet are
+/// exactly the ones we want.  installLogCrashHandler() opens a dump file up
+/// front and catches `SIGSEGV`, `SIGABRT` and `SIGBUS`.  The handler (and
+/// `LOG_FATAL`) copies the raw rings to the file with nothing but `write()`:
+/// no allocation, no formatting and no locks.  Use `empire_logdump` to read
+/// the file.
+///
+/// The dump is a LogCrashHeader, then LogCrashHeader::moduleCount names of
+/// empire::MODULE_NAME_LENGTH bytes, then empire::LogQueue, then
+/// LogCrashHeader::threadRingCount per-thread rings (each is its `uint64_t`
+/// head followed by its LogEntry records).
+///
+/// @file      LogCrash.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>       // For array<>
+#include <cstdint>     // For int32_t uint32_t uint64_t
+#include <filesystem>  // For path
+
+#include "LogSinkMapped.hpp"  // For LogMappedFile
+
+namespace empire {
+
+/// How to convert the LogEntry::logTimestamp ticks in a crash dump to
+/// wall-clock time (see logTicksToNs())
+struct LogCrashClock {
+   uint64_t ticks;      ///< A logClockNow() reading
+   uint64_t wallNs;     ///< The wall-clock time of #ticks in nanoseconds since the Unix epoch
+   double   nsPerTick;  ///< From logNsPerTick()
+};
+
+/// The start of a file written by writeLogCrashDump()
+///
+/// The LogEntry records haven't been through a LogConsumer yet, so their
+/// LogEntry::logTimestamp is still in raw logClockNow() ticks.
+struct LogCrashHeader {
+   std::array< char, 8 > magic;  ///< LOG_CRASH_MAGIC
+   uint32_t version;             ///< LOG_CRASH_VERSION
+   uint32_t recordSize;          ///< `sizeof( LogEntry )`
+   uint64_t logIndex;            ///< LogQueue's head pointer (LogIndex)
+   uint64_t queueSize;           ///< empire::SIZE_OF_QUEUE
+   uint64_t threadRingCount;     ///< The number of per-thread rings in the dump
+   uint64_t threadRingSize;      ///< empire::SIZE_OF_THREAD_RING
+   uint32_t moduleCount;         ///< The number of module names in the dump
+   int32_t  signal;              ///< The signal that caused the dump (0 for `LOG_FATAL`)
+   LogCrashClock clock;          ///< Converts LogEntry::logTimestamp to wall-clock time
+};
+
+/// The first 8 bytes of a file written by writeLogCrashDump()
+constinit const std::array< char, 8 > LOG_CRASH_MAGIC { 'E', 'M', 'P', 'I', 'R', 'E', 'C', 'R' };
+
+/// The version of the crash dump format
+constinit const uint32_t LOG_CRASH_VERSION { 1 };
+
+
+/// Open a crash dump file and catch `SIGSEGV`, `SIGABRT` and `SIGBUS`
+///
+/// The handler writes the dump and then lets the signal do what it would have
+/// done (usually dump core).  If another thread is dumping (a `LOG_FATAL` or
+/// another crash), it waits for that dump first.  The thread that calls this
+/// gets an alternate stack (see installLogCrashStack()), so a stack overflow
+/// in it is still dumped.  Calling it again moves the dump to a new file.
+///
+/// @param path The dump file.  It's truncated each time a dump is written.
+/// @throws system_error if the file can't be opened or the handlers can't be
+///                      installed
+extern void installLogCrashHandler( const std::filesystem::path& path );
+
+
+/// Put back the signal handlers we replaced and close the dump file
+extern void uninstallLogCrashHandler();
+
+
+/// Give this thread an alternate stack for the crash handler, unless it
+/// already has one
+///
+/// A stack overflow is only dumped on a thread with an alternate stack.  The
+/// thread that calls installLogCrashHandler() and every thread that claims a
+/// per-thread ring get one.  Other threads can call this.  The stack is freed
+/// when the thread exits.
+extern void installLogCrashStack() noexcept;
+
+
+/// Write the raw log rings to a file descriptor
+///
+/// It's async-signal-safe:  It only calls `write()`, `lseek()` and
+/// `ftruncate()`.  The LogEntry records are copied as they are, so a producer
+/// could be writing one while it's copied.  readLogCrashDump() skips those.
+///
+/// @param fd The file descriptor (written from the start)
+/// @param signal The signal that caused the dump (0 for `LOG_FATAL`)
+/// @param clock The clock calibration, taken ahead of time (calibrating
+///              isn't async-signal-safe)
+/// @return `false` if a `write()` failed
+extern bool writeLogCrashDump( int fd, int signal, const LogCrashClock& clock ) noexcept;
+
+
+/// Read a file written by writeLogCrashDump()
+///
+/// LogEntry::logTimestamp is converted to wall-clock time.  LogEntry records
+/// from `LOG_DEFERRED` modules were never formatted, so their message says so.
+///
+/// @param path The dump file
+/// @return The module names and the good records, oldest first
+/// @throws system_error if the file can't be read or is not a crash dump
+extern LogMappedFile readLogCrashDump( const std::filesystem::path& path );
+
+} // namespace empire
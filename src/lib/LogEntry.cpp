@@ -8,8 +8,60 @@
 /// @copyright (c) 2023 Mark Nelson.  All rights reserved.
 ///////////////////////////////////////////////////////////////////////////////
 
-// #include "LogEntry.hpp"
+#include <array>    // For array<>
+#include <cstdio>   // For snprintf()
+#include <ctime>    // For gmtime_r() strftime()
+
+#include "LogClock.hpp"  // For NS_PER_SECOND
+#include "LogEntry.hpp"
+#include "LogKv.hpp"     // For formatLogKvText()
 
 namespace empire {
 
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): We are using `snprintf()`
+size_t formatLogEntry( const LogEntry& entry, char* buffer, const size_t bufferSize ) {
+   BOOST_ASSERT_MSG( buffer != nullptr, "Buffer can't be NULL" );
+   BOOST_ASSERT_MSG( bufferSize > 1, "Buffer must have room for a newline and a null" );
+
+   const std::time_t seconds = static_cast< std::time_t >( entry.logTimestamp / NS_PER_SECOND );
+   std::tm utc {};
+   gmtime_r( &seconds, &utc );
+
+   /// Big enough for `YYYY-MM-DD HH:MM:SS`
+   std::array< char, 24 > timestamp {};  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The size of a timestamp
+   strftime( timestamp.data(), timestamp.size(), "%Y-%m-%d %H:%M:%S", &utc );
+
+   /// A structured LogEntry is formatted as `message key=value...`
+   std::array< char, LOG_MSG_LENGTH > fields {};
+   const char* message = entry.msg;
+   if( entry.schema != nullptr ) {
+      formatLogKvText( entry, fields.data(), fields.size() );
+      message = fields.data();
+   }
+
+   const int length = snprintf( buffer, bufferSize, "%s.%09llu %-7s %s: %s\n"
+                              , timestamp.data()
+                              , static_cast< unsigned long long >( entry.logTimestamp % NS_PER_SECOND )
+                              , LogSeverityToString( entry.logSeverity ).data()
+                              , logModuleName( entry.moduleId )
+                              , message );
+
+   if( length < 0 ) {
+      buffer[ 0 ] = '\0';  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): `buffer` has at least 1 byte
+      return 0;
+   }
+
+   /// If the line was truncated, make sure it still ends with a `\n`
+   if( static_cast< size_t >( length ) >= bufferSize ) {
+      // NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-pointer-arithmetic ): `bufferSize` is >= 2
+      buffer[ bufferSize - 2 ] = '\n';
+      return bufferSize - 1;
+   }
+
+   return static_cast< size_t >( length );
+}
+// NOLINTEND( cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+
 } // namespace empire
@@ -9,44 +9,118 @@
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 
-#include <chrono>         // For time_t
 #include <cstddef>        // For size_t
 #include <cstdint>        // For uint64_t
 
-#include "LogConfig.hpp"  // For LOG_ALIGNMENT, LOG_MSG_LENGTH, MODULE_NAME_LENGTH
+#include "LogConfig.hpp"  // For LOG_ALIGNMENT, logMsgLength()
+#include "LogModule.hpp"  // For LogModuleId
 #include "LogSeverity.hpp"
 
 namespace empire {
 
+struct LogKvSchema;  // See LogKv.hpp
+
 /// A structure that holds each entry in empire::LogQueue
 ///
-/// Every instance will be aligned to empire::LOG_ALIGNMENT.
+/// Every instance is `SlotBytes` long and aligned to `SlotBytes`.  The rest of
+/// the logger uses LogEntry, which is the size empire::LOG_RING_PRESET picked.
+///
+/// The publication fields (LogEntry::ready, LogEntry::writing and
+/// LogEntry::sequence) are plain members accessed through `std::atomic_ref`,
+/// rather than `std::atomic` members, so LogEntry stays trivially copyable.
+/// A LogConsumer copies a whole LogEntry and then checks that
+/// LogEntry::sequence and LogEntry::ready didn't change (like a seqlock).
 ///
 /// @NOLINTBEGIN( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): `char[]` arrays are used in the Log module
 /// @NOLINTBEGIN( altera-struct-pack-align ): We are not packing data as it's not standardized yet
-struct alignas( LOG_ALIGNMENT ) LogEntry {
-   /// The log message (aligned to the first half of each LogEntry)
-   [[maybe_unused]] alignas( LOG_ALIGNMENT >> 1U ) char msg[ LOG_MSG_LENGTH ];
+///
+/// @tparam SlotBytes The size of a LogEntry (a power of 2)
+template< size_t SlotBytes >
+struct alignas( SlotBytes ) BasicLogEntry {
+   /// The log message (aligned to the start of each LogEntry)
+   [[maybe_unused]] alignas( SlotBytes >> 1U ) char msg[ logMsgLength( SlotBytes ) ];
 
    /// A null byte to terminate LogEntry::msg
    [[maybe_unused]] uint64_t msg_end;
 
-   /// The module that generated this LogEntry
-   [[maybe_unused]] alignas( MODULE_NAME_LENGTH ) char module_name[ MODULE_NAME_LENGTH ];
-
-   /// A null byte to terminate LogEntry::module_name
-   [[maybe_unused]] uint64_t module_end;
+   /// The module that generated this LogEntry.  Use logModuleName() to get
+   /// its name.
+   [[maybe_unused]] LogModuleId moduleId;
 
    /// The severity of this LogEntry
    [[maybe_unused]] alignas( size_t ) LogSeverity logSeverity;
 
    /// The timestamp of this LogEntry
-   [[maybe_unused]] alignas( size_t ) std::time_t logTimestamp;
+   ///
+   /// In empire::LogQueue, it's the raw logClockNow() tick count.  A
+   /// LogConsumer converts it to nanoseconds since the Unix epoch (with
+   /// logTicksToNs()) before any LogSink sees it.
+   [[maybe_unused]] alignas( size_t ) uint64_t logTimestamp;
 
    /// `true` if the LogEntry is ready to process.  `false` if it's being composed.
+   ///
+   /// Always access it with `std::atomic_ref`.  The producer sets it with
+   /// `memory_order_release` after it's written everything else.
    bool ready;
+
+   /// `true` while a producer owns this LogEntry.  It keeps a producer that
+   /// laps a slow producer from writing into the same LogEntry at the same
+   /// time.  Always access it with `std::atomic_ref`.
+   bool writing;
+
+   /// The empire::LogIndex value the producer claimed for this LogEntry.  It's
+   /// monotonic, so a LogConsumer can tell if a producer lapped it.
+   ///
+   /// Always access it with `std::atomic_ref`.
+   alignas( size_t ) uint64_t sequence;
+
+   /// The `printf`-style format string of a deferred LogEntry, or `nullptr`
+   /// if LogEntry::msg is already formatted.  When it's set, LogEntry::msg
+   /// holds the packed arguments (see LogArgs.hpp) and the LogConsumer formats
+   /// it with expandLogEntry().
+   const char* fmt;
+
+   /// The LogKvSchema of a structured LogEntry (from a `LOG_*_KV` macro), or
+   /// `nullptr` for a plain one.  When it's set, LogEntry::msg holds the
+   /// packed field values (see LogKv.hpp).
+   const LogKvSchema* schema;
 };
+
+/// The LogEntry for this build
+using LogEntry = BasicLogEntry< LOG_ALIGNMENT >;
+
+static_assert( sizeof( LogEntry ) == LOG_ALIGNMENT, "LogEntry must fit in LOG_ALIGNMENT bytes" );
 // NOLINTEND( altera-struct-pack-align )
 // NOLINTEND( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays )
 
+
+/// Format a LogEntry as one line of text
+///
+/// The line looks like:
+///
+///     2023-06-14 21:03:55.123456789 info    test_Log: Test log entry with 1 parameter
+///
+/// The timestamp is in UTC, with nanoseconds, and the line ends with a `\n`.
+/// LogEntry::logTimestamp must already be converted to nanoseconds.
+///
+/// @param entry The LogEntry to format
+/// @param buffer Where to put the formatted line
+/// @param bufferSize The size of `buffer`.  Use empire::LOG_LINE_LENGTH.
+/// @return The length of the formatted line (not including the null
+///         terminator).  The line is truncated if it doesn't fit in `buffer`.
+extern size_t formatLogEntry( const LogEntry& entry, char* buffer, size_t bufferSize );
+
+
+/// Order LogEntry records by LogEntry::logTimestamp, then LogEntry::sequence
+///
+/// Merges records from rings that each have their own sequence.  Use it with
+/// `sort()`, not `stable_sort()`:  `stable_sort()`'s temporary buffer doesn't
+/// honor LogEntry's alignment.  The LogEntry::sequence tie-break keeps the
+/// order of records with the same timestamp.
+///
+/// @return `true` if `a` goes before `b`
+inline bool logEntryTimeOrder( const LogEntry& a, const LogEntry& b ) {
+   return a.logTimestamp < b.logTimestamp || ( a.logTimestamp == b.logTimestamp && a.sequence < b.sequence );
+}
+
 } // namespace empire
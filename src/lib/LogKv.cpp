@@ -0,0 +1,406 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Decode structured (key/value) log fields as text, JSON or binary
+///
+/// @file      LogKv.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>    // For array<>
+#include <cstdint>  // For uint8_t uint16_t uint32_t uint64_t
+#include <cstdio>   // For snprintf()
+#include <cstring>  // For memcpy() strlen() strnlen()
+
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+
+#include "LogKv.hpp"
+#include "LogModule.hpp"    // For logModuleName()
+#include "LogSeverity.hpp"  // For LogSeverityToString()
+
+using namespace std;
+
+namespace empire {
+
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the buffers with pointers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): We are using `snprintf()`
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+
+namespace {
+
+/// Append text to a buffer, truncating (but always null-terminating) if it's
+/// full
+class LogKvWriter {
+public:
+   /// @param buffer Where to put the text
+   /// @param bufferSize The size of `buffer` (at least 1)
+   LogKvWriter( char* buffer, const size_t bufferSize ) : m_buffer( buffer ), m_size( bufferSize ) {
+      m_buffer[ 0 ] = '\0';
+   }
+
+   /// @param str The characters to append
+   /// @param length The number of characters
+   void append( const char* str, const size_t length ) {
+      const size_t room = m_size - 1 - m_length;
+      const size_t count = length < room ? length : room;
+      memcpy( m_buffer + m_length, str, count );
+      m_length += count;
+      m_buffer[ m_length ] = '\0';
+   }
+
+   /// @param str A null-terminated string to append
+   void append( const char* str ) {
+      append( str, strlen( str ) );
+   }
+
+   /// Append a value with `snprintf()`
+   ///
+   /// @param fmt The `printf` format
+   /// @param value The value
+   template< typename T >
+   void print( const char* fmt, const T value ) {
+      const int written = snprintf( m_buffer + m_length, m_size - m_length, fmt, value );
+      if( written > 0 ) {
+         m_length += static_cast< size_t >( written );
+      }
+      if( m_length >= m_size ) {
+         m_length = m_size - 1;
+      }
+   }
+
+   /// Append a floating point value with `snprintf()`, or `missing` if it's
+   /// NaN or infinite
+   ///
+   /// It checks the text, not isfinite():  Release builds use `-Ofast`, which
+   /// lets the compiler assume isfinite() is always `true`.
+   ///
+   /// @param fmt The `printf` format
+   /// @param value The value
+   /// @param missing What to append instead of NaN or infinity
+   template< typename T >
+   void printFinite( const char* fmt, const T value, const char* missing ) {
+      array< char, 64 > number {};  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Room for any `%.21Lg`
+      if( snprintf( number.data(), number.size(), fmt, value ) < 0 ) {
+         append( missing );
+         return;
+      }
+      const char first = ( number[ 0 ] == '-' || number[ 0 ] == '+' ) ? number[ 1 ] : number[ 0 ];
+      append( ( first == 'n' || first == 'i' ) ? missing : number.data() );
+   }
+
+   /// Append a JSON string (with its quotes), escaping what JSON requires
+   ///
+   /// @param str The characters
+   /// @param length The number of characters
+   void appendJsonString( const char* str, const size_t length ) {
+      append( "\"", 1 );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t i = 0 ; i < length ; i++ ) {
+         const auto c = static_cast< unsigned char >( str[ i ] );
+         switch( c ) {
+            case '"':  append( "\\\"", 2 ); break;
+            case '\\': append( "\\\\", 2 ); break;
+            case '\n': append( "\\n", 2 );  break;
+            case '\r': append( "\\r", 2 );  break;
+            case '\t': append( "\\t", 2 );  break;
+            default:
+               if( c < 0x20 ) {  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The first printable character
+                  print( "\\u%04x", static_cast< unsigned int >( c ) );
+               } else {
+                  append( &str[ i ], 1 );
+               }
+         }
+      }
+      append( "\"", 1 );
+   }
+
+   /// @return The length of the text
+   [[nodiscard]] size_t length() const {
+      return m_length;
+   }
+
+private:
+   char*  m_buffer;    ///< Where the text goes
+   size_t m_size;      ///< The size of #m_buffer
+   size_t m_length{};  ///< The length of the text so far
+};
+
+
+/// How appendValue() renders a value
+enum class LogKvStyle {
+   text,  ///< `printf`-style, strings in quotes, a missing value is `?`
+   json   ///< JSON, a missing value is `null`
+};
+
+
+/// Read the next packed field and append its value
+///
+/// @param reader The packed fields
+/// @param expected The LogArgType from the LogKvSchema
+/// @param out Where to append the value
+/// @param style How to render it
+void appendValue( LogArgReader& reader, const LogArgType expected, LogKvWriter& out, const LogKvStyle style ) {
+   const bool json = style == LogKvStyle::json;
+   const char* const missing = json ? "null" : "?";
+
+   if( reader.peek() != expected || expected == LogArgType::end ) {
+      out.append( missing );  // It didn't fit
+      return;
+   }
+
+   /// Read the value as `T` and print it with `fmt`
+   auto readAndPrint = [ & ]< typename T >( T value, const char* fmt ) {
+      if( reader.read( value ) ) {
+         out.print( fmt, value );
+      } else {
+         out.append( missing );
+      }
+   };
+
+   switch( expected ) {
+      case LogArgType::signedInt:        readAndPrint( int {}, "%d" );                                   break;
+      case LogArgType::unsignedInt:      readAndPrint( static_cast< unsigned int >( 0 ), "%u" );         break;
+      case LogArgType::signedLong:       readAndPrint( long {}, "%ld" );                                 break;
+      case LogArgType::unsignedLong:     readAndPrint( static_cast< unsigned long >( 0 ), "%lu" );       break;
+      case LogArgType::signedLongLong:   readAndPrint( static_cast< long long >( 0 ), "%lld" );          break;
+      case LogArgType::unsignedLongLong: readAndPrint( static_cast< unsigned long long >( 0 ), "%llu" ); break;
+      case LogArgType::floatingPoint: {
+         double value {};
+         if( !reader.read( value ) ) {
+            out.append( missing );
+         } else if( json ) {
+            out.printFinite( "%.17g", value, missing );
+         } else {
+            out.print( "%g", value );
+         }
+         break;
+      }
+      case LogArgType::longDouble: {
+         long double value {};
+         if( !reader.read( value ) ) {
+            out.append( missing );
+         } else if( json ) {
+            out.printFinite( "%.21Lg", value, missing );
+         } else {
+            out.print( "%Lg", value );
+         }
+         break;
+      }
+      case LogArgType::pointer: {
+         const void* value {};
+         if( !reader.read( value ) ) {
+            out.append( missing );
+         } else if( json ) {
+            array< char, 24 > text {};  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Longer than any pointer
+            const int length = snprintf( text.data(), text.size(), "%p", value );
+            out.appendJsonString( text.data(), length > 0 ? static_cast< size_t >( length ) : 0 );
+         } else {
+            out.print( "%p", value );
+         }
+         break;
+      }
+      case LogArgType::string: {
+         const char* const str = reader.readString();
+         if( str == nullptr ) {
+            out.append( missing );
+         } else if( json ) {
+            out.appendJsonString( str, strlen( str ) );
+         } else {
+            out.append( "\"", 1 );
+            out.append( str );
+            out.append( "\"", 1 );
+         }
+         break;
+      }
+      case LogArgType::end:
+         break;
+   }
+}
+
+
+/// Append a `uint16_t` length and then the characters of a string to a binary record
+///
+/// @param out Where the record is going
+/// @param offset The length of the record so far
+/// @param outSize The size of `out`
+/// @param str The characters
+/// @param length The number of characters
+/// @return `false` if it doesn't fit
+bool putBinaryString( char* out, size_t& offset, const size_t outSize, const char* str, const size_t length ) {
+   const auto length16 = static_cast< uint16_t >( length < UINT16_MAX ? length : UINT16_MAX );
+   if( offset + sizeof( length16 ) + length16 > outSize ) {
+      return false;
+   }
+   memcpy( out + offset, &length16, sizeof( length16 ) );
+   memcpy( out + offset + sizeof( length16 ), str, length16 );
+   offset += sizeof( length16 ) + length16;
+   return true;
+}
+
+
+/// Append some bytes to a binary record
+///
+/// @param out Where the record is going
+/// @param offset The length of the record so far
+/// @param outSize The size of `out`
+/// @param value The bytes
+/// @param size The number of bytes
+/// @return `false` if it doesn't fit
+bool putBinary( char* out, size_t& offset, const size_t outSize, const void* value, const size_t size ) {
+   if( offset + size > outSize ) {
+      return false;
+   }
+   memcpy( out + offset, value, size );
+   offset += size;
+   return true;
+}
+
+} // namespace
+
+
+size_t formatLogKvText( const LogEntry& entry, char* buffer, const size_t bufferSize ) {
+   BOOST_ASSERT_MSG( entry.schema != nullptr, "The LogEntry is not structured" );
+   BOOST_ASSERT_MSG( buffer != nullptr, "Buffer can't be NULL" );
+   BOOST_ASSERT_MSG( bufferSize > 0, "Buffer must have room for a null" );
+
+   const LogKvSchema& schema = *entry.schema;
+   LogKvWriter out( buffer, bufferSize );
+   LogArgReader reader( entry.msg, LOG_MSG_LENGTH );
+
+   out.append( schema.message );
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < schema.fieldCount ; i++ ) {
+      out.append( " " );
+      out.append( schema.keys[ i ] );
+      out.append( "=" );
+      appendValue( reader, schema.types[ i ], out, LogKvStyle::text );
+   }
+
+   return out.length();
+}
+
+
+void expandLogKvEntry( LogEntry& entry ) {
+   if( entry.schema == nullptr ) {
+      return;
+   }
+
+   array< char, LOG_MSG_LENGTH > formatted {};
+   formatLogKvText( entry, formatted.data(), formatted.size() );
+
+   memcpy( entry.msg, formatted.data(), LOG_MSG_LENGTH );
+   entry.schema = nullptr;
+}
+
+
+size_t formatLogEntryJson( const LogEntry& entry, char* buffer, const size_t bufferSize ) {
+   BOOST_ASSERT_MSG( buffer != nullptr, "Buffer can't be NULL" );
+   BOOST_ASSERT_MSG( bufferSize > 0, "Buffer must have room for a null" );
+
+   LogKvWriter out( buffer, bufferSize );
+   const char* const module = logModuleName( entry.moduleId );
+   const string_view severity = LogSeverityToString( entry.logSeverity );
+
+   out.print( "{\"ts\":%llu,\"severity\":", static_cast< unsigned long long >( entry.logTimestamp ) );
+   out.appendJsonString( severity.data(), severity.size() );
+   out.append( ",\"module\":" );
+   out.appendJsonString( module, strlen( module ) );
+   out.append( ",\"msg\":" );
+
+   if( entry.schema == nullptr ) {
+      out.appendJsonString( entry.msg, strnlen( entry.msg, LOG_MSG_LENGTH ) );
+   } else {
+      const LogKvSchema& schema = *entry.schema;
+      LogArgReader reader( entry.msg, LOG_MSG_LENGTH );
+
+      out.appendJsonString( schema.message, strlen( schema.message ) );
+      out.append( ",\"fields\":{" );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t i = 0 ; i < schema.fieldCount ; i++ ) {
+         if( i > 0 ) {
+            out.append( "," );
+         }
+         out.appendJsonString( schema.keys[ i ], strlen( schema.keys[ i ] ) );
+         out.append( ":" );
+         appendValue( reader, schema.types[ i ], out, LogKvStyle::json );
+      }
+      out.append( "}" );
+   }
+
+   out.append( "}\n" );
+   return out.length();
+}
+
+
+size_t encodeLogEntryBinary( const LogEntry& entry, char* buffer, const size_t bufferSize ) {
+   BOOST_ASSERT_MSG( buffer != nullptr, "Buffer can't be NULL" );
+
+   size_t offset = sizeof( uint32_t );  // The record length goes here at the end
+   if( offset > bufferSize ) {
+      return 0;
+   }
+
+   const LogKvSchema* const schema = entry.schema;
+   const uint64_t timestamp = entry.logTimestamp;
+   const auto severity = static_cast< uint8_t >( entry.logSeverity );
+   const auto fieldCount = static_cast< uint8_t >( schema == nullptr ? 0 : schema->fieldCount );
+   const char* const module = logModuleName( entry.moduleId );
+   const char* const message = ( schema == nullptr ) ? entry.msg : schema->message;
+   const size_t messageLength = ( schema == nullptr ) ? strnlen( entry.msg, LOG_MSG_LENGTH ) : strlen( schema->message );
+
+   bool fits = putBinary( buffer, offset, bufferSize, &timestamp, sizeof( timestamp ) )
+            && putBinary( buffer, offset, bufferSize, &severity, sizeof( severity ) )
+            && putBinary( buffer, offset, bufferSize, &fieldCount, sizeof( fieldCount ) )
+            && putBinaryString( buffer, offset, bufferSize, module, strlen( module ) )
+            && putBinaryString( buffer, offset, bufferSize, message, messageLength );
+
+   if( schema != nullptr ) {
+      LogArgReader reader( entry.msg, LOG_MSG_LENGTH );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      for( size_t i = 0 ; fits && i < fieldCount ; i++ ) {
+         LogArgType type = schema->types[ i ];
+         fits = putBinaryString( buffer, offset, bufferSize, schema->keys[ i ], strlen( schema->keys[ i ] ) );
+
+         if( reader.peek() != type ) {
+            type = LogArgType::end;  // It didn't fit in LogEntry::msg
+         }
+
+         if( type == LogArgType::string ) {
+            const char* const str = reader.readString();
+            if( str == nullptr ) {
+               type = LogArgType::end;
+               fits = fits && putBinary( buffer, offset, bufferSize, &type, sizeof( type ) );
+            } else {
+               fits = fits && putBinary( buffer, offset, bufferSize, &type, sizeof( type ) )
+                           && putBinaryString( buffer, offset, bufferSize, str, strlen( str ) );
+            }
+         } else if( type != LogArgType::end ) {
+            /// Copy the packed bytes as they are
+            array< char, sizeof( long double ) > value {};
+            const size_t size = logArgSize( type );
+            if( !reader.readBytes( value.data() ) ) {
+               type = LogArgType::end;
+            }
+            fits = fits && putBinary( buffer, offset, bufferSize, &type, sizeof( type ) )
+                        && ( type == LogArgType::end || putBinary( buffer, offset, bufferSize, value.data(), size ) );
+         } else {
+            fits = fits && putBinary( buffer, offset, bufferSize, &type, sizeof( type ) );
+         }
+      }
+   }
+
+   if( !fits ) {
+      return 0;
+   }
+
+   const auto length = static_cast< uint32_t >( offset );
+   memcpy( buffer, &length, sizeof( length ) );
+   return offset;
+}
+
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+} // namespace empire
@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Structured (key/value) log fields
+///
+/// A structured LogEntry comes from a `LOG_*_KV` macro:
+///
+///     LOG_INFO_KV( "sector moved", "nation", id, "x", x, "y", y );
+///
+/// The message and the keys must be string literals.  Each call site gets a
+/// `static constexpr` LogKvSchema (the message, the keys and the type of each
+/// value) and LogEntry::schema points to it.  The values are packed into
+/// LogEntry::msg just like the arguments of a deferred LogEntry (see
+/// LogArgs.hpp), so there's no formatting and no allocation on the
+/// producer's side.  Strings are copied.
+///
+/// A LogSink turns a structured LogEntry into text with formatLogKvText()
+/// (formatLogEntry() does this for the text sinks), a JSON line with
+/// formatLogEntryJson() or a binary record with encodeLogEntryBinary().
+///
+/// @file      LogKv.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>  // For size_t
+
+#include "LogArgs.hpp"  // For LogArgType LogArgTraits<> packLogArg()
+#include "LogEntry.hpp"
+
+namespace empire {
+
+/// The shape of a structured LogEntry, made at compile time for each
+/// `LOG_*_KV` call site
+struct LogKvSchema {
+   const char*        message;     ///< The message
+   size_t             fieldCount;  ///< The number of fields
+   const char* const* keys;        ///< The key of each field
+   const LogArgType*  types;       ///< The LogArgType of each field's value
+};
+
+/// The maximum number of fields in a `LOG_*_KV` macro
+constinit const size_t MAX_LOG_KV_FIELDS { 8 };
+
+
+/// Pack the values of a structured LogEntry into `buffer`
+///
+/// Unlike packLogArgs(), the fields are packed one at a time until one
+/// doesn't fit.  The LogKvSchema still has the keys of the fields that were
+/// cut off, so they're reported as missing.
+///
+/// @param buffer Where to pack the values.  Usually LogEntry::msg.
+/// @param values The values
+/// @return The number of fields that fit
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic ): We walk through the packed buffer with pointers
+template< typename... Values >
+inline size_t packLogKvValues( char* buffer, const Values&... values ) {
+   size_t offset = 0;
+   size_t packed = 0;
+   bool fits = true;
+
+   /// Stops at the first field that doesn't fit
+   auto packOne = [ & ]( const auto& value ) {
+      if( fits && offset + logArgPackedSize( value ) <= LOG_MSG_LENGTH ) {
+         offset += packLogArg( buffer + offset, value );
+         packed++;
+      } else {
+         fits = false;
+      }
+   };
+   ( packOne( values ), ... );
+
+   if( offset < LOG_MSG_LENGTH ) {
+      buffer[ offset ] = static_cast< char >( LogArgType::end );
+   }
+   return packed;
+}
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic )
+
+
+/// Format a structured LogEntry as text:  The message, then ` key=value` for
+/// each field.  Strings are quoted.  A field that didn't fit in LogEntry::msg
+/// is `key=?`.
+///
+/// @param entry A LogEntry with a LogEntry::schema
+/// @param buffer Where to put the text
+/// @param bufferSize The size of `buffer`
+/// @return The length of the text (not including the null terminator).  It's
+///         truncated if it doesn't fit in `buffer`.
+extern size_t formatLogKvText( const LogEntry& entry, char* buffer, size_t bufferSize );
+
+
+/// Turn a structured LogEntry into a plain one in place
+///
+/// LogEntry::msg is replaced with formatLogKvText() and LogEntry::schema is
+/// cleared.  Does nothing to a plain LogEntry.  Use it before a LogEntry
+/// leaves the process (where LogEntry::schema means nothing).
+///
+/// @param entry The LogEntry
+extern void expandLogKvEntry( LogEntry& entry );
+
+
+/// Format a LogEntry as one line of JSON
+///
+/// The line looks like:
+///
+///     {"ts":1686776635123456789,"severity":"info","module":"test_Log","msg":"sector moved","fields":{"nation":3,"x":10,"y":-2}}
+///
+/// `ts` is nanoseconds since the Unix epoch.  A plain LogEntry has no
+/// `fields`.  A field that didn't fit is `null`.  Numbers are JSON numbers
+/// (`NaN` and infinities are `null`), pointers are strings and strings are
+/// escaped.  The line ends with a `\n`.
+///
+/// @param entry The LogEntry
+/// @param buffer Where to put the line
+/// @param bufferSize The size of `buffer`.  Use empire::LOG_STRUCTURED_LENGTH.
+/// @return The length of the line.  If it doesn't fit, the line is cut off
+///         and it's not valid JSON.
+extern size_t formatLogEntryJson( const LogEntry& entry, char* buffer, size_t bufferSize );
+
+
+/// Encode a LogEntry as a binary record
+///
+/// The record is in the writer's byte order.  Each string is a `uint16_t`
+/// length followed by its bytes (no null terminator).
+///
+/// | Field          | Type                                      |
+/// |----------------|-------------------------------------------|
+/// | Record length  | `uint32_t` (including itself)             |
+/// | Timestamp      | `uint64_t` nanoseconds since the epoch    |
+/// | Severity       | `uint8_t` LogSeverity                     |
+/// | Field count    | `uint8_t`                                 |
+/// | Module         | string                                    |
+/// | Message        | string                                    |
+/// | Each field     | key (string), `uint8_t` LogArgType, value |
+///
+/// A value is the bytes of its LogArgType (see logArgSize()) or a string.
+/// A field that didn't fit is LogArgType::end with no value.
+///
+/// @param entry The LogEntry
+/// @param buffer Where to put the record
+/// @param bufferSize The size of `buffer`.  Use empire::LOG_STRUCTURED_LENGTH.
+/// @return The length of the record, or 0 if it doesn't fit
+extern size_t encodeLogEntryBinary( const LogEntry& entry, char* buffer, size_t bufferSize );
+
+} // namespace empire
+
+
+/// @cond Suppress Doxygen warnings
+/// Split the `key, value, key, value...` arguments of a `LOG_*_KV` macro
+///
+/// @NOLINTBEGIN( cppcoreguidelines-macro-usage ): We intend to use macros here
+#define LOG_KV_CAT_( a, b ) a##b
+#define LOG_KV_CAT( a, b ) LOG_KV_CAT_( a, b )
+#define LOG_KV_COUNT_( _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, count, ... ) count
+#define LOG_KV_COUNT( ... ) LOG_KV_COUNT_( __VA_ARGS__, 8, 8, 7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1 )
+#define LOG_KV_FOR_EACH( what, ... ) LOG_KV_CAT( LOG_KV_FOR_EACH_, LOG_KV_COUNT( __VA_ARGS__ ) )( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_1( what, key, value ) what( key, value )
+#define LOG_KV_FOR_EACH_2( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_1( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_3( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_2( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_4( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_3( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_5( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_4( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_6( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_5( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_7( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_6( what, __VA_ARGS__ )
+#define LOG_KV_FOR_EACH_8( what, key, value, ... ) what( key, value ), LOG_KV_FOR_EACH_7( what, __VA_ARGS__ )
+#define LOG_KV_KEY( key, value ) "" key
+#define LOG_KV_TYPE( key, value ) empire::LogArgTraits< decltype( ( value ) ) >::type()
+#define LOG_KV_VALUE( key, value ) value
+// NOLINTEND( cppcoreguidelines-macro-usage )
+/// @endcond
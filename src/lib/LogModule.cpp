@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// The table of modules (`LOG_MODULE` names) that write to the log
+///
+/// @file      LogModule.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>        // For array<>
+#include <atomic>       // For atomic<> atomic_size_t
+#include <cstring>      // For strcmp() strlen()
+#include <mutex>        // For mutex lock_guard<>
+#include <stdexcept>    // For range_error
+#include <string_view>  // For string_view
+
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+
+#include "LogConfig.hpp"  // For MAX_LOG_MODULES MODULE_NAME_LENGTH
+#include "LogModule.hpp"
+
+using namespace std;
+
+namespace empire {
+
+static_assert( MAX_LOG_MODULES <= ( 1U << ( sizeof( LogModuleId ) * 8 ) ), "LogModuleId is too small for MAX_LOG_MODULES" );
+
+/// The name of each registered module, indexed by LogModuleId
+///
+/// These are constant-initialized, so they're ready before any other
+/// source file's static initializers call registerLogModule().
+static constinit array< const char*, MAX_LOG_MODULES > LogModules {};
+
+/// The number of registered modules.  Readers load it with `acquire`, so
+/// they always see the name in empire::LogModules.
+static constinit atomic_size_t LogModuleCount { 0 };
+
+/// Serializes registerLogModule()
+static constinit mutex LogModuleLock {};
+
+/// The LogSeverity threshold new modules start with
+static constinit atomic< LogSeverity > LogDefaultSeverity { DEFAULT_LOG_SEVERITY };
+
+constinit array< atomic< LogSeverity >, MAX_LOG_MODULES > LogModuleSeverity {};
+
+
+LogModuleId registerLogModule( const char* name ) {
+   BOOST_ASSERT_MSG( name != nullptr, "Module name can't be NULL" );
+   BOOST_ASSERT_MSG( strlen( name ) < MODULE_NAME_LENGTH, "Module name must be < MODULE_NAME_LENGTH" );
+
+   const lock_guard< mutex > lock( LogModuleLock );
+
+   const size_t count = LogModuleCount.load( memory_order_relaxed );
+   for( size_t id = 0 ; id < count ; id++ ) {
+      if( strcmp( LogModules[ id ], name ) == 0 ) {  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` < `count` <= MAX_LOG_MODULES
+         return static_cast< LogModuleId >( id );
+      }
+   }
+
+   if( count >= MAX_LOG_MODULES ) {
+      /// @throws range_error if MAX_LOG_MODULES are already registered
+      throw range_error( "There are already MAX_LOG_MODULES modules registered" );
+   }
+
+   LogModules[ count ] = name;  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `count` < MAX_LOG_MODULES
+   LogModuleSeverity[ count ].store( LogDefaultSeverity.load( memory_order_relaxed ), memory_order_relaxed );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `count` < MAX_LOG_MODULES
+   LogModuleCount.store( count + 1, memory_order_release );
+
+   return static_cast< LogModuleId >( count );
+}
+
+
+const char* logModuleName( const LogModuleId id ) {
+   if( id >= LogModuleCount.load( memory_order_acquire ) ) {
+      return "unknown";
+   }
+   return LogModules[ id ];  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` < LogModuleCount <= MAX_LOG_MODULES
+}
+
+
+size_t logModuleCount() {
+   return LogModuleCount.load( memory_order_acquire );
+}
+
+
+void setLogSeverity( const LogSeverity severity ) {
+   BOOST_ASSERT_MSG( severity >= LogSeverity::test && severity <= LogSeverity::fatal, "Log severity not in range" );
+
+   const lock_guard< mutex > lock( LogModuleLock );
+
+   LogDefaultSeverity.store( severity, memory_order_relaxed );
+   for( atomic< LogSeverity >& threshold : LogModuleSeverity ) {
+      threshold.store( severity, memory_order_relaxed );
+   }
+}
+
+
+void setLogSeverity( const LogModuleId id, const LogSeverity severity ) {
+   BOOST_ASSERT_MSG( id < MAX_LOG_MODULES, "LogModuleId not in range" );
+   BOOST_ASSERT_MSG( severity >= LogSeverity::test && severity <= LogSeverity::fatal, "Log severity not in range" );
+
+   LogModuleSeverity[ id ].store( severity, memory_order_relaxed );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` < MAX_LOG_MODULES
+}
+
+
+bool setLogSeverity( const string_view name, const LogSeverity severity ) {
+   const size_t count = LogModuleCount.load( memory_order_acquire );
+   for( size_t id = 0 ; id < count ; id++ ) {
+      if( name == LogModules[ id ] ) {  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` < `count` <= MAX_LOG_MODULES
+         setLogSeverity( static_cast< LogModuleId >( id ), severity );
+         return true;
+      }
+   }
+   return false;
+}
+
+
+LogSeverity getLogSeverity( const LogModuleId id ) {
+   BOOST_ASSERT_MSG( id < MAX_LOG_MODULES, "LogModuleId not in range" );
+
+   return LogModuleSeverity[ id ].load( memory_order_relaxed );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` < MAX_LOG_MODULES
+}
+
+} // namespace empire
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// The table of modules (`LOG_MODULE` names) that write to the log
+///
+/// Each translation unit that includes Log.hpp registers its `LOG_MODULE`
+/// once, when it's statically initialized, and gets a small LogModuleId.
+/// Each LogEntry holds the LogModuleId rather than a copy of the name.  A
+/// LogConsumer turns it back into a name with logModuleName() when it formats
+/// the LogEntry.
+///
+/// Each module also has a runtime severity threshold.  The `LOG_*` macros
+/// check it (with one `relaxed` atomic load) before they queue a LogEntry,
+/// so a `LOG_DEBUG` can stay compiled in and be turned on for one module
+/// while the server is running.
+///
+/// @file      LogModule.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>        // For array<>
+#include <atomic>       // For atomic<>
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint16_t
+#include <string_view>  // For string_view
+
+#include "LogConfig.hpp"    // For MAX_LOG_MODULES
+#include "LogSeverity.hpp"  // For LogSeverity
+
+namespace empire {
+
+/// The index of a module in the module table
+using LogModuleId = uint16_t;
+
+
+/// Register a module name and get its LogModuleId
+///
+/// Registering the same name again returns the same LogModuleId, so a
+/// module that's split across several source files shares one LogModuleId.
+/// It's thread safe, but it takes a lock, so call it once and keep the
+/// result (Log.hpp does this for `LOG_MODULE`).
+///
+/// @param name The name of the module.  It must be shorter than
+///             empire::MODULE_NAME_LENGTH and must outlive the logger
+///             (a `static` `LOG_MODULE` does).
+/// @return The LogModuleId for `name`
+/// @throws range_error if empire::MAX_LOG_MODULES are already registered
+extern LogModuleId registerLogModule( const char* name );
+
+
+/// Get the name of a module
+///
+/// @param id A LogModuleId from registerLogModule()
+/// @return The name of the module, or `"unknown"` if `id` isn't registered
+extern const char* logModuleName( LogModuleId id );
+
+
+/// Get the number of registered modules
+///
+/// @return The number of modules in the module table
+extern size_t logModuleCount();
+
+
+/// The runtime severity threshold of each module, indexed by LogModuleId
+///
+/// Use setLogSeverity() to change it.  It's only exposed so the `LOG_*`
+/// macros can check it inline.
+extern std::array< std::atomic< LogSeverity >, MAX_LOG_MODULES > LogModuleSeverity;
+
+
+/// Check if a module logs at `severity`
+///
+/// This is the only cost of a `LOG_*` that's filtered at runtime.
+///
+/// @param id The LogModuleId of the module
+/// @param severity The severity of the LogEntry
+/// @return `true` if the LogEntry should be queued
+inline bool logSeverityEnabled( const LogModuleId id, const LogSeverity severity ) {
+   return severity >= LogModuleSeverity[ id ].load( std::memory_order_relaxed );  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): `id` came from registerLogModule()
+}
+
+
+/// Set the runtime severity threshold of every module (and of the modules
+/// that register later)
+///
+/// @param severity Log at and above this LogSeverity
+extern void setLogSeverity( LogSeverity severity );
+
+
+/// Set the runtime severity threshold of one module
+///
+/// @param id The LogModuleId of the module
+/// @param severity Log at and above this LogSeverity
+extern void setLogSeverity( LogModuleId id, LogSeverity severity );
+
+
+/// Set the runtime severity threshold of one module by name
+///
+/// @param name The name of the module (its `LOG_MODULE`)
+/// @param severity Log at and above this LogSeverity
+/// @return `false` if there's no module called `name`
+extern bool setLogSeverity( std::string_view name, LogSeverity severity );
+
+
+/// Get the runtime severity threshold of a module
+///
+/// @param id The LogModuleId of the module
+/// @return The lowest LogSeverity the module logs
+extern LogSeverity getLogSeverity( LogModuleId id );
+
+} // namespace empire
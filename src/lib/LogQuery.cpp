@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Search the LogEntry records that are still in memory
+///
+/// @file      LogQuery.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>  // For sort()
+#include <array>      // For array<>
+#include <cstring>    // For strnlen()
+
+#include "LogArgs.hpp"      // For expandLogEntry()
+#include "LogClock.hpp"     // For logTicksToNs()
+#include "LogConfig.hpp"    // For SIZE_OF_QUEUE SIZE_OF_THREAD_RING
+#include "LogConsumer.hpp"  // For logHead() logSnapshot() logThreadRingCount() logThreadRingHead() logThreadRingSnapshot()
+#include "LogKv.hpp"        // For formatLogKvText()
+#include "LogModule.hpp"    // For logModuleName()
+#include "LogQuery.hpp"
+
+using namespace std;
+
+namespace empire {
+
+namespace {
+
+/// Check a LogEntry against everything in a LogQuery but the time window
+///
+/// @param entry The LogEntry (with LogEntry::fmt already expanded)
+/// @param query What to look for
+/// @return `true` if it matches
+bool matches( const LogEntry& entry, const LogQuery& query ) {
+   if( entry.logSeverity < query.minSeverity || entry.logSeverity > query.maxSeverity ) {
+      return false;
+   }
+
+   if( !query.module.empty() && query.module != logModuleName( entry.moduleId ) ) {
+      return false;
+   }
+
+   if( query.contains.empty() ) {
+      return true;
+   }
+
+   if( entry.schema == nullptr ) {
+      return string_view( entry.msg, strnlen( entry.msg, LOG_MSG_LENGTH ) ).find( query.contains ) != string_view::npos;  // NOLINT( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): `char[]` arrays are used in the Log module
+   }
+
+   array< char, LOG_MSG_LENGTH > text {};
+   const size_t length = formatLogKvText( entry, text.data(), text.size() );
+   return string_view( text.data(), length ).find( query.contains ) != string_view::npos;
+}
+
+
+/// Copy the matching LogEntry records out of a ring
+///
+/// @param head The ring's head pointer
+/// @param size The number of LogEntry records in the ring
+/// @param snapshot Copies the LogEntry at an index (logSnapshot() or
+///                 logThreadRingSnapshot())
+/// @param query What to look for
+/// @param results Where to put the matches
+template< typename Snapshot >
+void searchRing( const size_t head, const size_t size, Snapshot snapshot, const LogQuery& query, vector< LogEntry >& results ) {
+   const size_t oldest = ( head > size ) ? head - size : 0;
+
+   LogEntry copy {};
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t index = oldest ; index < head ; index++ ) {
+      if( snapshot( index, copy ) != LogSnapshot::ready ) {
+         continue;  // Still being written or already overwritten
+      }
+
+      copy.logTimestamp = logTicksToNs( copy.logTimestamp );
+      if( copy.logTimestamp < query.sinceNs || copy.logTimestamp > query.untilNs ) {
+         continue;
+      }
+
+      expandLogEntry( copy );
+      if( matches( copy, query ) ) {
+         results.push_back( copy );
+      }
+   }
+}
+
+} // namespace
+
+
+vector< LogEntry > queryLog( const LogQuery& query ) {
+   vector< LogEntry > results;
+
+   searchRing( logHead(), SIZE_OF_QUEUE, []( const size_t index, LogEntry& copy ) {
+      return logSnapshot( index, copy );
+   }, query, results );
+
+   const size_t rings = logThreadRingCount();
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t ring = 0 ; ring < rings ; ring++ ) {
+      searchRing( logThreadRingHead( ring ), SIZE_OF_THREAD_RING, [ ring ]( const size_t index, LogEntry& copy ) {
+         return logThreadRingSnapshot( ring, index, copy );
+      }, query, results );
+   }
+
+   /// The rings each have their own sequence, so put them in time order
+   sort( results.begin(), results.end(), logEntryTimeOrder );
+
+   if( query.limit != 0 && results.size() > query.limit ) {
+      results.erase( results.begin(), results.end() - static_cast< ptrdiff_t >( query.limit ) );
+   }
+
+   return results;
+}
+
+} // namespace empire
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Search the LogEntry records that are still in memory
+///
+/// empire::LogQueue (and the per-thread rings) hold the most recent LogEntry
+/// records, whether or not a LogConsumer has written them yet.  queryLog()
+/// copies the ones that match a LogQuery out with logSnapshot(), so it never
+/// stops or slows down a producer.  A LogEntry that's overwritten while it's
+/// copied is skipped.  It's how a deity session looks at the log without a
+/// shell on the server.
+///
+/// @file      LogQuery.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint64_t UINT64_MAX
+#include <string_view>  // For string_view
+#include <vector>       // For vector<>
+
+#include "LogEntry.hpp"
+#include "LogSeverity.hpp"  // For LogSeverity
+
+namespace empire {
+
+/// What queryLog() looks for.  The defaults match everything.
+struct LogQuery {
+   LogSeverity minSeverity { LogSeverity::test };   ///< The lowest severity to match
+   LogSeverity maxSeverity { LogSeverity::fatal };  ///< The highest severity to match
+   std::string_view module {};                      ///< The module name to match (empty matches every module)
+   uint64_t sinceNs { 0 };                          ///< The earliest LogEntry::logTimestamp to match, in nanoseconds since the Unix epoch
+   uint64_t untilNs { UINT64_MAX };                 ///< The latest LogEntry::logTimestamp to match, in nanoseconds since the Unix epoch
+   std::string_view contains {};                    ///< Text the message must contain (empty matches every message)
+   size_t limit { 0 };                              ///< Return at most the newest `limit` matches (0 for all of them)
+};
+
+
+/// Find the LogEntry records in memory that match a LogQuery
+///
+/// Each match is a plain copy:  A deferred LogEntry is formatted, a
+/// structured one keeps its LogEntry::schema (its message is matched as
+/// formatLogKvText()) and LogEntry::logTimestamp is converted to wall-clock
+/// nanoseconds, just like a LogSink would see it.
+///
+/// @param query What to look for
+/// @return The matching LogEntry records, oldest first
+extern std::vector< LogEntry > queryLog( const LogQuery& query );
+
+} // namespace empire
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Per-call-site rate limiting and duplicate suppression for the logger
+///
+/// @file      LogRateLimit.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>  // For max()
+#include <atomic>     // For atomic<>
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "LogRateLimit" };
+
+#include "Log.hpp"           // For queueLogEntry()
+#include "LogClock.hpp"      // For calibrateLogClock() logClockNow() logNsPerTick() NS_PER_SECOND
+#include "LogRateLimit.hpp"
+
+using namespace std;
+
+namespace empire {
+
+namespace {
+
+/// The token bucket and repeat report interval in logClockNow() ticks
+struct LogRateTicks {
+   uint64_t interval;  ///< Ticks per token (0 if there's no rate limit)
+   uint64_t burst;     ///< The most the bucket can get ahead of now
+   uint64_t repeat;    ///< How often to report repeats
+};
+
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-non-const-global-variables ): They're in an anonymous namespace
+
+/// The values given to setLogRateLimit()
+constinit atomic< uint32_t > RatePerSecond { LOG_RATE_LIMIT_PER_SECOND };
+constinit atomic< uint32_t > RateBurst { LOG_RATE_LIMIT_BURST };
+
+/// The LogRateTicks fields.  RateReady is `false` until they're set (it
+/// takes a clock calibration).
+constinit atomic< uint64_t > RateInterval { 0 };
+constinit atomic< uint64_t > RateBurstTicks { 0 };
+constinit atomic< uint64_t > RepeatTicks { 0 };
+constinit atomic< bool > RateReady { false };
+
+// NOLINTEND( cppcoreguidelines-avoid-non-const-global-variables )
+
+
+/// Convert the rate limit to logClockNow() ticks
+void computeRateTicks() {
+   calibrateLogClock();
+   const double ticksPerSecond = static_cast< double >( NS_PER_SECOND ) / logNsPerTick();
+   const uint32_t perSecond = RatePerSecond.load();
+   const uint64_t interval = ( perSecond == 0 ) ? 0 : max( static_cast< uint64_t >( ticksPerSecond / perSecond ), uint64_t { 1 } );
+
+   RateInterval.store( interval );
+   RateBurstTicks.store( interval * max( RateBurst.load(), 1U ) );
+   RepeatTicks.store( static_cast< uint64_t >( ticksPerSecond * static_cast< double >( LOG_REPEAT_REPORT_SECONDS ) ) );
+   RateReady.store( true, memory_order_release );
+}
+
+
+/// @return The rate limit in logClockNow() ticks
+LogRateTicks rateTicks() {
+   if( !RateReady.load( memory_order_acquire ) ) {
+      computeRateTicks();
+   }
+   return { RateInterval.load( memory_order_relaxed ), RateBurstTicks.load( memory_order_relaxed ), RepeatTicks.load( memory_order_relaxed ) };
+}
+
+
+/// Queue a `Previous message repeated N times` LogEntry if there are repeats
+///
+/// @param site The call site
+/// @param severity The severity of the repeated LogEntry
+/// @param moduleId The LogModuleId of the repeated LogEntry
+/// @param now logClockNow()
+void reportRepeats( LogCallSite& site, const LogSeverity severity, const LogModuleId moduleId, const uint64_t now ) {
+   site.lastReport.store( now, memory_order_relaxed );
+   const uint32_t repeats = site.repeats.exchange( 0, memory_order_relaxed );
+   if( repeats > 0 ) {
+      queueLogEntry( severity, moduleId, "Previous message repeated %u times", repeats );  // NOLINT( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): queueLogEntry() is variadic
+   }
+}
+
+} // namespace
+
+
+void setLogRateLimit( const uint32_t perSecond, const uint32_t burst ) {
+   RatePerSecond.store( perSecond );
+   RateBurst.store( burst );
+   computeRateTicks();
+}
+
+
+uint32_t getLogRateLimitPerSecond() {
+   return RatePerSecond.load();
+}
+
+
+uint32_t getLogRateLimitBurst() {
+   return RateBurst.load();
+}
+
+
+bool logCallSiteAdmit( LogCallSite& site, const LogSeverity severity, const LogModuleId moduleId, const uint64_t hash ) {
+   const LogRateTicks ticks = rateTicks();
+   const uint64_t now = logClockNow();
+
+   /// A repeat of the last LogEntry from this call site is only counted
+   if( site.lastHash.load( memory_order_relaxed ) == hash ) {
+      site.repeats.fetch_add( 1, memory_order_relaxed );
+      uint64_t lastReport = site.lastReport.load( memory_order_relaxed );
+      if( now - lastReport >= ticks.repeat && site.lastReport.compare_exchange_strong( lastReport, now, memory_order_relaxed ) ) {
+         reportRepeats( site, severity, moduleId, now );
+      }
+      return false;
+   }
+
+   /// The token bucket, kept as the time it's full again (GCRA).  Each
+   /// LogEntry moves it one interval into the future.  If that's more than
+   /// a burst ahead of now, the bucket is empty.
+   if( ticks.interval != 0 ) {
+      uint64_t next = site.nextTicks.load( memory_order_relaxed );
+      uint64_t newNext = 0;
+      do {
+         newNext = max( next, now ) + ticks.interval;
+         if( newNext - now > ticks.burst ) {
+            site.limited.fetch_add( 1, memory_order_relaxed );
+            return false;
+         }
+      } while( !site.nextTicks.compare_exchange_weak( next, newNext, memory_order_relaxed ) );  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+   }
+
+   site.lastHash.store( hash, memory_order_relaxed );
+   reportRepeats( site, severity, moduleId, now );
+
+   const uint32_t limited = site.limited.exchange( 0, memory_order_relaxed );
+   if( limited > 0 ) {
+      queueLogEntry( severity, moduleId, "Rate limit dropped %u log entries", limited );  // NOLINT( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): queueLogEntry() is variadic
+   }
+
+   return true;
+}
+
+} // namespace empire
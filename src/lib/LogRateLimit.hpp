@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Per-call-site rate limiting and duplicate suppression for the logger
+///
+/// Define `LOG_RATE_LIMIT` before including Log.hpp and every `LOG_*` macro
+/// in the source file gets its own `static` LogCallSite.  Before a LogEntry
+/// is queued, logCallSiteAdmit() checks it against its LogCallSite:
+///
+///   - If it's the same message the call site queued last time, it's
+///     counted, not queued.  A `Previous message repeated N times` LogEntry
+///     is queued when the message changes (and every
+///     empire::LOG_REPEAT_REPORT_SECONDS while it doesn't).
+///   - Otherwise, it takes a token from the call site's token bucket (see
+///     setLogRateLimit()).  If the bucket is empty, it's counted and
+///     dropped.  The next LogEntry that gets through is preceded by a
+///     `Rate limit dropped N log entries` LogEntry.
+///
+/// So a runaway loop can't flush empire::LogQueue.  It's all atomics on the
+/// call site:  no locks.  The counts are reported the next time the call site
+/// logs, so a call site that goes quiet keeps its last count.
+///
+/// @file      LogRateLimit.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>   // For atomic<>
+#include <cstddef>  // For size_t
+#include <cstdint>  // For uint32_t uint64_t
+
+#include "LogModule.hpp"    // For LogModuleId
+#include "LogSeverity.hpp"  // For LogSeverity
+
+namespace empire {
+
+/// The rate limit and duplicate state of one `LOG_*` macro
+///
+/// It's zero-initialized, so a `static` LogCallSite costs nothing until the
+/// call site logs.  Each one has its own cache line.
+struct alignas( 64 ) LogCallSite {  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): A cache line
+   std::atomic< uint64_t > nextTicks;   ///< When the token bucket is full again (the "theoretical arrival time" of the next LogEntry) in logClockNow() ticks
+   std::atomic< uint64_t > lastHash;    ///< logHashMessage() of the last LogEntry queued
+   std::atomic< uint64_t > lastReport;  ///< When the repeats were last reported, in logClockNow() ticks
+   std::atomic< uint32_t > repeats;     ///< The repeats of the last LogEntry since they were reported
+   std::atomic< uint32_t > limited;     ///< The LogEntry records dropped by the rate limit since they were reported
+};
+
+
+/// Set the token bucket for every `LOG_RATE_LIMIT` call site
+///
+/// @param perSecond The LogEntry records per second a call site can queue
+///                  over the long run (0 turns the rate limit off)
+/// @param burst The LogEntry records a quiet call site can queue
+///              back-to-back (at least 1)
+extern void setLogRateLimit( uint32_t perSecond, uint32_t burst );
+
+
+/// @return The LogEntry records per second from setLogRateLimit()
+extern uint32_t getLogRateLimitPerSecond();
+
+
+/// @return The burst from setLogRateLimit()
+extern uint32_t getLogRateLimitBurst();
+
+
+/// Decide whether a LogEntry from a `LOG_RATE_LIMIT` call site is queued
+///
+/// If there are repeats or drops to report, their LogEntry is queued first
+/// (with `severity` and `moduleId`).
+///
+/// @param site The call site
+/// @param severity The severity of the LogEntry
+/// @param moduleId The LogModuleId of the LogEntry
+/// @param hash logHashMessage() of the LogEntry
+/// @return `true` if the LogEntry should be queued
+extern bool logCallSiteAdmit( LogCallSite& site, LogSeverity severity, LogModuleId moduleId, uint64_t hash );
+
+
+/// Hash a message (64-bit FNV-1a) to spot repeats
+///
+/// @param fmt The format string (LogEntry records with different formats
+///            never match)
+/// @param message The formatted message or the packed arguments
+/// @param length The size of `message`
+/// @return The hash
+inline uint64_t logHashMessage( const char* fmt, const char* message, const size_t length ) {
+   constexpr uint64_t FNV_OFFSET_BASIS { 0xcbf29ce484222325 };
+   constexpr uint64_t FNV_PRIME { 0x100000001b3 };
+
+   uint64_t hash = FNV_OFFSET_BASIS ^ reinterpret_cast< uintptr_t >( fmt );  // NOLINT( cppcoreguidelines-pro-type-reinterpret-cast ): Only the address is hashed
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < length ; i++ ) {
+      hash = ( hash ^ static_cast< unsigned char >( message[ i ] ) ) * FNV_PRIME;  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): `i` < `length`
+   }
+   return hash;
+}
+
+} // namespace empire
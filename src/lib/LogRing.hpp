@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A fixed-size ring of LogEntry records
+///
+/// @file      LogRing.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>    // For array<>
+#include <bit>      // For has_single_bit()
+#include <cstddef>  // For size_t
+
+#ifdef __linux__
+   #include <sys/mman.h>  // For madvise()
+#endif
+
+#include "LogConfig.hpp"  // For LOG_ALIGNMENT LOG_HUGE_PAGE_BYTES
+#include "LogEntry.hpp"
+
+namespace empire {
+
+/// A ring of `Slots` LogEntry records of `SlotBytes` bytes each
+///
+/// empire::LogQueue and the per-thread rings are LogRing objects.  It's just
+/// storage:  The head and tail pointers are kept by the code that uses it.
+/// Index it with a head or tail pointer and it masks off the generation.
+///
+/// A LogRing of empire::LOG_HUGE_PAGE_BYTES or more is aligned to a huge
+/// page.  Call adviseHugePages() before it's used and the kernel backs it
+/// with transparent huge pages, so a big ring doesn't cost a TLB entry for
+/// every 4K.
+///
+/// It's zero-initialized and has no constructor, so a `static` LogRing is
+/// ready before any static initializer can log.
+///
+/// @tparam Slots The number of LogEntry records (a power of 2)
+/// @tparam SlotBytes The size of each LogEntry (a power of 2)
+template< size_t Slots, size_t SlotBytes = LOG_ALIGNMENT >
+class LogRing {
+   static_assert( std::has_single_bit( Slots ), "The number of LogRing slots must be a power of 2" );
+   static_assert( std::has_single_bit( SlotBytes ), "The size of a LogRing slot must be a power of 2" );
+   static_assert( SlotBytes >= 256, "A LogRing slot must be at least 256 bytes" );
+
+public:
+   /// The LogEntry in each slot
+   using Entry = BasicLogEntry< SlotBytes >;
+
+   static_assert( sizeof( Entry ) == SlotBytes, "A LogEntry must fill its slot" );
+
+   /// The number of LogEntry records
+   static constexpr size_t SIZE { Slots };
+
+   /// Mask the index of a slot from a head or tail pointer
+   static constexpr size_t INDEX_MASK { Slots - 1 };
+
+   /// The size of the ring in bytes
+   static constexpr size_t BYTES { Slots * SlotBytes };
+
+   /// `true` if the ring is big enough to use huge pages
+   static constexpr bool HUGE_PAGES { BYTES >= LOG_HUGE_PAGE_BYTES };
+
+   /// Get the LogEntry a head or tail pointer refers to
+   ///
+   /// @param index A head or tail pointer (it's masked)
+   /// @return The LogEntry
+   Entry& operator[]( const size_t index ) {
+      return m_entries[ index & INDEX_MASK ];  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): The index is masked
+   }
+
+   /// @copydoc operator[]()
+   const Entry& operator[]( const size_t index ) const {
+      return m_entries[ index & INDEX_MASK ];  // NOLINT( cppcoreguidelines-pro-bounds-constant-array-index ): The index is masked
+   }
+
+   /// @return The first LogEntry
+   Entry* data() { return m_entries.data(); }
+
+   /// @return The first LogEntry
+   [[nodiscard]] const Entry* data() const { return m_entries.data(); }
+
+   /// @return The start of the ring (to iterate over every slot)
+   auto begin() { return m_entries.begin(); }
+
+   /// @return The end of the ring
+   auto end() { return m_entries.end(); }
+
+   /// Ask the kernel to back the ring with transparent huge pages
+   ///
+   /// Call it before the ring is used (before its pages are touched).  It does
+   /// nothing if the ring is too small or the kernel says no.
+   void adviseHugePages() {
+      #ifdef __linux__
+         if constexpr( HUGE_PAGES ) {
+            madvise( m_entries.data(), BYTES, MADV_HUGEPAGE );  // NOLINT( cert-err33-c ): Small pages work too
+         }
+      #endif
+   }
+
+private:
+   /// The LogEntry records
+   alignas( HUGE_PAGES ? LOG_HUGE_PAGE_BYTES : SlotBytes ) std::array< Entry, Slots > m_entries;
+};
+
+} // namespace empire
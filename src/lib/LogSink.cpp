@@ -0,0 +1,18 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Abstract class for the destinations of a LogConsumer
+///
+/// @file      LogSink.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// Defined here so LogSink's vtable has a home
+LogSink::~LogSink() = default;
+
+} // namespace empire
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Abstract class for the destinations of a LogConsumer
+///
+/// @file      LogSink.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <span>  // For span<>
+
+#include "LogEntry.hpp"
+
+namespace empire {
+
+/// A destination for LogEntry records (the console, a file, memory, ...)
+///
+/// A LogConsumer drains empire::LogQueue and hands batches of ready LogEntry
+/// records to each of its LogSink objects.  A LogSink is only ever called from
+/// its LogConsumer's thread, so it does not need to be thread-safe unless it
+/// shares its results with other threads.
+///
+/// @pattern Chain of Responsibility:  Each LogSink gets a chance to process
+///          every batch.
+class LogSink {
+public:  // /////////////////// Constructors & Destructors /////////////////////
+   LogSink() = default;  ///< Default constructor
+
+   LogSink( const LogSink& ) = delete;             ///< Disable copy constructor
+   LogSink( LogSink&& ) = delete;                  ///< Disable move constructor
+   LogSink& operator=( const LogSink& ) = delete;  ///< Disable copy assignment
+   LogSink& operator=( LogSink&& ) = delete;       ///< Disable move assignment
+
+   /// Destructor for LogSink
+   virtual ~LogSink();
+
+public:  // ///////////////////////// Public Methods ///////////////////////////
+
+   /// Process a batch of LogEntry records
+   ///
+   /// The records are copies that belong to the LogConsumer, so producers can
+   /// reuse their slots in empire::LogQueue while the LogSink works.
+   ///
+   /// @param batch The LogEntry records, oldest first
+   virtual void write( std::span< const LogEntry > batch ) = 0;
+
+   /// Push anything the LogSink has buffered to its destination
+   virtual void flush() {}
+};
+
+} // namespace empire
@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that writes formatted log lines to the console
+///
+/// @file      LogSinkConsole.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>  // For array<>
+
+#include "LogSinkConsole.hpp"
+
+namespace empire {
+
+void LogSinkConsole::write( const std::span< const LogEntry > batch ) {
+   std::array< char, LOG_LINE_LENGTH > line {};
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const LogEntry& entry : batch ) {
+      const size_t length = formatLogEntry( entry, line.data(), line.size() );
+      m_stream.write( line.data(), static_cast< std::streamsize >( length ) );
+   }
+
+   /// The console is for people, so flush after every batch
+   m_stream.flush();
+}
+
+
+void LogSinkConsole::flush() {
+   m_stream.flush();
+}
+
+} // namespace empire
@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that writes formatted log lines to the console
+///
+/// @file      LogSinkConsole.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <iostream>  // For ostream cout
+
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// Write each LogEntry to an `ostream` (normally `cout`) as a line of text
+class LogSinkConsole final : public LogSink {
+public:
+   /// Make a LogSink for the console
+   ///
+   /// @param stream The stream to write to.  It must outlive this LogSink.
+   explicit LogSinkConsole( std::ostream& stream = std::cout ) : m_stream { stream } {}
+
+   void write( std::span< const LogEntry > batch ) override;
+   void flush() override;
+
+private:
+   std::ostream& m_stream;  ///< Where the log lines go  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): The stream is fixed for the life of the LogSink
+};
+
+} // namespace empire
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that appends formatted log lines to a file
+///
+/// @file      LogSinkFile.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>         // For array<>
+#include <cerrno>        // For errno
+#include <system_error>  // For system_error generic_category()
+
+#include "LogSinkFile.hpp"
+
+namespace empire {
+
+LogSinkFile::LogSinkFile( const std::filesystem::path& path ) {
+   m_file = std::fopen( path.c_str(), "a" );  // NOLINT( cppcoreguidelines-owning-memory ): The FILE is closed in the destructor
+   if( m_file == nullptr ) {
+      throw std::system_error( errno, std::generic_category(), "Unable to open log file [" + path.string() + "]" );
+   }
+}
+
+
+LogSinkFile::~LogSinkFile() {
+   std::fclose( m_file );  // NOLINT( cert-err33-c, cppcoreguidelines-owning-memory ): There's nothing we can do if fclose() fails
+}
+
+
+void LogSinkFile::write( const std::span< const LogEntry > batch ) {
+   std::array< char, LOG_LINE_LENGTH > line {};
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const LogEntry& entry : batch ) {
+      const size_t length = formatLogEntry( entry, line.data(), line.size() );
+      std::fwrite( line.data(), 1, length, m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+   }
+}
+
+
+void LogSinkFile::flush() {
+   std::fflush( m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+}
+
+} // namespace empire
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that appends formatted log lines to a file
+///
+/// @file      LogSinkFile.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdio>      // For FILE
+#include <filesystem>  // For path
+
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// Append each LogEntry to a file as a line of text
+///
+/// Lines are buffered by `stdio` and pushed to the file when the LogConsumer
+/// runs out of work, so a busy server does one `write()` per buffer, not one
+/// per line.
+class LogSinkFile final : public LogSink {
+public:
+   /// Open (or create) a log file for appending
+   ///
+   /// @param path The log file
+   /// @throws system_error if the file can't be opened
+   explicit LogSinkFile( const std::filesystem::path& path );
+
+   LogSinkFile( const LogSinkFile& ) = delete;             ///< Disable copy constructor
+   LogSinkFile( LogSinkFile&& ) = delete;                  ///< Disable move constructor
+   LogSinkFile& operator=( const LogSinkFile& ) = delete;  ///< Disable copy assignment
+   LogSinkFile& operator=( LogSinkFile&& ) = delete;       ///< Disable move assignment
+
+   /// Flush and close the log file
+   ~LogSinkFile() override;
+
+   void write( std::span< const LogEntry > batch ) override;
+   void flush() override;
+
+private:
+   std::FILE* m_file { nullptr };  ///< The open log file
+};
+
+} // namespace empire
@@ -0,0 +1,328 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that copies binary LogEntry records into a memory-mapped file
+///
+/// @file      LogSinkMapped.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>     // For all_of() sort() min()
+#include <atomic>        // For atomic_ref<> atomic_thread_fence()
+#include <cerrno>        // For errno
+#include <cstring>       // For memcpy() memcmp() strncmp() strncpy() strnlen()
+#include <fcntl.h>       // For open() posix_fallocate()
+#include <span>          // For span<>
+#include <sys/file.h>    // For flock()
+#include <sys/mman.h>    // For mmap() msync() munmap()
+#include <sys/stat.h>    // For fstat()
+#include <system_error>  // For system_error generic_category()
+#include <unistd.h>      // For close() ftruncate()
+
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+
+#include "LogKv.hpp"  // For expandLogKvEntry()
+#include "LogSinkMapped.hpp"
+
+using namespace std;
+
+namespace empire {
+
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast ): We lay out the header and the records in the mapping
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-type-vararg, hicpp-vararg ): `open()` is variadic
+
+namespace {
+
+/// Check that a mapping holds a LogSinkMapped file
+///
+/// @param header The start of the mapping
+/// @param fileSize The size of the file
+/// @return `true` if the header matches this build and the file's size
+bool isLogMappedFile( const LogMappedHeader& header, const size_t fileSize ) {
+   return memcmp( header.magic, LOG_MAPPED_MAGIC.data(), LOG_MAPPED_MAGIC.size() ) == 0
+       && header.version == LOG_MAPPED_VERSION
+       && header.recordSize == sizeof( LogEntry )
+       && header.capacity > 0
+       && header.capacity == ( fileSize - LOG_MAPPED_HEADER_SIZE ) / sizeof( LogEntry );
+}
+
+
+/// @param path The log file
+/// @return The `system_error` for a file that's not a LogSinkMapped file
+system_error notALogMappedFile( const filesystem::path& path ) {
+   return system_error( make_error_code( errc::invalid_argument ), "Not a LogSinkMapped file [" + path.string() + "]" );
+}
+
+} // namespace
+
+
+LogSinkMapped::LogSinkMapped( const filesystem::path& path, const size_t capacity ) {
+   BOOST_ASSERT_MSG( capacity > 0, "A LogSinkMapped file must hold at least 1 record" );
+
+   m_moduleIds.fill( LOG_MAPPED_UNKNOWN_MODULE );
+
+   /// Clean up what we've done so far and throw
+   auto fail = [ this ]( const system_error& error ) {
+      if( m_map != nullptr ) {
+         munmap( m_map, m_mapSize );
+      }
+      close( m_fd );
+      throw error;
+   };
+
+   m_fd = open( path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644 );  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): rw-r--r--
+   if( m_fd < 0 ) {
+      throw system_error( errno, generic_category(), "Unable to open log file [" + path.string() + "]" );
+   }
+
+   if( flock( m_fd, LOCK_EX | LOCK_NB ) != 0 ) {
+      fail( system_error( errno, generic_category(), "Log file is already open [" + path.string() + "]" ) );
+   }
+
+   struct stat status {};
+   if( fstat( m_fd, &status ) != 0 ) {
+      fail( system_error( errno, generic_category(), "Unable to stat log file [" + path.string() + "]" ) );
+   }
+
+   /// Only a new (empty) file is sized and given a header.  Any other file
+   /// must already be a LogSinkMapped file, and it's checked before we
+   /// write anything to it, so the wrong path can't clobber someone's file.
+   m_mapSize = static_cast< size_t >( status.st_size );
+   bool isNew = ( m_mapSize == 0 );
+   if( isNew ) {
+      m_mapSize = LOG_MAPPED_HEADER_SIZE + capacity * sizeof( LogEntry );
+
+      int result = posix_fallocate( m_fd, 0, static_cast< off_t >( m_mapSize ) );
+      if( result == EOPNOTSUPP || result == EINVAL ) {  // The filesystem can't allocate blocks ahead of time
+         result = ( ftruncate( m_fd, static_cast< off_t >( m_mapSize ) ) == 0 ) ? 0 : errno;
+      }
+      if( result != 0 ) {
+         fail( system_error( result, generic_category(), "Unable to size log file [" + path.string() + "]" ) );
+      }
+   } else if( m_mapSize < LOG_MAPPED_HEADER_SIZE + sizeof( LogEntry ) ) {
+      fail( notALogMappedFile( path ) );
+   }
+
+   m_map = mmap( nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+   if( m_map == MAP_FAILED ) {
+      m_map = nullptr;
+      fail( system_error( errno, generic_category(), "Unable to map log file [" + path.string() + "]" ) );
+   }
+
+   m_header = static_cast< LogMappedHeader* >( m_map );
+   m_records = reinterpret_cast< LogEntry* >( static_cast< char* >( m_map ) + LOG_MAPPED_HEADER_SIZE );
+
+   /// A crash after the file was sized, but before its header was written,
+   /// leaves a file of the right size with a header that's all zeros.  That's
+   /// a new file too.
+   if( !isNew && m_mapSize == LOG_MAPPED_HEADER_SIZE + capacity * sizeof( LogEntry ) ) {
+      const span< const char > header { static_cast< const char* >( m_map ), LOG_MAPPED_HEADER_SIZE };
+      isNew = all_of( header.begin(), header.end(), []( const char c ) { return c == '\0'; } );
+   }
+
+   /// The magic number is written last, so a reader never sees half a header
+   if( isNew ) {
+      m_header->version = LOG_MAPPED_VERSION;
+      m_header->recordSize = sizeof( LogEntry );
+      m_header->capacity = capacity;
+      atomic_ref< uint32_t >( m_header->moduleCount ).store( 0 );
+      atomic_thread_fence( memory_order_release );
+      memcpy( m_header->magic, LOG_MAPPED_MAGIC.data(), LOG_MAPPED_MAGIC.size() );
+   }
+
+   if( !isLogMappedFile( *m_header, m_mapSize ) ) {
+      fail( notALogMappedFile( path ) );
+   }
+   m_capacity = m_header->capacity;
+
+   /// Carry on after the newest good record
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t slot = 0 ; slot < m_capacity ; slot++ ) {
+      const LogEntry& record = m_records[ slot ];
+      if( record.ready && record.sequence % m_capacity == slot && record.sequence >= m_next ) {
+         m_next = record.sequence + 1;
+      }
+   }
+}
+
+
+LogSinkMapped::~LogSinkMapped() {
+   msync( m_map, m_mapSize, MS_SYNC );
+   munmap( m_map, m_mapSize );
+   close( m_fd );  // Also releases the flock()
+}
+
+
+void LogSinkMapped::write( const span< const LogEntry > batch ) {
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const LogEntry& entry : batch ) {
+      LogEntry& record = m_records[ m_next % m_capacity ];
+
+      /// Clear the old record before we write over it
+      atomic_ref< bool >( record.ready ).store( false, memory_order_relaxed );
+      atomic_thread_fence( memory_order_release );
+
+      LogEntry copy = entry;
+      copy.moduleId = fileModuleId( entry.moduleId );
+      copy.ready = false;
+      copy.writing = false;
+      copy.sequence = m_next;
+      copy.fmt = nullptr;
+      expandLogKvEntry( copy );  // LogEntry::schema means nothing to a reader
+      memcpy( &record, &copy, sizeof( LogEntry ) );
+
+      atomic_ref< bool >( record.ready ).store( true, memory_order_release );
+      m_next += 1;
+   }
+}
+
+
+void LogSinkMapped::flush() {
+   msync( m_map, m_mapSize, MS_ASYNC );
+}
+
+
+size_t LogSinkMapped::getCapacity() const {
+   return m_capacity;
+}
+
+
+uint64_t LogSinkMapped::getNextSequence() const {
+   return m_next;
+}
+
+
+LogModuleId LogSinkMapped::fileModuleId( const LogModuleId moduleId ) {
+   if( moduleId >= MAX_LOG_MODULES ) {
+      return LOG_MAPPED_UNKNOWN_MODULE;
+   }
+
+   /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `moduleId` is < MAX_LOG_MODULES
+   LogModuleId& cached = m_moduleIds[ moduleId ];
+   if( cached != LOG_MAPPED_UNKNOWN_MODULE ) {
+      return cached;
+   }
+
+   /// Look for the name in the file (it may have been written by an earlier run)
+   const char* const name = logModuleName( moduleId );
+   const uint32_t count = atomic_ref< uint32_t >( m_header->moduleCount ).load( memory_order_relaxed );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( uint32_t i = 0 ; i < count && i < MAX_LOG_MODULES ; i++ ) {
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `i` is < MAX_LOG_MODULES
+      if( strncmp( m_header->moduleNames[ i ], name, MODULE_NAME_LENGTH ) == 0 ) {
+         cached = static_cast< LogModuleId >( i );
+         return cached;
+      }
+   }
+
+   if( count >= MAX_LOG_MODULES ) {
+      return LOG_MAPPED_UNKNOWN_MODULE;
+   }
+
+   /// Write the name before the count that covers it
+   /// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-constant-array-index ): `count` is < MAX_LOG_MODULES
+   strncpy( m_header->moduleNames[ count ], name, MODULE_NAME_LENGTH - 1 );  // NOLINT( cert-err33-c ): No need to check the return value
+   m_header->moduleNames[ count ][ MODULE_NAME_LENGTH - 1 ] = '\0';
+   // @NOLINTEND( cppcoreguidelines-pro-bounds-constant-array-index )
+   atomic_ref< uint32_t >( m_header->moduleCount ).store( count + 1, memory_order_release );
+
+   cached = static_cast< LogModuleId >( count );
+   return cached;
+}
+
+
+const char* LogMappedFile::moduleName( const LogModuleId moduleId ) const {
+   if( moduleId >= moduleNames.size() ) {
+      return "unknown";
+   }
+   return moduleNames[ moduleId ].c_str();
+}
+
+
+LogMappedFile readLogMappedFile( const filesystem::path& path ) {
+   const int fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+   if( fd < 0 ) {
+      throw system_error( errno, generic_category(), "Unable to open log file [" + path.string() + "]" );
+   }
+
+   struct stat status {};
+   if( fstat( fd, &status ) != 0 ) {
+      const int error = errno;
+      close( fd );
+      throw system_error( error, generic_category(), "Unable to stat log file [" + path.string() + "]" );
+   }
+
+   const auto fileSize = static_cast< size_t >( status.st_size );
+   if( fileSize < LOG_MAPPED_HEADER_SIZE + sizeof( LogEntry ) ) {
+      close( fd );
+      throw notALogMappedFile( path );
+   }
+
+   void* const map = mmap( nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+   close( fd );  // The mapping keeps the file open
+   if( map == MAP_FAILED ) {
+      throw system_error( errno, generic_category(), "Unable to map log file [" + path.string() + "]" );
+   }
+
+   const auto* const header = static_cast< const LogMappedHeader* >( map );
+   if( !isLogMappedFile( *header, fileSize ) ) {
+      munmap( map, fileSize );
+      throw notALogMappedFile( path );
+   }
+
+   LogMappedFile file;
+
+   /// The count is read (with `acquire`) before the names it covers
+   uint32_t moduleCount = 0;
+   memcpy( &moduleCount, &header->moduleCount, sizeof( moduleCount ) );
+   atomic_thread_fence( memory_order_acquire );
+   moduleCount = min( moduleCount, static_cast< uint32_t >( MAX_LOG_MODULES ) );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( uint32_t i = 0 ; i < moduleCount ; i++ ) {
+      /// @NOLINTNEXTLINE( cppcoreguidelines-pro-bounds-constant-array-index ): `i` is < MAX_LOG_MODULES
+      file.moduleNames.emplace_back( header->moduleNames[ i ], strnlen( header->moduleNames[ i ], MODULE_NAME_LENGTH ) );
+   }
+
+   const size_t capacity = header->capacity;
+   const auto* const records = reinterpret_cast< const LogEntry* >( static_cast< const char* >( map ) + LOG_MAPPED_HEADER_SIZE );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t slot = 0 ; slot < capacity ; slot++ ) {
+      LogEntry copy {};
+      memcpy( &copy, &records[ slot ], sizeof( LogEntry ) );
+
+      /// If a live writer started to replace it while we copied, it cleared
+      /// LogEntry::ready first
+      atomic_thread_fence( memory_order_acquire );
+      bool stillReady = false;
+      memcpy( &stillReady, &records[ slot ].ready, sizeof( stillReady ) );
+
+      if( !copy.ready || !stillReady || copy.sequence % capacity != slot ) {
+         continue;
+      }
+
+      copy.msg[ LOG_MSG_LENGTH - 1 ] = '\0';  // Don't trust the file
+      copy.msg_end = 0;
+      copy.fmt = nullptr;
+      copy.schema = nullptr;
+      file.entries.push_back( copy );
+   }
+
+   munmap( map, fileSize );
+
+   sort( file.entries.begin(), file.entries.end(), []( const LogEntry& a, const LogEntry& b ) {
+      return a.sequence < b.sequence;
+   } );
+
+   return file;
+}
+
+// NOLINTEND( cppcoreguidelines-pro-type-vararg, hicpp-vararg )
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast )
+
+} // namespace empire
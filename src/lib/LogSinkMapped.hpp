@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that copies binary LogEntry records into a memory-mapped file
+///
+/// @file      LogSinkMapped.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <array>       // For array<>
+#include <cstdint>     // For uint16_t uint32_t uint64_t
+#include <filesystem>  // For path
+#include <string>      // For string
+#include <vector>      // For vector<>
+
+#include "LogConfig.hpp"  // For MAX_LOG_MODULES MODULE_NAME_LENGTH LOG_MAPPED_CAPACITY
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// The header at the start of a file written by LogSinkMapped
+///
+/// LogEntry::moduleId is only good for the process that registered the
+/// module, so the file keeps its own table of module names and each record's
+/// LogEntry::moduleId is an index into it.
+///
+/// The file is in the writer's byte order.
+///
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): `char[]` arrays are used in the Log module
+struct LogMappedHeader {
+   char     magic[ 8 ];    ///< LOG_MAPPED_MAGIC
+   uint32_t version;       ///< LOG_MAPPED_VERSION
+   uint32_t recordSize;    ///< `sizeof( LogEntry )`
+   uint64_t capacity;      ///< The number of records the file holds
+
+   /// The number of names in LogMappedHeader::moduleNames.  A name is written
+   /// before the count that covers it.  Always access it with `std::atomic_ref`.
+   alignas( uint64_t ) uint32_t moduleCount;
+
+   /// The module names, indexed by the LogEntry::moduleId in each record
+   char moduleNames[ MAX_LOG_MODULES ][ MODULE_NAME_LENGTH ];
+};
+// NOLINTEND( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays )
+
+/// The first 8 bytes of a file written by LogSinkMapped
+constinit const std::array< char, 8 > LOG_MAPPED_MAGIC { 'E', 'M', 'P', 'I', 'R', 'E', 'L', 'G' };
+
+/// The version of the LogSinkMapped file format
+constinit const uint32_t LOG_MAPPED_VERSION { 1 };
+
+/// The records start on the first 4K boundary after the LogMappedHeader
+constinit const size_t LOG_MAPPED_HEADER_SIZE { ( sizeof( LogMappedHeader ) + 4095 ) & ~size_t { 4095 } };
+
+/// The LogEntry::moduleId of a record whose module didn't fit in
+/// LogMappedHeader::moduleNames
+constinit const LogModuleId LOG_MAPPED_UNKNOWN_MODULE { 0xFFFF };
+
+
+/// Copy each LogEntry into a pre-sized, memory-mapped file
+///
+/// There's no formatting and no `write()` call per record:  A record is a
+/// `memcpy()` of the LogEntry into the mapping and the kernel writes the dirty
+/// pages back on its own schedule.  Use `empire_logdump` to read the file.
+///
+/// The file is a ring of LogMappedHeader::capacity records.  When it's full,
+/// the oldest records are overwritten.  LogEntry::sequence holds each
+/// record's position in the file (counting every record ever written), so the
+/// records can be put back in order.
+///
+/// Crash-safety:  The mapping is shared, so every record we've copied is in
+/// the kernel's page cache and survives a crash of this process.  Each record
+/// is cleared (LogEntry::ready is `false`) before it's overwritten and
+/// LogEntry::ready is set after the rest of it is written, so a record that
+/// was half written when we crashed is skipped.  A record never straddles a
+/// page, so it also can't be torn by the page writeback.  flush() asks the
+/// kernel to start writing the dirty pages back (it doesn't wait) and the
+/// destructor waits for them.  When the file is reopened, we carry on after
+/// the newest good record.
+///
+/// The file's blocks are allocated up front, so a full disk is reported when
+/// the file is opened, not with a `SIGBUS` while we're logging.  Only one
+/// LogSinkMapped can have a file open at a time (it's locked with `flock()`).
+class LogSinkMapped final : public LogSink {
+public:
+   /// Open (or create) a log file and map it
+   ///
+   /// A missing or empty file is set up as a new log file, and so is a file
+   /// of the size `capacity` gives whose header is all zeros (we crashed
+   /// while setting it up).  Any other file is left alone unless its header
+   /// says it's a LogSinkMapped file.
+   ///
+   /// @param path The log file
+   /// @param capacity The number of records in a new file.  An existing file
+   ///                 keeps its capacity.
+   /// @throws system_error if the file can't be opened, locked, sized or
+   ///                      mapped, or if it's not a LogSinkMapped file
+   explicit LogSinkMapped( const std::filesystem::path& path, size_t capacity = LOG_MAPPED_CAPACITY );
+
+   LogSinkMapped( const LogSinkMapped& ) = delete;             ///< Disable copy constructor
+   LogSinkMapped( LogSinkMapped&& ) = delete;                  ///< Disable move constructor
+   LogSinkMapped& operator=( const LogSinkMapped& ) = delete;  ///< Disable copy assignment
+   LogSinkMapped& operator=( LogSinkMapped&& ) = delete;       ///< Disable move assignment
+
+   /// Flush, unmap and close the log file
+   ~LogSinkMapped() override;
+
+   void write( std::span< const LogEntry > batch ) override;
+   void flush() override;
+
+   /// Get the number of records the file holds
+   ///
+   /// @return LogMappedHeader::capacity
+   [[nodiscard]] size_t getCapacity() const;
+
+   /// Get the position of the next record
+   ///
+   /// @return The LogEntry::sequence the next record will get
+   [[nodiscard]] uint64_t getNextSequence() const;
+
+private:
+   /// Get (or add) the file's LogEntry::moduleId for a module
+   ///
+   /// @param moduleId The module's LogModuleId in this process
+   /// @return Its index in LogMappedHeader::moduleNames
+   LogModuleId fileModuleId( LogModuleId moduleId );
+
+   int              m_fd { -1 };             ///< The open log file
+   void*            m_map { nullptr };       ///< The mapping of the whole file
+   size_t           m_mapSize { 0 };         ///< The size of #m_map
+   LogMappedHeader* m_header { nullptr };    ///< The start of #m_map
+   LogEntry*        m_records { nullptr };   ///< The records in #m_map
+   size_t           m_capacity { 0 };        ///< The number of records in #m_records
+   uint64_t         m_next { 0 };            ///< The LogEntry::sequence of the next record
+
+   /// The file's LogEntry::moduleId for each LogModuleId in this process
+   /// (LOG_MAPPED_UNKNOWN_MODULE if we haven't looked it up yet)
+   std::array< LogModuleId, MAX_LOG_MODULES > m_moduleIds {};
+};
+
+
+/// The records in a file written by LogSinkMapped
+struct LogMappedFile {
+   /// The good records, oldest first.  LogEntry::moduleId is an index into
+   /// #moduleNames (or LOG_MAPPED_UNKNOWN_MODULE).
+   std::vector< LogEntry > entries;
+
+   /// The module names from the file's LogMappedHeader
+   std::vector< std::string > moduleNames;
+
+   /// Get the name of a record's module
+   ///
+   /// @param moduleId A LogEntry::moduleId from #entries
+   /// @return The module's name or `unknown`
+   [[nodiscard]] const char* moduleName( LogModuleId moduleId ) const;
+};
+
+
+/// Read the records in a file written by LogSinkMapped
+///
+/// Records that were half written (when the writer crashed, or that the
+/// writer is writing while we read) are skipped.
+///
+/// @param path The log file
+/// @return The module names and the good records, oldest first
+/// @throws system_error if the file can't be read or is not a LogSinkMapped
+///                      file
+extern LogMappedFile readLogMappedFile( const std::filesystem::path& path );
+
+} // namespace empire
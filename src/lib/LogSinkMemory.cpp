@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that keeps the most recent LogEntry records in memory
+///
+/// @file      LogSinkMemory.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LogSinkMemory.hpp"
+
+namespace empire {
+
+void LogSinkMemory::write( const std::span< const LogEntry > batch ) {
+   const std::lock_guard< std::mutex > lock( m_mutex );
+
+   m_entries.insert( m_entries.end(), batch.begin(), batch.end() );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( m_entries.size() > m_capacity ) {
+      m_entries.pop_front();
+   }
+}
+
+
+std::vector< LogEntry > LogSinkMemory::getEntries() const {
+   const std::lock_guard< std::mutex > lock( m_mutex );
+
+   return { m_entries.begin(), m_entries.end() };
+}
+
+
+size_t LogSinkMemory::size() const {
+   const std::lock_guard< std::mutex > lock( m_mutex );
+
+   return m_entries.size();
+}
+
+
+void LogSinkMemory::clear() {
+   const std::lock_guard< std::mutex > lock( m_mutex );
+
+   m_entries.clear();
+}
+
+} // namespace empire
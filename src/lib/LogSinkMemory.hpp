@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that keeps the most recent LogEntry records in memory
+///
+/// @file      LogSinkMemory.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <deque>   // For deque<>
+#include <mutex>   // For mutex lock_guard<>
+#include <vector>  // For vector<>
+
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// Keep copies of the most recent LogEntry records in memory
+///
+/// Other threads can look at the records while the LogConsumer adds to them,
+/// so the records are guarded by a mutex.  The LogConsumer only takes the
+/// mutex once per batch.
+class LogSinkMemory final : public LogSink {
+public:
+   /// Make a LogSink that holds up to `capacity` records
+   ///
+   /// @param capacity The oldest records are discarded after this
+   explicit LogSinkMemory( const size_t capacity = SIZE_OF_QUEUE ) : m_capacity { capacity } {}
+
+   void write( std::span< const LogEntry > batch ) override;
+
+   /// Get a copy of the records, oldest first
+   ///
+   /// @return The records currently held by this LogSink
+   [[nodiscard]] std::vector< LogEntry > getEntries() const;
+
+   /// Get the number of records currently held by this LogSink
+   ///
+   /// @return The number of records
+   [[nodiscard]] size_t size() const;
+
+   /// Discard all of the records
+   void clear();
+
+private:
+   const size_t m_capacity;          ///< The maximum number of records to keep  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): The capacity is fixed
+   mutable std::mutex m_mutex;       ///< Guards m_entries
+   std::deque< LogEntry > m_entries; ///< The records, oldest first
+};
+
+} // namespace empire
@@ -0,0 +1,349 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that writes log lines to a file, rolls it over and compresses
+/// the old ones
+///
+/// @file      LogSinkRotatingFile.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>     // For sort()
+#include <array>         // For array<>
+#include <cerrno>        // For errno
+#include <charconv>      // For from_chars()
+#include <cstdio>        // For fopen() fwrite() fflush() fclose() FILE
+#include <optional>      // For optional<>
+#include <string>        // For string
+#include <string_view>   // For string_view
+#include <system_error>  // For system_error generic_category()
+#include <utility>       // For pair<>
+#include <vector>        // For vector<>
+
+#ifdef __linux__
+   #include <sys/resource.h>  // For setpriority()
+#endif
+
+#include <zlib.h>  // For gzopen() gzwrite() gzclose()
+
+#include "LogClock.hpp"  // For NS_PER_SECOND
+#include "LogSinkRotatingFile.hpp"
+
+using namespace std;
+
+namespace empire {
+
+namespace {
+
+/// Read and compress closed files in chunks this big (and check for a stop
+/// between them)
+constinit const size_t COMPRESS_CHUNK { 64 * 1024 };
+
+/// Compressed files end with this
+constinit const string_view COMPRESSED_SUFFIX { ".gz" };
+
+/// Compressed files are written to `path.N.gz.tmp` and then renamed
+constinit const string_view TEMPORARY_SUFFIX { ".gz.tmp" };
+
+
+/// Parse the `N` out of `base.N` or `base.N.gz`
+///
+/// @param name The name of a file in the log file's directory
+/// @param base The name of the log file
+/// @return `N` and whether the file is compressed (or nothing if `name` isn't
+///         a closed log file)
+optional< pair< uint64_t, bool > > segmentNumber( const string_view name, const string_view base ) {
+   if( name.size() <= base.size() + 1 || !name.starts_with( base ) || name[ base.size() ] != '.' ) {
+      return nullopt;
+   }
+
+   string_view rest = name.substr( base.size() + 1 );
+   const bool compressed = rest.ends_with( COMPRESSED_SUFFIX );
+   if( compressed ) {
+      rest.remove_suffix( COMPRESSED_SUFFIX.size() );
+   }
+
+   uint64_t number = 0;
+   const auto [ end, error ] = from_chars( rest.data(), rest.data() + rest.size(), number );  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): Parsing a string_view
+   if( error != errc {} || end != rest.data() + rest.size() || rest.empty() ) {  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): Parsing a string_view
+      return nullopt;
+   }
+   return pair { number, compressed };
+}
+
+
+/// The closed log files next to a log file
+struct Segment {
+   uint64_t number;           ///< The `N` in `path.N`
+   bool compressed;           ///< It's `path.N.gz`
+   filesystem::path path;     ///< The file
+};
+
+
+/// Find the closed log files next to a log file
+///
+/// @param path The log file
+/// @return The closed log files, oldest first
+vector< Segment > findSegments( const filesystem::path& path ) {
+   vector< Segment > segments;
+   const string base = path.filename().string();
+   error_code error;
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const auto& file : filesystem::directory_iterator( path.parent_path().empty() ? "." : path.parent_path(), error ) ) {
+      const optional< pair< uint64_t, bool > > number = segmentNumber( file.path().filename().string(), base );
+      if( number ) {
+         segments.push_back( { number->first, number->second, file.path() } );
+      }
+   }
+
+   sort( segments.begin(), segments.end(), []( const Segment& a, const Segment& b ) {
+      return a.number < b.number || ( a.number == b.number && a.compressed < b.compressed );
+   } );
+   return segments;
+}
+
+} // namespace
+
+
+LogSinkRotatingFile::LogSinkRotatingFile( const filesystem::path& path
+                                         ,const size_t maxBytes
+                                         ,const uint64_t maxSeconds
+                                         ,const size_t keep )
+      : m_path { path }
+       ,m_maxBytes { maxBytes }
+       ,m_maxNs { maxSeconds * NS_PER_SECOND }
+       ,m_keep { keep } {
+   if( !open() ) {
+      throw system_error( errno, generic_category(), "Unable to open log file [" + path.string() + "]" );
+   }
+
+   error_code error;
+   m_bytes = static_cast< size_t >( filesystem::file_size( m_path, error ) );
+   if( error ) {
+      m_bytes = 0;
+   }
+
+   // Throw away half-written compressed files and finish compressing the
+   // closed files from last time
+   const string temporary = m_path.filename().string() + ".";
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const auto& file : filesystem::directory_iterator( m_path.parent_path().empty() ? "." : m_path.parent_path(), error ) ) {
+      const string name = file.path().filename().string();
+      if( name.starts_with( temporary ) && name.ends_with( TEMPORARY_SUFFIX ) ) {
+         filesystem::remove( file.path(), error );
+      }
+   }
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const Segment& segment : findSegments( m_path ) ) {
+      if( !segment.compressed ) {
+         m_pending.push_back( segment.path );
+      }
+      m_nextSegment = segment.number + 1;
+   }
+
+   m_compressor = thread( &LogSinkRotatingFile::compressLoop, this );
+}
+
+
+LogSinkRotatingFile::~LogSinkRotatingFile() {
+   {
+      const lock_guard lock( m_mutex );
+      m_stop.store( true );
+   }
+   m_wake.notify_all();
+   m_compressor.join();
+
+   if( m_file != nullptr ) {
+      fclose( m_file );  // NOLINT( cert-err33-c, cppcoreguidelines-owning-memory ): There's nothing we can do if fclose() fails
+   }
+}
+
+
+bool LogSinkRotatingFile::open() {
+   m_file = fopen( m_path.c_str(), "a" );  // NOLINT( cppcoreguidelines-owning-memory ): The FILE is closed in the destructor
+   m_bytes = 0;
+   m_firstNs = 0;
+   return m_file != nullptr;
+}
+
+
+void LogSinkRotatingFile::write( const span< const LogEntry > batch ) {
+   array< char, LOG_LINE_LENGTH > line {};
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const LogEntry& entry : batch ) {
+      const size_t length = formatLogEntry( entry, line.data(), line.size() );
+
+      if( m_bytes > 0 ) {
+         const bool tooBig = m_maxBytes != 0 && m_bytes + length > m_maxBytes;
+         const bool tooOld = m_maxNs != 0 && m_firstNs != 0 && entry.logTimestamp >= m_firstNs + m_maxNs;
+         if( tooBig || tooOld ) {
+            rotate();
+         }
+      }
+
+      if( m_file == nullptr && !open() ) {
+         continue;  // A logger has nowhere to report its own errors
+      }
+
+      if( m_firstNs == 0 ) {
+         m_firstNs = entry.logTimestamp;
+      }
+
+      m_bytes += fwrite( line.data(), 1, length, m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+   }
+}
+
+
+void LogSinkRotatingFile::flush() {
+   if( m_file != nullptr ) {
+      fflush( m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+   }
+}
+
+
+void LogSinkRotatingFile::rotate() {
+   if( m_file != nullptr ) {
+      fclose( m_file );  // NOLINT( cert-err33-c, cppcoreguidelines-owning-memory ): There's nothing we can do if fclose() fails
+      m_file = nullptr;
+   }
+
+   filesystem::path segment = m_path;
+   segment += '.';
+   segment += to_string( m_nextSegment );
+
+   error_code error;
+   filesystem::rename( m_path, segment, error );
+   if( !error ) {
+      m_nextSegment++;
+      {
+         const lock_guard lock( m_mutex );
+         m_pending.push_back( std::move( segment ) );
+      }
+      m_wake.notify_all();
+   }
+
+   open();  // If this fails, write() tries again
+}
+
+
+void LogSinkRotatingFile::waitForCompression() {
+   unique_lock lock( m_mutex );
+   m_wake.wait( lock, [ this ]() { return ( m_pending.empty() && !m_busy ) || m_stop.load(); } );
+}
+
+
+void LogSinkRotatingFile::compressLoop() {
+   #ifdef __linux__
+      // On Linux, the nice value belongs to the thread, so this only affects
+      // the compression thread
+      setpriority( PRIO_PROCESS, 0, 19 );  // NOLINT( cert-err33-c, cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): The lowest priority.  It's OK if we can't lower it.
+   #endif
+
+   unique_lock lock( m_mutex );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( !m_stop.load() ) {
+      if( m_pending.empty() ) {
+         m_busy = true;
+         lock.unlock();
+         prune();
+         lock.lock();
+         m_busy = false;
+         m_wake.notify_all();
+
+         m_wake.wait( lock, [ this ]() { return !m_pending.empty() || m_stop.load(); } );
+         continue;
+      }
+
+      const filesystem::path segment = m_pending.front();
+      m_busy = true;
+      lock.unlock();
+
+      const bool compressed = compress( segment );
+
+      lock.lock();
+      if( compressed || m_stop.load() ) {
+         m_pending.pop_front();
+      } else {
+         m_pending.clear();  // Something is wrong with the disk.  Leave the rest for next time.
+      }
+   }
+
+   m_busy = false;
+   m_wake.notify_all();
+}
+
+
+bool LogSinkRotatingFile::compress( const filesystem::path& segment ) {
+   FILE* const in = fopen( segment.c_str(), "rb" );  // NOLINT( cppcoreguidelines-owning-memory ): The FILE is closed below
+   if( in == nullptr ) {
+      return errno == ENOENT;  // It's already been pruned
+   }
+
+   filesystem::path temporary = segment;
+   temporary += TEMPORARY_SUFFIX;
+   filesystem::path target = segment;
+   target += COMPRESSED_SUFFIX;
+
+   gzFile out = gzopen( temporary.c_str(), "wb" );
+   bool good = out != nullptr;
+
+   vector< char > buffer( COMPRESS_CHUNK );
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( good && !m_stop.load() ) {
+      const size_t length = fread( buffer.data(), 1, buffer.size(), in );
+      if( length == 0 ) {
+         good = ferror( in ) == 0;
+         break;
+      }
+      good = gzwrite( out, buffer.data(), static_cast< unsigned >( length ) ) == static_cast< int >( length );
+   }
+
+   fclose( in );  // NOLINT( cert-err33-c, cppcoreguidelines-owning-memory ): It was only read
+   if( out != nullptr ) {
+      good = gzclose( out ) == Z_OK && good;
+   }
+
+   error_code error;
+   if( !good || m_stop.load() ) {
+      filesystem::remove( temporary, error );
+      return false;
+   }
+
+   filesystem::rename( temporary, target, error );
+   if( error ) {
+      filesystem::remove( temporary, error );
+      return false;
+   }
+   filesystem::remove( segment, error );
+   return true;
+}
+
+
+void LogSinkRotatingFile::prune() {
+   vector< Segment > segments = findSegments( m_path );
+
+   // A `path.N` and its `path.N.gz` are the same closed file
+   size_t count = 0;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < segments.size() ; i++ ) {
+      if( i == 0 || segments[ i ].number != segments[ i - 1 ].number ) {
+         count++;
+      }
+   }
+
+   error_code error;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < segments.size() && count > m_keep ; i++ ) {
+      filesystem::remove( segments[ i ].path, error );
+      if( i + 1 == segments.size() || segments[ i + 1 ].number != segments[ i ].number ) {
+         count--;
+      }
+   }
+}
+
+} // namespace empire
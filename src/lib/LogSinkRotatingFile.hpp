@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that writes log lines to a file, rolls it over and compresses
+/// the old ones
+///
+/// @file      LogSinkRotatingFile.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>              // For atomic<>
+#include <condition_variable>  // For condition_variable
+#include <cstdint>             // For uint64_t
+#include <cstdio>              // For FILE
+#include <deque>               // For deque<>
+#include <filesystem>          // For path
+#include <mutex>               // For mutex
+#include <thread>              // For thread
+
+#include "LogConfig.hpp"  // For LOG_ROTATE_BYTES LOG_ROTATE_SECONDS LOG_ROTATE_KEEP
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// Append each LogEntry to a file as a line of text (like LogSinkFile) and
+/// roll the file over when it gets too big or too old
+///
+/// The file being written is always `path`.  When it rolls over, it's renamed
+/// to `path.N` (`N` counts up, so the highest is the newest) and a new `path`
+/// is started.  That's a `rename()` and an `fopen()` on the LogConsumer's
+/// thread.  Everything slow happens on a background thread that runs at the
+/// lowest CPU priority:  It gzips `path.N` into `path.N.gz` and deletes the
+/// oldest closed files so there are never more than `keep` of them.
+///
+/// Closed files that weren't compressed when the LogSinkRotatingFile was
+/// destroyed are compressed the next time one is made for the same `path`.
+class LogSinkRotatingFile final : public LogSink {
+public:
+   /// Open (or create) a log file for appending and start the compression
+   /// thread
+   ///
+   /// @param path The log file
+   /// @param maxBytes Roll over when the file reaches this many bytes (0 to
+   ///                 never roll over by size)
+   /// @param maxSeconds Roll over when the first LogEntry in the file is this
+   ///                   old (0 to never roll over by time)
+   /// @param keep The number of closed files to keep
+   /// @throws system_error if the file can't be opened
+   explicit LogSinkRotatingFile( const std::filesystem::path& path
+                                ,size_t maxBytes = LOG_ROTATE_BYTES
+                                ,uint64_t maxSeconds = LOG_ROTATE_SECONDS
+                                ,size_t keep = LOG_ROTATE_KEEP );
+
+   LogSinkRotatingFile( const LogSinkRotatingFile& ) = delete;             ///< Disable copy constructor
+   LogSinkRotatingFile( LogSinkRotatingFile&& ) = delete;                  ///< Disable move constructor
+   LogSinkRotatingFile& operator=( const LogSinkRotatingFile& ) = delete;  ///< Disable copy assignment
+   LogSinkRotatingFile& operator=( LogSinkRotatingFile&& ) = delete;       ///< Disable move assignment
+
+   /// Close the log file and stop the compression thread (without waiting
+   /// for the closed files it hasn't compressed yet)
+   ~LogSinkRotatingFile() override;
+
+   void write( std::span< const LogEntry > batch ) override;
+   void flush() override;
+
+   /// Roll the log file over now
+   ///
+   /// Only call it from the LogConsumer's thread (or when the LogConsumer is
+   /// stopped).
+   void rotate();
+
+   /// Wait until the compression thread has nothing left to do
+   void waitForCompression();
+
+private:
+   /// Open #m_path for appending
+   ///
+   /// @return `false` if it can't be opened (and `errno` says why)
+   bool open();
+
+   /// The body of the compression thread
+   void compressLoop();
+
+   /// Gzip a closed file and delete it
+   ///
+   /// @param segment The closed file
+   /// @return `false` if it was left uncompressed
+   bool compress( const std::filesystem::path& segment );
+
+   /// Delete the oldest closed files until there are #m_keep of them
+   void prune();
+
+   const std::filesystem::path m_path;  ///< The log file  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): It's fixed
+   const size_t   m_maxBytes;           ///< Roll over at this size  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): It's fixed
+   const uint64_t m_maxNs;              ///< Roll over at this age  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): It's fixed
+   const size_t   m_keep;               ///< The number of closed files to keep  @NOLINT( cppcoreguidelines-avoid-const-or-ref-data-members ): It's fixed
+
+   std::FILE* m_file { nullptr };  ///< The open log file
+   size_t     m_bytes { 0 };       ///< The size of #m_file
+   uint64_t   m_firstNs { 0 };     ///< The LogEntry::logTimestamp of the first LogEntry in #m_file (0 if there isn't one)
+   uint64_t   m_nextSegment { 1 }; ///< The `N` for the next closed file
+
+   std::mutex m_mutex;                             ///< Guards #m_pending and #m_busy
+   std::condition_variable m_wake;                 ///< Signals a change to #m_pending, #m_busy or #m_stop
+   std::deque< std::filesystem::path > m_pending;  ///< The closed files waiting to be compressed
+   bool m_busy { false };                          ///< The compression thread is working
+   std::atomic< bool > m_stop { false };           ///< Tells the compression thread to quit
+   std::thread m_compressor;                       ///< The compression thread
+};
+
+} // namespace empire
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that appends JSON lines or binary records to a file
+///
+/// @file      LogSinkStructured.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>         // For array<>
+#include <cerrno>        // For errno
+#include <system_error>  // For system_error generic_category()
+
+#include "LogKv.hpp"  // For formatLogEntryJson() encodeLogEntryBinary()
+#include "LogSinkStructured.hpp"
+
+namespace empire {
+
+LogSinkStructured::LogSinkStructured( const std::filesystem::path& path, const LogStructuredFormat format ) : m_format { format } {
+   m_file = std::fopen( path.c_str(), format == LogStructuredFormat::binary ? "ab" : "a" );  // NOLINT( cppcoreguidelines-owning-memory ): The FILE is closed in the destructor
+   if( m_file == nullptr ) {
+      throw std::system_error( errno, std::generic_category(), "Unable to open log file [" + path.string() + "]" );
+   }
+}
+
+
+LogSinkStructured::~LogSinkStructured() {
+   std::fclose( m_file );  // NOLINT( cert-err33-c, cppcoreguidelines-owning-memory ): There's nothing we can do if fclose() fails
+}
+
+
+void LogSinkStructured::write( const std::span< const LogEntry > batch ) {
+   std::array< char, LOG_STRUCTURED_LENGTH > record {};
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const LogEntry& entry : batch ) {
+      const size_t length = ( m_format == LogStructuredFormat::binary )
+                          ? encodeLogEntryBinary( entry, record.data(), record.size() )
+                          : formatLogEntryJson( entry, record.data(), record.size() );
+      std::fwrite( record.data(), 1, length, m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+   }
+}
+
+
+void LogSinkStructured::flush() {
+   std::fflush( m_file );  // NOLINT( cert-err33-c ): A logger has nowhere to report its own errors
+}
+
+} // namespace empire
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A LogSink that appends JSON lines or binary records to a file
+///
+/// @file      LogSinkStructured.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdio>      // For FILE
+#include <filesystem>  // For path
+
+#include "LogSink.hpp"
+
+namespace empire {
+
+/// How LogSinkStructured writes each LogEntry
+enum class LogStructuredFormat {
+   jsonLines,  ///< One JSON object per line (see formatLogEntryJson())
+   binary      ///< Length-prefixed binary records (see encodeLogEntryBinary())
+};
+
+
+/// Append each LogEntry to a file in a machine-readable format
+///
+/// The fields of a structured LogEntry (see LogKv.hpp) keep their keys and
+/// types.  A plain LogEntry is written with its message and no fields.
+class LogSinkStructured final : public LogSink {
+public:
+   /// Open (or create) a file for appending
+   ///
+   /// @param path The file
+   /// @param format JSON lines or binary records
+   /// @throws system_error if the file can't be opened
+   LogSinkStructured( const std::filesystem::path& path, LogStructuredFormat format );
+
+   LogSinkStructured( const LogSinkStructured& ) = delete;             ///< Disable copy constructor
+   LogSinkStructured( LogSinkStructured&& ) = delete;                  ///< Disable move constructor
+   LogSinkStructured& operator=( const LogSinkStructured& ) = delete;  ///< Disable copy assignment
+   LogSinkStructured& operator=( LogSinkStructured&& ) = delete;       ///< Disable move assignment
+
+   /// Flush and close the file
+   ~LogSinkStructured() override;
+
+   void write( std::span< const LogEntry > batch ) override;
+   void flush() override;
+
+private:
+   std::FILE* m_file { nullptr };  ///< The open file
+   LogStructuredFormat m_format;   ///< How each LogEntry is written
+};
+
+} // namespace empire
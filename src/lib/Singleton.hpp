@@ -15,15 +15,101 @@
 
 #include <boost/core/type_name.hpp>        // For type_name
 #include <boost/uuid/uuid.hpp>             // For uuid
-#include <boost/uuid/uuid_generators.hpp>  // For nil_generator() random_generator()
+#include <boost/uuid/uuid_generators.hpp>  // For nil_generator() random_generator_mt19937
 #include <boost/uuid/uuid_io.hpp>          // For uuid::to_string()
 
+#include <atomic>                          // For atomic<>
+#include <cstdint>                         // For uint64_t
 #include <memory>                          // For unique_ptr make_unique()
+#include <mutex>                           // For mutex scoped_lock
+#include <string>                          // For string to_string()
+#include <type_traits>                     // For is_same_v
+#include <variant>                         // For monostate
 
 #include "../typedefs.hpp"                 // For singleton_counter_t
 
 namespace empire {
 
+/// Singleton identity policy:  A random UUID for each instance
+///
+/// The UUIDs come from one Mersenne Twister, seeded once from the OS, that's
+/// shared by every Singleton.  Seeding a `random_generator` for each instance
+/// reads the OS entropy source every time.
+struct SingletonUuidIdentity {
+   using id_type = boost::uuids::uuid;             ///< The identity of an instance
+   static constexpr const char* label { "UUID" };  ///< How info() labels it (`nullptr` for no identity)
+
+   /// @return The identity of an empty Singleton
+   static id_type nil() {
+      return boost::uuids::nil_generator()();
+   }
+
+   /// @return A new identity
+   static id_type next() {
+      static std::mutex generatorMutex;                       // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's local to next()
+      static boost::uuids::random_generator_mt19937 generator;  // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's local to next()
+
+      const std::scoped_lock lock( generatorMutex );
+      return generator();
+   }
+
+   /// @return `id` as a string
+   static std::string toString( const id_type& id ) {
+      return to_string( id );
+   }
+};
+
+
+/// Singleton identity policy:  A 64-bit generation number for each instance
+///
+/// Every instance of every Singleton using this policy gets the next number
+/// from one atomic counter, so it costs a single `fetch_add`.  0 is nil.
+struct SingletonGenerationIdentity {
+   using id_type = uint64_t;                             ///< The identity of an instance
+   static constexpr const char* label { "generation" };  ///< How info() labels it (`nullptr` for no identity)
+
+   /// @return The identity of an empty Singleton
+   static constexpr id_type nil() {
+      return 0;
+   }
+
+   /// @return A new identity
+   static id_type next() {
+      static std::atomic< uint64_t > generation { 0 };  // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's local to next()
+      return generation.fetch_add( 1, std::memory_order_relaxed ) + 1;
+   }
+
+   /// @return `id` as a string
+   static std::string toString( const id_type id ) {
+      return std::to_string( id );
+   }
+};
+
+
+/// Singleton identity policy:  No identity at all
+///
+/// The constructor and destructor counters still catch a second instance.
+struct SingletonNoIdentity {
+   using id_type = std::monostate;                  ///< The identity of an instance
+   static constexpr const char* label { nullptr };  ///< How info() labels it (`nullptr` for no identity)
+
+   /// @return The identity of an empty Singleton
+   static constexpr id_type nil() {
+      return {};
+   }
+
+   /// @return A new identity
+   static constexpr id_type next() {
+      return {};
+   }
+
+   /// @return An empty string
+   static std::string toString( [[maybe_unused]] const id_type id ) {
+      return {};
+   }
+};
+
+
 /// Template for a Singleton class
 ///
 /// This is more like a Singleton helper.  Users of Singleton will inherit this
@@ -51,7 +137,18 @@ namespace empire {
 /// The assurances of singleness are at runtime and (I'd assess) to be
 /// relatively weak against a determined hacker.
 ///
-/// This class is also not thread-safe.
+/// get() and erase() are thread-safe.  The first get() constructs the
+/// Singleton under #s_mutex and publishes it in #s_pointer (double-checked
+/// locking), so two threads that race to get() at startup get the same
+/// instance.  After that, a release build of get() is one `acquire` load:  It's
+/// wait-free.  erase() doesn't know who's still holding a reference, so it's
+/// up to the caller to stop using the instance before erasing it.
+///
+/// Each instance gets an identity from the `Identity` policy:
+/// SingletonUuidIdentity (the default), SingletonGenerationIdentity or
+/// SingletonNoIdentity.  It shows up in info() and validate() checks it.
+///
+///     class Nations final : public Singleton< Nations, SingletonGenerationIdentity > { ... };
 ///
 /// Singletons that need configuration parameters are tricky.  You don't really
 /// want to pass them in with every get() call.  That's wasteful as you really
@@ -63,7 +160,8 @@ namespace empire {
 ///
 /// @pattern Singleton:  This is a base class for Singleton
 /// @tparam T This derived class will be a Singleton
-template< typename T >
+/// @tparam Identity How each instance is identified
+template< typename T, typename Identity = SingletonUuidIdentity >
 class Singleton {
 public:  // /////////////////// Constructors & Destructors /////////////////////
 
@@ -90,7 +188,7 @@ public:  // /////////////////// Constructors & Destructors /////////////////////
    virtual ~Singleton() {
       // std::cout << "Destructor for " << info() << std::endl;
 
-      uuid = boost::uuids::nil_generator()();
+      identity = Identity::nil();
       destructCounter += 1;
       // validate();  // It's not safe to call validate() yet because
       // the derived class's destructor has not fired yet.
@@ -105,12 +203,17 @@ public:  // ///////////////////////// Static Methods ///////////////////////////
    ///
    ///     TestSingleton1 UUID=0982ec0e-34c2-4769-837e-abd90834e407 constructed 14 times destroyed 13 times
    ///
+   /// The identity is labeled by the `Identity` policy (and left out for
+   /// SingletonNoIdentity).
+   ///
    /// @return An info string
    static std::string info() {
       std::string infoString {} ;
 
       infoString += boost::core::type_name<T>();
-      infoString += " UUID=" + to_string( uuid );
+      if constexpr( Identity::label != nullptr ) {
+         infoString += std::string( " " ) + Identity::label + "=" + Identity::toString( identity );
+      }
       infoString += " constructed " + std::to_string( constructCounter ) + " times";
       infoString += " destroyed " + std::to_string( destructCounter ) + " times";
       return infoString;
@@ -134,14 +237,17 @@ public:  // ///////////////////////// Static Methods ///////////////////////////
    ///
    /// @return `true` if this Singleton has been instantiated.  `false` if not.
    [[nodiscard]] static bool isInstantiated() {
-      /// @NOLINTNEXTLINE( readability-simplify-boolean-expr ): `unique_ptr<T>` has an implicit cast to a bool to indicate if it's set or not. There's no explicit cast, so we have to do this
-      return s_instance ? true : false;
+      return s_pointer.load( std::memory_order_acquire ) != nullptr;
    }
 
    /// Validate the health of this Singleton
+   ///
+   /// get() calls this in debug builds.  It's not cheap, so release builds
+   /// should only call it from a health check.  It doesn't take #s_mutex, so
+   /// don't call it while another thread could erase() the Singleton.
    static void validate() {
       /// @throws logic_error if the info() string is not constructed correctly
-      if( info().find( "UUID" ) == std::string::npos ) {
+      if( info().find( " constructed " ) == std::string::npos ) {
          throw std::logic_error( "The Singleton's info string was not constructed correctly");
       }
 
@@ -156,14 +262,14 @@ public:  // ///////////////////////// Static Methods ///////////////////////////
             throw std::range_error( "A Singleton's constructCounter should be one more than it's destructCounter" );
          }
 
-         /// @throws logic_error if a populated Singleton's #uuid is not set
-         if( uuid == boost::uuids::nil_generator()() ) {
-            throw std::logic_error( "A Singleton's UUID should be set");
+         /// @throws logic_error if a populated Singleton's #identity is not set
+         if( Identity::label != nullptr && identity == Identity::nil() ) {
+            throw std::logic_error( "A Singleton's identity should be set");
          }
       } else {
-         if( uuid != boost::uuids::nil_generator()() ) {
-            /// @throws logic_error if an empty Singleton has a populated #uuid
-            throw std::logic_error( "UUID should be nil for an empty Singleton");
+         if( identity != Identity::nil() ) {
+            /// @throws logic_error if an empty Singleton has a populated #identity
+            throw std::logic_error( "The identity should be nil for an empty Singleton");
          }
          if( constructCounter != destructCounter ) {
             /// @throws range_error if an empty Singleton's #constructCounter and #destructCounter are not equal
@@ -172,13 +278,23 @@ public:  // ///////////////////////// Static Methods ///////////////////////////
       }
    }
 
+   /// Get the identity of this Singleton
+   ///
+   /// @return The identity from the `Identity` policy or `Identity::nil()` if
+   ///         it hasn't been instantiated yet.
+   [[nodiscard]] typename Identity::id_type getIdentity() const {
+      return identity;
+   }
+
    /// Get the Universally Unique IDentifier or UUID for this Singleton
    ///
+   /// Only for SingletonUuidIdentity
+   ///
    /// @return A Universally Unique IDentifier or UUID for this Singleton or
    ///         `00000000-0000-0000-0000-000000000000` if it hasn't been
    ///         instantiated yet.
-   [[nodiscard]] boost::uuids::uuid getUUID() const {
-      return uuid;
+   [[nodiscard]] boost::uuids::uuid getUUID() const requires std::is_same_v< Identity, SingletonUuidIdentity > {
+      return identity;
    }
 
 
@@ -189,17 +305,25 @@ public:  // ///////////////////////// Static Methods ///////////////////////////
    /// The ability to delete and recreate a Singleton is beneficial for unit
    /// testing and is one of the (few) things that makes having a Singleton
    /// palatable.
+   ///
+   /// Like get(), it only calls validate() in debug builds.
    static void erase() {
       // std::cout << "Erase " << info() << std::endl;
 
+      const std::scoped_lock lock( s_mutex );
+
       if( !isInstantiated() ) {
          return;
       }
 
+      s_pointer.store( nullptr, std::memory_order_release );
+
       // Fires ~Singleton which resets the member variables
       s_instance.reset(nullptr);
 
-      validate();
+      #ifndef NDEBUG
+         validate();
+      #endif
    }
 
 
@@ -218,7 +342,7 @@ protected:  // /////////////// Protected Methods & Members /////////////////////
          throw std::logic_error( "Attempt to create a new Singleton on top of an existing one" );
       }
 
-      uuid = boost::uuids::random_generator()();
+      identity = Identity::next();
       constructCounter += 1;
 
       // std::cout << "Instantiated " << info() << std::endl;
@@ -228,42 +352,72 @@ protected:  // /////////////// Protected Methods & Members /////////////////////
 
 private:  // //////////////////// Private Static Members ///////////////////////
    static std::unique_ptr<T>  s_instance;        ///< A unique "smart pointer" to an instance of this Singleton  @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
-   static boost::uuids::uuid  uuid;              ///< Universally Unique IDentifier for this Singleton           @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+   static std::atomic<T*>     s_pointer;         ///< #s_instance, published for the lock-free path through get() @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+   static std::mutex          s_mutex;           ///< Guards constructing and erasing the Singleton               @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+   static typename Identity::id_type identity;   ///< The identity of this instance (see the `Identity` policy)   @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
    static singleton_counter_t constructCounter;  ///< Number of times this Singleton has been constructed        @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
    static singleton_counter_t destructCounter;   ///< Number of times this Singleton has been destroyed          @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
 
 }; // Singleton
 
 
-template< typename T >
-std::unique_ptr< T > Singleton< T >::s_instance;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+template< typename T, typename Identity >
+std::unique_ptr< T > Singleton< T, Identity >::s_instance;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+
+template< typename T, typename Identity >
+std::atomic< T* > Singleton< T, Identity >::s_pointer { nullptr };  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+
+template< typename T, typename Identity >
+std::mutex Singleton< T, Identity >::s_mutex;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
 
-template< typename T >
-boost::uuids::uuid Singleton< T >::uuid = boost::uuids::nil_generator()();  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+template< typename T, typename Identity >
+typename Identity::id_type Singleton< T, Identity >::identity = Identity::nil();  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
 
-template< typename T >
-singleton_counter_t Singleton< T >::constructCounter = 0;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+template< typename T, typename Identity >
+singleton_counter_t Singleton< T, Identity >::constructCounter = 0;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
 
-template< typename T >
-singleton_counter_t Singleton< T >::destructCounter = 0;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+template< typename T, typename Identity >
+singleton_counter_t Singleton< T, Identity >::destructCounter = 0;  ///< @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
 
 
 /// Get an instance of this Singleton
 ///
-/// Uses `inline` to maximize performance
+/// Once the Singleton is instantiated, a release build of get() is a single
+/// `acquire` load of #s_pointer (it's `inline` to maximize performance).  If
+/// it's not instantiated, get() takes #s_mutex and checks again, so only one
+/// thread constructs it.
+///
+/// validate() builds the info() string (with heap allocations), so it's only
+/// called here in debug builds (without `NDEBUG`), under #s_mutex so it
+/// doesn't race erase().  Release builds that want to check on a Singleton
+/// call validate() themselves, like a health check.
 ///
 /// @tparam T The Singleton class
+/// @tparam Identity How each instance is identified
 /// @return The one and only instance of `T`
-template< typename T >
-inline T& Singleton< T >::get() {
-
-   if( !isInstantiated() ) {
-      s_instance = std::make_unique<T>( token {} ) ;
+template< typename T, typename Identity >
+inline T& Singleton< T, Identity >::get() {
+   T* instance = s_pointer.load( std::memory_order_acquire );
+
+   if( instance == nullptr ) [[unlikely]] {
+      const std::scoped_lock lock( s_mutex );
+
+      instance = s_pointer.load( std::memory_order_relaxed );
+      if( instance == nullptr ) {
+         s_instance = std::make_unique<T>( token {} ) ;
+         instance = s_instance.get();
+         s_pointer.store( instance, std::memory_order_release );
+      }
    }
 
-   validate();
+   #ifndef NDEBUG
+   {
+      const std::scoped_lock lock( s_mutex );
+      validate();
+   }
+   #endif
 
-   return *s_instance;
+   return *instance;
 }
 
 }  // namespace empire
@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Construct every Singleton at boot, in dependency order
+///
+/// @file      lib/SingletonRegistry.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>           // For any_of() find_if() max() min()
+#include <chrono>              // For steady_clock
+#include <condition_variable>  // For condition_variable
+#include <exception>           // For exception_ptr current_exception() rethrow_exception()
+#include <mutex>               // For mutex scoped_lock unique_lock
+#include <stdexcept>           // For logic_error
+#include <thread>              // For thread
+#include <utility>             // For move()
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "SingletonRegistry" };
+
+#include "Log.hpp"
+#include "SingletonRegistry.hpp"
+
+using namespace std;
+
+namespace empire {
+
+namespace {
+
+/// A registered Singleton
+struct Registration {
+   string name;                   ///< The name it was registered with
+   vector< string > dependsOn;    ///< The names of the Singletons it needs
+   function< void() > construct;  ///< Constructs it
+   function< void() > erase;      ///< Erases it
+};
+
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-non-const-global-variables ): They're in an anonymous namespace
+
+/// Guards Registry and Started
+mutex RegistryMutex;
+
+/// Every registered Singleton
+vector< Registration > Registry;
+
+/// The indexes into Registry that startSingletons() constructed, in order
+vector< size_t > Started;
+
+// NOLINTEND( cppcoreguidelines-avoid-non-const-global-variables )
+
+
+/// The dependency graph of Registry
+struct Graph {
+   vector< vector< size_t > > dependents;  ///< The Singletons that depend on each Singleton
+   vector< size_t > waiting;               ///< The number of dependencies each Singleton has
+   vector< size_t > depth;                 ///< Each Singleton's SingletonInitTime::depth
+};
+
+
+/// Resolve the dependency names and check for cycles
+///
+/// @return The dependency graph of Registry
+/// @throws logic_error if a dependency isn't registered or there's a cycle
+Graph buildGraph() {
+   const size_t count = Registry.size();
+   Graph graph { vector< vector< size_t > >( count ), vector< size_t >( count, 0 ), vector< size_t >( count, 0 ) };
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < count ; i++ ) {
+      for( const string& dependency : Registry[ i ].dependsOn ) {  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+         const auto found = find_if( Registry.begin(), Registry.end(), [ &dependency ]( const Registration& registration ) {
+            return registration.name == dependency;
+         } );
+         if( found == Registry.end() ) {
+            throw logic_error( "Singleton [" + Registry[ i ].name + "] depends on [" + dependency + "], which isn't registered" );
+         }
+         graph.dependents[ static_cast< size_t >( found - Registry.begin() ) ].push_back( i );
+         graph.waiting[ i ] += 1;
+      }
+   }
+
+   /// Walk it in dependency order (Kahn's algorithm) to get the depths.
+   /// Anything that's never reached is in a cycle.
+   vector< size_t > waiting = graph.waiting;
+   vector< size_t > ready;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < count ; i++ ) {
+      if( waiting[ i ] == 0 ) {
+         ready.push_back( i );
+      }
+   }
+
+   size_t reached = 0;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   while( !ready.empty() ) {
+      const size_t i = ready.back();
+      ready.pop_back();
+      reached += 1;
+      for( const size_t dependent : graph.dependents[ i ] ) {  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+         graph.depth[ dependent ] = max( graph.depth[ dependent ], graph.depth[ i ] + 1 );
+         if( --waiting[ dependent ] == 0 ) {
+            ready.push_back( dependent );
+         }
+      }
+   }
+
+   if( reached != count ) {
+      throw logic_error( "The Singleton dependencies have a cycle" );
+   }
+
+   return graph;
+}
+
+} // namespace
+
+
+void registerSingletonFunctions( const string& name
+                                ,const vector< string >& dependsOn
+                                ,function< void() > construct
+                                ,function< void() > erase ) {
+   const scoped_lock lock( RegistryMutex );
+
+   if( any_of( Registry.begin(), Registry.end(), [ &name ]( const Registration& registration ) { return registration.name == name; } ) ) {
+      throw logic_error( "Singleton [" + name + "] is already registered" );
+   }
+
+   Registry.push_back( { name, dependsOn, std::move( construct ), std::move( erase ) } );
+}
+
+
+vector< SingletonInitTime > startSingletons( size_t threads ) {
+   const scoped_lock registryLock( RegistryMutex );
+
+   if( !Started.empty() ) {
+      throw logic_error( "The Singletons are already started" );
+   }
+
+   Graph graph = buildGraph();
+   const size_t count = Registry.size();
+
+   /// The pool's state, guarded by `poolMutex`
+   mutex poolMutex;
+   condition_variable poolChanged;
+   vector< size_t > ready;
+   size_t finished = 0;
+   exception_ptr failure;
+   vector< SingletonInitTime > times;
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 0 ; i < count ; i++ ) {
+      if( graph.waiting[ i ] == 0 ) {
+         ready.push_back( i );
+      }
+   }
+
+   /// Each thread constructs whatever's ready until everything is done
+   auto worker = [ & ]() {
+      unique_lock lock( poolMutex );
+      // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+      while( true ) {
+         poolChanged.wait( lock, [ & ]() { return !ready.empty() || finished == count || failure; } );
+         if( failure || ready.empty() ) {
+            return;
+         }
+
+         const size_t i = ready.back();
+         ready.pop_back();
+         lock.unlock();
+
+         const auto start = chrono::steady_clock::now();
+         try {
+            Registry[ i ].construct();
+         } catch( ... ) {
+            lock.lock();
+            failure = current_exception();
+            poolChanged.notify_all();
+            return;
+         }
+         const auto ns = static_cast< uint64_t >( chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now() - start ).count() );
+
+         lock.lock();
+         times.push_back( { Registry[ i ].name, ns, graph.depth[ i ] } );
+         Started.push_back( i );
+         finished += 1;
+         for( const size_t dependent : graph.dependents[ i ] ) {  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+            if( --graph.waiting[ dependent ] == 0 ) {
+               ready.push_back( dependent );
+            }
+         }
+         poolChanged.notify_all();
+      }
+   };
+
+   if( threads == 0 ) {
+      threads = max( thread::hardware_concurrency(), 1U );
+   }
+   threads = min( threads, count );
+
+   vector< thread > pool;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t t = 0 ; t < threads ; t++ ) {
+      pool.emplace_back( worker );
+   }
+   for( thread& poolThread : pool ) {  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+      poolThread.join();
+   }
+
+   for( const SingletonInitTime& time : times ) {  // NOLINT( altera-unroll-loops ): No need to unroll this loop
+      LOG_INFO( "Constructed Singleton %s in %lu ns", time.name.c_str(), static_cast< unsigned long >( time.ns ) );
+   }
+
+   if( failure ) {
+      LOG_ERROR( "A Singleton failed to construct.  %zu of %zu were constructed.", times.size(), count );
+      rethrow_exception( failure );
+   }
+
+   return times;
+}
+
+
+void stopSingletons() {
+   const scoped_lock lock( RegistryMutex );
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( auto i = Started.rbegin() ; i != Started.rend() ; ++i ) {
+      Registry[ *i ].erase();
+   }
+   Started.clear();
+}
+
+
+/// Forget every registered Singleton (without erasing them)
+///
+/// This is for unit tests, so it's not in SingletonRegistry.hpp
+void singletonRegistryReset() {
+   const scoped_lock lock( RegistryMutex );
+
+   Registry.clear();
+   Started.clear();
+}
+
+} // namespace empire
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Construct every Singleton at boot, in dependency order
+///
+/// Each Singleton is registered once with the names of the Singletons it
+/// needs.  startSingletons() constructs all of them before the first player
+/// command, so nobody pays for a lazy get().  A Singleton isn't constructed
+/// until everything it depends on is.  Singletons that don't depend on each
+/// other are constructed in parallel on a small pool of threads.
+///
+///     registerSingleton< Configuration >( "Configuration" );
+///     registerSingleton< WorldMap >( "WorldMap", { "Configuration" } );
+///     registerSingleton< Nations >( "Nations", { "Configuration", "WorldMap" } );
+///
+///     startSingletons();  // Configuration, then WorldMap, then Nations
+///     ...
+///     stopSingletons();   // Nations, then WorldMap, then Configuration
+///
+/// @file      lib/SingletonRegistry.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>     // For size_t
+#include <cstdint>     // For uint64_t
+#include <functional>  // For function<>
+#include <string>      // For string
+#include <vector>      // For vector<>
+
+namespace empire {
+
+/// How long startSingletons() took to construct a Singleton
+struct SingletonInitTime {
+   std::string name;  ///< The name it was registered with
+   uint64_t ns;       ///< The time in its get(), in nanoseconds
+   size_t depth;      ///< 0 if it has no dependencies.  Otherwise, one more than its deepest dependency.
+};
+
+
+/// Register a Singleton by the functions that construct and erase it
+///
+/// @param name The name of the Singleton
+/// @param dependsOn The names of the Singletons that must be constructed
+///                  first (they don't have to be registered yet)
+/// @param construct Constructs the Singleton (usually `T::get()`)
+/// @param erase Destroys the Singleton (usually `T::erase()`)
+/// @throws logic_error if `name` is already registered
+extern void registerSingletonFunctions( const std::string& name
+                                       ,const std::vector< std::string >& dependsOn
+                                       ,std::function< void() > construct
+                                       ,std::function< void() > erase );
+
+
+/// Register a Singleton for startSingletons()
+///
+/// @tparam T The Singleton class
+/// @param name The name of the Singleton
+/// @param dependsOn The names of the Singletons that must be constructed first
+/// @throws logic_error if `name` is already registered
+template< typename T >
+void registerSingleton( const std::string& name, const std::vector< std::string >& dependsOn = {} ) {
+   registerSingletonFunctions( name, dependsOn, []() { T::get(); }, []() { T::erase(); } );
+}
+
+
+/// Construct every registered Singleton
+///
+/// Each Singleton is constructed after the ones it depends on, on one of
+/// `threads` threads.  Each construction time is logged.  If a constructor
+/// throws, nothing else is started and the exception is rethrown once the
+/// constructors already running finish.  stopSingletons() erases the ones
+/// that were constructed.
+///
+/// @param threads The most Singletons to construct at once (0 for the
+///                number of cores)
+/// @return The construction times, in the order they finished
+/// @throws logic_error if a dependency isn't registered, the dependencies
+///         have a cycle or the Singletons are already started
+extern std::vector< SingletonInitTime > startSingletons( size_t threads = 0 );
+
+
+/// Erase the Singletons constructed by startSingletons(), in the reverse
+/// order they were constructed
+extern void stopSingletons();
+
+} // namespace empire
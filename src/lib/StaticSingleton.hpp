@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// A Singleton in static storage for the model's hot paths
+///
+/// @file      lib/StaticSingleton.hpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <boost/assert.hpp>  // For BOOST_ASSERT_MSG()
+
+#include <algorithm>  // For max()
+#include <array>      // For array<>
+#include <cstddef>    // For byte size_t
+#include <new>        // For launder() placement new
+#include <stdexcept>  // For logic_error
+#include <string>     // For string
+#include <utility>    // For forward()
+#include <vector>     // For vector<>
+
+#include "../version.hpp"         // For CACHE_LINE_BYTES
+#include "SingletonRegistry.hpp"  // For registerSingletonFunctions()
+
+namespace empire {
+
+/// Where StaticSingleton< T > keeps its `T`.  It has its own cache lines.
+///
+/// It's a variable template (not a member of StaticSingleton) so `T` can name
+/// StaticSingleton< T >::token in its constructor before `T` is complete.
+template< typename T >
+alignas( std::max( size_t { CACHE_LINE_BYTES }, alignof( T ) ) ) inline std::array< std::byte, sizeof( T ) > StaticSingletonStorage {};  // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): Only StaticSingleton uses it
+
+
+/// A Singleton that lives in static storage instead of on the heap
+///
+/// Singleton::get() loads a pointer and checks it before every access.  The
+/// model objects that update loops touch millions of times a tick (WorldMap
+/// and Nations, say) can use StaticSingleton instead:  The object is built
+/// in place in cache-line-aligned static storage, so get() is a constant
+/// address with no branch and no pointer to chase.
+///
+/// The price is that nothing is lazy.  construct() must be called before the
+/// first get() (startSingletons() does it for registerStaticSingleton()) and
+/// destroy() after the last.  Neither is thread-safe:  They're for startup and
+/// shutdown.  Debug builds assert that get() is only called while it's
+/// constructed.
+///
+///     class WorldMap final {
+///     public:
+///        explicit WorldMap( StaticSingleton< WorldMap >::token singletonToken );
+///        ...
+///     };
+///
+///     StaticSingleton< WorldMap >::construct();
+///     StaticSingleton< WorldMap >::get().sector( x, y ) ...
+///     StaticSingleton< WorldMap >::destroy();
+///
+/// @pattern Singleton:  A Singleton with explicit lifetime
+/// @tparam T The class to hold.  Its constructor takes a #token first.
+template< typename T >
+class StaticSingleton final {
+public:  // /////////////////// Constructors & Destructors /////////////////////
+
+   /// Only StaticSingleton can make a #token, so only it can construct `T`
+   class token {
+      friend class StaticSingleton;
+      token() = default;
+   };
+
+   StaticSingleton() = delete;  ///< It's all static
+
+
+public:  // ///////////////////////// Static Methods ///////////////////////////
+
+   /// Construct `T` in the static storage
+   ///
+   /// @param args The rest of `T`'s constructor arguments (after the #token)
+   /// @return The one and only instance of `T`
+   /// @throws logic_error if it's already constructed
+   template< typename... Args >
+   static T& construct( Args&&... args ) {
+      if( s_constructed ) {
+         throw std::logic_error( "Attempt to construct a StaticSingleton on top of an existing one" );
+      }
+
+      new( StaticSingletonStorage< T >.data() ) T( token {}, std::forward< Args >( args )... );
+      s_constructed = true;
+      return get();
+   }
+
+   /// Destroy `T` (it's OK if it's not constructed)
+   static void destroy() {
+      if( !s_constructed ) {
+         return;
+      }
+
+      instance()->~T();
+      s_constructed = false;
+   }
+
+   /// Get the instance of `T`
+   ///
+   /// It's a constant address, so this compiles down to nothing.
+   ///
+   /// @return The one and only instance of `T`
+   [[nodiscard]] static T& get() noexcept {
+      #ifndef NDEBUG
+         BOOST_ASSERT_MSG( s_constructed, "StaticSingleton::get() before construct() or after destroy()" );
+      #endif
+      return *instance();
+   }
+
+   /// @return `true` between construct() and destroy()
+   [[nodiscard]] static bool isConstructed() noexcept {
+      return s_constructed;
+   }
+
+
+private:  // ////////////////////////// Private Methods ////////////////////////
+
+   /// @return The `T` in StaticSingletonStorage
+   static T* instance() noexcept {
+      return std::launder( reinterpret_cast< T* >( StaticSingletonStorage< T >.data() ) );  // NOLINT( cppcoreguidelines-pro-type-reinterpret-cast ): `T` was constructed in StaticSingletonStorage
+   }
+
+
+private:  // //////////////////// Private Static Members ///////////////////////
+   static inline bool s_constructed { false };  ///< `true` between construct() and destroy()  @NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): This is not really a global
+
+}; // StaticSingleton
+
+
+/// Register a StaticSingleton for startSingletons()
+///
+/// startSingletons() calls StaticSingleton::construct() (with no arguments
+/// after the #token) and stopSingletons() calls StaticSingleton::destroy().
+///
+/// @tparam T The class held by the StaticSingleton
+/// @param name The name of the Singleton
+/// @param dependsOn The names of the Singletons that must be constructed first
+/// @throws logic_error if `name` is already registered
+template< typename T >
+void registerStaticSingleton( const std::string& name, const std::vector< std::string >& dependsOn = {} ) {
+   registerSingletonFunctions( name, dependsOn, []() { StaticSingleton< T >::construct(); }, []() { StaticSingleton< T >::destroy(); } );
+}
+
+} // namespace empire
@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Decode and filter the binary log files written by LogSinkMapped (and the
+/// crash dumps written by writeLogCrashDump())
+///
+/// Usage:
+///
+///     empire_logdump [--severity <severity>] [--module <name>]...
+///                    [--since <time>] [--until <time>] <file>
+///
+///   - `--severity` shows records at or above a severity (`test`, `trace`,
+///     `debug`, `info`, `warning`, `error` or `fatal`)
+///   - `--module` shows records from a module.  It can be repeated.
+///   - `--since` and `--until` show records in a time range.  A time is
+///     `YYYY-MM-DD HH:MM:SS` (or with a `T` in the middle) in UTC, or a number
+///     of seconds since the Unix epoch.  `--until` is exclusive.
+///
+/// Each record is printed on one line, the same as LogSinkFile.
+///
+/// @file      main_empire_logdump.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <array>         // For array<>
+#include <cstdint>       // For uint64_t
+#include <cstdio>        // For fwrite()
+#include <cstdlib>       // For strtoull()
+#include <ctime>         // For tm timegm() strptime()
+#include <fstream>       // For ifstream
+#include <iostream>      // For cerr & endl
+#include <limits>        // For numeric_limits<>
+#include <optional>      // For optional<>
+#include <stdexcept>     // For range_error
+#include <string>        // For string
+#include <string_view>   // For string_view
+#include <system_error>  // For system_error
+#include <vector>        // For vector<>
+
+#include "lib/LogClock.hpp"      // For NS_PER_SECOND
+#include "lib/LogCrash.hpp"      // For readLogCrashDump() LOG_CRASH_MAGIC
+#include "lib/LogEntry.hpp"      // For formatLogEntry()
+#include "lib/LogModule.hpp"     // For registerLogModule()
+#include "lib/LogSinkMapped.hpp"
+
+using namespace std;
+
+using namespace empire;
+
+/// Print the usage message
+///
+/// @param program The name of this program
+/// @return The exit status for a bad command line
+static int usage( const string_view program ) {
+   cerr << "Usage: " << program << " [--severity <severity>] [--module <name>]... [--since <time>] [--until <time>] <file>" << endl;
+   cerr << "  A <time> is YYYY-MM-DD HH:MM:SS in UTC or seconds since the Unix epoch" << endl;
+   return 2;
+}
+
+
+/// Parse a LogSeverity by name
+///
+/// @param name The name (as printed by LogSeverityToString())
+/// @return The LogSeverity (or nothing if there isn't one by that name)
+static optional< LogSeverity > parseSeverity( const string_view name ) {
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( int i = 0 ; i < static_cast< int >( LogSeverity::COUNT ) ; i++ ) {
+      if( LogSeverityToString( static_cast< LogSeverity >( i ) ) == name ) {
+         return static_cast< LogSeverity >( i );
+      }
+   }
+   return nullopt;
+}
+
+
+/// Parse a time on the command line
+///
+/// @param text `YYYY-MM-DD HH:MM:SS`, `YYYY-MM-DDTHH:MM:SS` (UTC) or seconds
+///             since the Unix epoch
+/// @return The time in nanoseconds since the Unix epoch (or nothing if it
+///         can't be parsed)
+static optional< uint64_t > parseTime( const string& text ) {
+   tm parsed {};
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const char* format : { "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d" } ) {
+      parsed = tm {};
+      const char* const end = strptime( text.c_str(), format, &parsed );
+      if( end != nullptr && *end == '\0' ) {
+         const time_t seconds = timegm( &parsed );
+         if( seconds < 0 ) {
+            return nullopt;
+         }
+         return static_cast< uint64_t >( seconds ) * NS_PER_SECOND;
+      }
+   }
+
+   char* end = nullptr;
+   const unsigned long long seconds = strtoull( text.c_str(), &end, 10 );  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Base 10
+   if( text.empty() || end == nullptr || *end != '\0' ) {
+      return nullopt;
+   }
+   return static_cast< uint64_t >( seconds ) * NS_PER_SECOND;
+}
+
+
+/// Check if a file is a crash dump (rather than a LogSinkMapped file)
+///
+/// @param path The file
+/// @return `true` if it starts with LOG_CRASH_MAGIC
+static bool isLogCrashDump( const string& path ) {
+   ifstream file( path, ios::binary );
+   array< char, LOG_CRASH_MAGIC.size() > magic {};
+   file.read( magic.data(), magic.size() );
+   return file && magic == LOG_CRASH_MAGIC;
+}
+
+
+/// Decode a LogSinkMapped file (or a crash dump) and print the records that
+/// pass the filters
+///
+/// @param argc The number of arguments
+/// @param argv The command line
+/// @return 0 on success, 1 if the file can't be read, 2 for a bad command line
+int main( int argc, char* argv[] ) {
+   const vector< string > args( argv, argv + argc );  // NOLINT( cppcoreguidelines-pro-bounds-pointer-arithmetic ): Command line parsing
+
+   LogSeverity minSeverity = LogSeverity::test;
+   vector< string > modules;
+   uint64_t since = 0;
+   uint64_t until = numeric_limits< uint64_t >::max();
+   string path;
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( size_t i = 1 ; i < args.size() ; i++ ) {
+      const string& arg = args[ i ];
+      const bool hasValue = i + 1 < args.size();
+
+      if( arg == "--severity" && hasValue ) {
+         const optional< LogSeverity > severity = parseSeverity( args[ ++i ] );
+         if( !severity ) {
+            cerr << "Unknown severity [" << args[ i ] << "]" << endl;
+            return usage( args[ 0 ] );
+         }
+         minSeverity = *severity;
+      } else if( arg == "--module" && hasValue ) {
+         modules.push_back( args[ ++i ] );
+      } else if( ( arg == "--since" || arg == "--until" ) && hasValue ) {
+         const optional< uint64_t > time = parseTime( args[ ++i ] );
+         if( !time ) {
+            cerr << "Unable to parse the time [" << args[ i ] << "]" << endl;
+            return usage( args[ 0 ] );
+         }
+         ( arg == "--since" ? since : until ) = *time;
+      } else if( arg.starts_with( "--" ) || !path.empty() ) {
+         return usage( args[ 0 ] );
+      } else {
+         path = arg;
+      }
+   }
+
+   if( path.empty() ) {
+      return usage( args[ 0 ] );
+   }
+
+   LogMappedFile file;
+   try {
+      file = isLogCrashDump( path ) ? readLogCrashDump( path ) : readLogMappedFile( path );
+   } catch( const system_error& error ) {
+      cerr << error.what() << endl;
+      return 1;
+   }
+
+   /// formatLogEntry() looks up the module names in this process, so register
+   /// the file's names here.  Names that don't fit print as `unknown`.
+   vector< LogModuleId > moduleIds;
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( const string& name : file.moduleNames ) {
+      try {
+         moduleIds.push_back( registerLogModule( name.c_str() ) );
+      } catch( const range_error& ) {
+         moduleIds.push_back( LOG_MAPPED_UNKNOWN_MODULE );
+      }
+   }
+
+   array< char, LOG_LINE_LENGTH > line {};
+
+   // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+   for( LogEntry& entry : file.entries ) {
+      if( entry.logSeverity < minSeverity || entry.logTimestamp < since || entry.logTimestamp >= until ) {
+         continue;
+      }
+
+      if( !modules.empty() ) {
+         const string_view name = file.moduleName( entry.moduleId );
+         bool found = false;
+         // @NOLINTNEXTLINE( altera-unroll-loops ): No need to unroll this loop
+         for( const string& module : modules ) {
+            found = found || module == name;
+         }
+         if( !found ) {
+            continue;
+         }
+      }
+
+      entry.moduleId = ( entry.moduleId < moduleIds.size() ) ? moduleIds[ entry.moduleId ] : LOG_MAPPED_UNKNOWN_MODULE;
+
+      const size_t length = formatLogEntry( entry, line.data(), line.size() );
+      fwrite( line.data(), 1, length, stdout );  // NOLINT( cert-err33-c ): Nothing to do if stdout is closed
+   }
+
+   return 0;
+}
@@ -10,6 +10,7 @@
 
 #include <iostream>  // For cout & endl
 
+#include "lib/SingletonRegistry.hpp"  // For startSingletons() stopSingletons()
 #include "version.hpp"
 
 using namespace empire;
@@ -22,5 +23,10 @@ int main() {
    std::cout << std::endl;
    std::cout << LEGAL_NOTICE;
 
+   /// Construct every Singleton before the first command needs one
+   startSingletons();
+
+   stopSingletons();
+
    return 0;
 }
@@ -17,6 +17,24 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>     // For max() min()
+#include <array>         // For array<>
+#include <atomic>        // For atomic<>
+#include <csignal>       // For raise() SIGSEGV
+#include <cstdint>       // For uint64_t UINT64_MAX SIZE_MAX
+#include <cstdio>        // For sscanf()
+#include <cmath>         // For nan()
+#include <cstring>       // For memcmp()
+#include <filesystem>    // For temp_directory_path()
+#include <limits>        // For numeric_limits<>
+#include <memory>        // For make_unique<>()
+#include <span>          // For span<>
+#include <sys/resource.h>  // For setrlimit()
+#include <sys/wait.h>    // For waitpid()
+#include <thread>        // For thread
+#include <unistd.h>      // For fork() _exit()
+#include <vector>        // For vector<>
+
 #include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
 
 /// The name of the module for logging purposes
@@ -28,6 +46,11 @@
 #define MIN_LOG_SEVERITY LOG_SEVERITY_TEST
 #include "../src/lib/Log.hpp"
 
+#include "../src/lib/LogConsumer.hpp"
+#include "../src/lib/LogCrash.hpp"
+#include "../src/lib/LogQuery.hpp"
+#include "../src/lib/LogSink.hpp"
+
 
 /* ****************************************************************************
    White Box Test Declarations
@@ -89,9 +112,7 @@ BOOST_AUTO_TEST_CASE( Log_reset ) {
    BOOST_CHECK_EQUAL( memcmp( emptyEntry.msg, zeroMsgBuffer, LOG_MSG_LENGTH ), 0 );
    BOOST_CHECK_EQUAL( emptyEntry.msg_end, 0 );
 
-   const char zeroModuleBuffer[ MODULE_NAME_LENGTH ] { 0 };
-   BOOST_CHECK_EQUAL( memcmp( emptyEntry.module_name, zeroModuleBuffer, MODULE_NAME_LENGTH ), 0 );
-   BOOST_CHECK_EQUAL( emptyEntry.module_end, 0 );
+   BOOST_CHECK_EQUAL( emptyEntry.moduleId, 0 );
 
    // Not testing emptyEntry.severity
 }
@@ -104,10 +125,9 @@ BOOST_AUTO_TEST_CASE( Log_no_parameters ) {
 
    BOOST_CHECK_EQUAL( anEntry.msg, "Test log entry with no parameters" );
    BOOST_CHECK_EQUAL( anEntry.msg_end, 0 );
-   BOOST_CHECK_EQUAL( anEntry.module_name, "test_Log");
-   BOOST_CHECK_EQUAL( anEntry.module_end, 0 );
+   BOOST_CHECK_EQUAL( logModuleName( anEntry.moduleId ), "test_Log" );
    BOOST_CHECK_EQUAL( anEntry.logSeverity, LogSeverity::test );
-   BOOST_CHECK_CLOSE( (double) anEntry.logTimestamp, (double) std::time( nullptr ), 0.01 );
+   BOOST_CHECK_CLOSE( (double) logTicksToNs( anEntry.logTimestamp ) / NS_PER_SECOND, (double) std::time( nullptr ), 0.01 );
 }
 
 BOOST_AUTO_TEST_CASE( Log_one_int_parameter ) {
@@ -118,10 +138,9 @@ BOOST_AUTO_TEST_CASE( Log_one_int_parameter ) {
 
    BOOST_CHECK_EQUAL( anEntry.msg, "Test log entry with 1 parameter" );
    BOOST_CHECK_EQUAL( anEntry.msg_end, 0 );
-   BOOST_CHECK_EQUAL( anEntry.module_name, "test_Log");
-   BOOST_CHECK_EQUAL( anEntry.module_end, 0 );
+   BOOST_CHECK_EQUAL( logModuleName( anEntry.moduleId ), "test_Log" );
    BOOST_CHECK_EQUAL( anEntry.logSeverity, LogSeverity::test );
-   BOOST_CHECK_CLOSE( (double) anEntry.logTimestamp, (double) std::time( nullptr ), 0.01 );
+   BOOST_CHECK_CLOSE( (double) logTicksToNs( anEntry.logTimestamp ) / NS_PER_SECOND, (double) std::time( nullptr ), 0.01 );
 }
 
 BOOST_AUTO_TEST_CASE( Log_one_string_parameter ) {
@@ -132,10 +151,425 @@ BOOST_AUTO_TEST_CASE( Log_one_string_parameter ) {
 
    BOOST_CHECK_EQUAL( anEntry.msg, "Test log entry with one string parameter" );
    BOOST_CHECK_EQUAL( anEntry.msg_end, 0 );
-   BOOST_CHECK_EQUAL( anEntry.module_name, "test_Log");
-   BOOST_CHECK_EQUAL( anEntry.module_end, 0 );
+   BOOST_CHECK_EQUAL( logModuleName( anEntry.moduleId ), "test_Log" );
    BOOST_CHECK_EQUAL( anEntry.logSeverity, LogSeverity::test );
-   BOOST_CHECK_CLOSE( (double) anEntry.logTimestamp, (double) std::time( nullptr ), 0.01 );
+   BOOST_CHECK_CLOSE( (double) logTicksToNs( anEntry.logTimestamp ) / NS_PER_SECOND, (double) std::time( nullptr ), 0.01 );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_modules ) {
+   /// Every source file that includes Log.hpp registers its LOG_MODULE
+   BOOST_CHECK_EQUAL( logModuleName( LOG_MODULE_ID ), "test_Log" );
+   BOOST_CHECK_GE( logModuleCount(), 5 );
+
+   /// Registering a name again gets the same LogModuleId
+   BOOST_CHECK_EQUAL( registerLogModule( "test_Log" ), LOG_MODULE_ID );
+
+   const LogModuleId other = registerLogModule( "test_Log_other" );
+   BOOST_CHECK_NE( other, LOG_MODULE_ID );
+   BOOST_CHECK_EQUAL( registerLogModule( "test_Log_other" ), other );
+   BOOST_CHECK_EQUAL( logModuleName( other ), "test_Log_other" );
+
+   BOOST_CHECK_EQUAL( logModuleName( MAX_LOG_MODULES - 1 ), "unknown" );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_timestamps ) {
+   calibrateLogClock();
+   BOOST_CHECK_GT( logNsPerTick(), 0.0 );
+
+   /// Timestamps from one thread never go backwards
+   logReset();
+   uint64_t previous = 0;
+   for( int i = 0 ; i < 100 ; i++ ) {
+      LOG_TEST( "Timestamp %d", i );
+      BOOST_CHECK_GE( logPeek().logTimestamp, previous );
+      previous = logPeek().logTimestamp;
+   }
+
+   /// Back-to-back readings are less than a microsecond apart
+   uint64_t fastest = UINT64_MAX;
+   for( int i = 0 ; i < 100 ; i++ ) {
+      const uint64_t first = logClockNow();
+      const uint64_t second = logClockNow();
+      fastest = std::min( fastest, logTicksToNs( second ) - logTicksToNs( first ) );
+   }
+   if( LOG_CLOCK_SOURCE != LogClockSource::monotonicCoarse ) {
+      BOOST_CHECK_LT( fastest, 1000 );
+   }
+
+   /// The converted time agrees with the wall clock
+   const double wallNs = (double) logReadClockNs( CLOCK_REALTIME );
+   const double logNs = (double) logTicksToNs( logClockNow() );
+   BOOST_CHECK_SMALL( logNs - wallNs, 5e6 );  // Within 5ms
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_runtime_severity ) {
+   logReset();
+   BOOST_CHECK_EQUAL( getLogSeverity( LOG_MODULE_ID ), DEFAULT_LOG_SEVERITY );
+
+   LOG_TEST( "Logged at test" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at test" );
+
+   /// Turn this module down to `info`
+   BOOST_CHECK( setLogSeverity( "test_Log", LogSeverity::info ) );
+   BOOST_CHECK_EQUAL( getLogSeverity( LOG_MODULE_ID ), LogSeverity::info );
+
+   LOG_TEST( "Filtered at test" );
+   LOG_TRACE( "Filtered at trace" );
+   LOG_DEBUG( "Filtered at debug" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at test" );
+
+   LOG_INFO( "Logged at info" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at info" );
+
+   /// Other modules aren't affected
+   const LogModuleId other = registerLogModule( "test_Log_other" );
+   BOOST_CHECK_EQUAL( getLogSeverity( other ), DEFAULT_LOG_SEVERITY );
+
+   /// The macros work as expressions
+   if( logPeek().msg[ 0 ] == '\0' )
+      LOG_WARN( "Not logged" );
+   else
+      LOG_WARN( "Logged at %s", "warning" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at warning" );
+
+   BOOST_CHECK( !setLogSeverity( "no_such_module", LogSeverity::info ) );
+
+   /// Turn everything up and then back down
+   setLogSeverity( LogSeverity::error );
+   BOOST_CHECK_EQUAL( getLogSeverity( other ), LogSeverity::error );
+   LOG_WARN( "Filtered at warning" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at warning" );
+
+   setLogSeverity( DEFAULT_LOG_SEVERITY );
+   LOG_TEST( "Logged at test again" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Logged at test again" );
+}
+
+
+/// A LogSink that checks that every LogEntry is whole
+///
+/// Each producer in Log_stress writes its ID and counter several times
+/// across the message.  A torn LogEntry (one that mixes two producers'
+/// writes) will have values that don't agree.
+class StressSink : public LogSink {
+public:
+   /// @param producers The number of producer threads
+   explicit StressSink( const size_t producers ) : m_last( producers, -1 ) {}
+
+   void write( std::span< const LogEntry > entries ) override {
+      for( const LogEntry& entry : entries ) {
+         size_t dropped = 0;
+         if( sscanf( entry.msg, "Dropped %zu log entries", &dropped ) == 1 ) {
+            m_reported += dropped;
+            continue;
+         }
+
+         size_t t[ 4 ] {};
+         long n[ 4 ] {};
+         const int fields = sscanf( entry.msg, "t=%zu n=%ld t=%zu n=%ld t=%zu n=%ld t=%zu n=%ld"
+                                  ,&t[ 0 ], &n[ 0 ], &t[ 1 ], &n[ 1 ], &t[ 2 ], &n[ 2 ], &t[ 3 ], &n[ 3 ] );
+
+         if( fields != 8
+          || t[ 0 ] != t[ 1 ] || t[ 0 ] != t[ 2 ] || t[ 0 ] != t[ 3 ]
+          || n[ 0 ] != n[ 1 ] || n[ 0 ] != n[ 2 ] || n[ 0 ] != n[ 3 ]
+          || t[ 0 ] >= m_last.size()
+          || entry.moduleId != LOG_MODULE_ID
+          || entry.logSeverity != LogSeverity::test ) {
+            m_torn += 1;
+            continue;
+         }
+
+         /// Each producer's LogEntry records must come out in the order it wrote them
+         if( n[ 0 ] <= m_last[ t[ 0 ] ] ) {
+            m_outOfOrder += 1;
+         }
+         m_last[ t[ 0 ] ] = n[ 0 ];
+         m_delivered += 1;
+      }
+   }
+
+   size_t m_delivered { 0 };   ///< Whole LogEntry records from the producers
+   size_t m_reported { 0 };    ///< Drops the LogConsumer reported
+   size_t m_torn { 0 };        ///< LogEntry records that mixed two writes
+   size_t m_outOfOrder { 0 };  ///< LogEntry records that came out of order
+
+private:
+   std::vector< long > m_last;  ///< The last counter seen from each producer
+};
+
+
+/// Run a producer on every core (and at least 4) while a LogConsumer drains
+/// empire::LogQueue (or the per-thread rings).  No LogConsumer should ever see
+/// a torn LogEntry.
+BOOST_AUTO_TEST_CASE( Log_stress ) {
+   const size_t producers = std::max( std::thread::hardware_concurrency(), 4U );
+   const long entriesPerProducer = 20000;
+
+   for( const LogQueueMode mode : { LogQueueMode::shared, LogQueueMode::perThread } ) {
+   for( const LogOverrunPolicy policy : { LogOverrunPolicy::dropOldest, LogOverrunPolicy::dropNewest, LogOverrunPolicy::block } ) {
+      logReset();
+      setLogQueueMode( mode );
+      setLogOverrunPolicy( policy );
+
+      LogConsumer consumer;
+      auto& sink = dynamic_cast< StressSink& >( consumer.addSink( std::make_unique< StressSink >( producers ) ) );
+      consumer.restart();
+
+      std::atomic< bool > go { false };
+      std::vector< std::thread > threads;
+      for( size_t t = 0 ; t < producers ; t++ ) {
+         threads.emplace_back( [ t, &go ]() {
+            while( !go.load() ) {
+               std::this_thread::yield();
+            }
+            for( long n = 0 ; n < entriesPerProducer ; n++ ) {
+               LOG_TEST( "t=%zu n=%ld t=%zu n=%ld t=%zu n=%ld t=%zu n=%ld", t, n, t, n, t, n, t, n );
+            }
+         } );
+      }
+      go.store( true );
+
+      for( std::thread& thread : threads ) {
+         thread.join();
+      }
+      consumer.sync();
+      consumer.stop();
+
+      BOOST_CHECK_EQUAL( sink.m_torn, 0 );
+      BOOST_CHECK_EQUAL( sink.m_outOfOrder, 0 );
+      BOOST_CHECK_EQUAL( sink.m_reported, consumer.getDroppedCount() );
+      BOOST_CHECK_EQUAL( sink.m_delivered + consumer.getDroppedCount(), producers * entriesPerProducer );
+      if( policy == LogOverrunPolicy::block ) {
+         BOOST_CHECK_EQUAL( consumer.getDroppedCount(), 0 );
+      }
+   }
+   }
+
+   setLogQueueMode( DEFAULT_LOG_QUEUE_MODE );
+   setLogOverrunPolicy( DEFAULT_LOG_OVERRUN_POLICY );
+   logReset();
+}
+
+/// Recurse until the stack runs out
+///
+/// @param depth How deep we are
+/// @return Something that depends on every frame, so it can't be optimized away
+[[gnu::noinline]] static size_t overflowTheStack( const size_t depth ) {  // NOLINT( misc-no-recursion ): That's the point
+   if( depth == SIZE_MAX ) {
+      return 0;  // It never gets this far
+   }
+   std::array< volatile char, 1024 > frame {};  // NOLINT( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Any size will do
+   frame[ depth % frame.size() ] = 1;
+   return overflowTheStack( depth + 1 ) + frame[ 0 ];
+}
+
+BOOST_AUTO_TEST_CASE( Log_crash_dump ) {
+   logReset();
+
+   const std::filesystem::path path = std::filesystem::temp_directory_path() / "test_Log.crash";
+   std::filesystem::remove( path );
+
+   /// Without a crash handler, LOG_FATAL doesn't dump
+   LOG_FATAL( "Not dumped" );
+   BOOST_CHECK( !std::filesystem::exists( path ) );
+
+   /// LOG_FATAL dumps LogQueue
+   installLogCrashHandler( path );
+   LOG_INFO( "Before the fatal %d", 1 );
+   LOG_FATAL( "The fatal %d", 2 );
+   uninstallLogCrashHandler();
+
+   LogMappedFile dump = readLogCrashDump( path );
+   BOOST_REQUIRE_EQUAL( dump.entries.size(), 3 );
+   BOOST_CHECK_EQUAL( dump.entries[ 0 ].msg, "Not dumped" );
+   BOOST_CHECK_EQUAL( dump.entries[ 1 ].msg, "Before the fatal 1" );
+   BOOST_CHECK_EQUAL( dump.entries[ 2 ].msg, "The fatal 2" );
+   BOOST_CHECK( dump.entries[ 2 ].logSeverity == LogSeverity::fatal );
+   BOOST_CHECK_EQUAL( dump.moduleName( dump.entries[ 2 ].moduleId ), "test_Log" );
+
+   /// A crash dumps LogQueue and the per-thread rings, then the process dies
+   /// of the same signal
+   const pid_t child = fork();
+   BOOST_REQUIRE( child >= 0 );
+   if( child == 0 ) {
+      const rlimit noCore { 0, 0 };
+      setrlimit( RLIMIT_CORE, &noCore );
+      installLogCrashHandler( path );
+      setLogQueueMode( LogQueueMode::perThread );
+      LOG_INFO( "In a thread ring" );
+      raise( SIGSEGV );
+      _exit( 0 );  // We shouldn't get here
+   }
+
+   int status = 0;
+   BOOST_REQUIRE_EQUAL( waitpid( child, &status, 0 ), child );
+   BOOST_CHECK( WIFSIGNALED( status ) );
+   BOOST_CHECK_EQUAL( WTERMSIG( status ), SIGSEGV );
+
+   dump = readLogCrashDump( path );
+   BOOST_REQUIRE_EQUAL( dump.entries.size(), 4 );
+   BOOST_CHECK_EQUAL( dump.entries[ 3 ].msg, "In a thread ring" );
+
+   /// A stack overflow in another thread that has a ring is dumped on that
+   /// thread's own alternate stack
+   std::filesystem::remove( path );
+   const pid_t overflowed = fork();
+   BOOST_REQUIRE( overflowed >= 0 );
+   if( overflowed == 0 ) {
+      const rlimit noCore { 0, 0 };
+      setrlimit( RLIMIT_CORE, &noCore );
+      installLogCrashHandler( path );
+      setLogQueueMode( LogQueueMode::perThread );
+      std::thread( []() {
+         LOG_INFO( "Before the overflow" );
+         overflowTheStack( 0 );
+      } ).join();
+      _exit( 0 );  // We shouldn't get here
+   }
+
+   BOOST_REQUIRE_EQUAL( waitpid( overflowed, &status, 0 ), overflowed );
+   BOOST_CHECK( WIFSIGNALED( status ) );
+   BOOST_CHECK_EQUAL( WTERMSIG( status ), SIGSEGV );
+
+   dump = readLogCrashDump( path );
+   BOOST_REQUIRE( !dump.entries.empty() );
+   BOOST_CHECK_EQUAL( dump.entries.back().msg, "Before the overflow" );
+
+   std::filesystem::remove( path );
+   logReset();
+
+   BOOST_CHECK_THROW( installLogCrashHandler( "/no/such/directory/test.crash" ), std::system_error );
+   BOOST_CHECK_THROW( readLogCrashDump( "/no/such/directory/test.crash" ), std::system_error );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_structured ) {
+   logReset();
+
+   const int nation = 3;
+   const long x = 10;
+   const short y = -2;
+   LOG_INFO_KV( "sector moved", "nation", nation, "x", x, "y", y, "name", "Hawaii" );
+
+   const LogEntry& entry = logPeek();
+   BOOST_REQUIRE( entry.schema != nullptr );
+   BOOST_CHECK( entry.fmt == nullptr );
+   BOOST_CHECK_EQUAL( entry.schema->message, "sector moved" );
+   BOOST_REQUIRE_EQUAL( entry.schema->fieldCount, 4 );
+   BOOST_CHECK_EQUAL( entry.schema->keys[ 1 ], "x" );
+   BOOST_CHECK( entry.schema->types[ 0 ] == LogArgType::signedInt );
+   BOOST_CHECK( entry.schema->types[ 1 ] == LogArgType::signedLong );
+   BOOST_CHECK( entry.schema->types[ 2 ] == LogArgType::signedInt );  // `short` is promoted
+   BOOST_CHECK( entry.schema->types[ 3 ] == LogArgType::string );
+
+   char text[ LOG_MSG_LENGTH ] {};
+   formatLogKvText( entry, text, sizeof( text ) );
+   BOOST_CHECK_EQUAL( text, "sector moved nation=3 x=10 y=-2 name=\"Hawaii\"" );
+
+   char json[ LOG_STRUCTURED_LENGTH ] {};
+   const size_t length = formatLogEntryJson( entry, json, sizeof( json ) );
+   const std::string line( json, length );
+   BOOST_CHECK( line.starts_with( "{\"ts\":" ) );
+   BOOST_CHECK( line.ends_with( ",\"severity\":\"info\",\"module\":\"test_Log\",\"msg\":\"sector moved\""
+                                ",\"fields\":{\"nation\":3,\"x\":10,\"y\":-2,\"name\":\"Hawaii\"}}\n" ) );
+
+   /// Each call site has its own LogKvSchema
+   std::vector< const LogKvSchema* > schemas;
+   for( int i = 0 ; i < 2 ; i++ ) {
+      LOG_INFO_KV( "loop", "i", i );
+      schemas.push_back( logPeek().schema );
+   }
+   BOOST_CHECK( schemas[ 0 ] == schemas[ 1 ] );
+   BOOST_CHECK( schemas[ 0 ] != entry.schema );
+
+   /// A plain LogEntry has no schema
+   LOG_INFO( "Plain" );
+   BOOST_CHECK( logPeek().schema == nullptr );
+
+   /// Strings are escaped, NaN is null and fields that don't fit are missing
+   const std::string big( LOG_MSG_LENGTH - 8, 'x' );
+   LOG_WARN_KV( "odd \"values\"", "nan", std::nan( "" ), "big", big.c_str(), "after", 1 );
+   formatLogEntryJson( logPeek(), json, sizeof( json ) );
+   BOOST_CHECK( std::string( json ).find( "\"msg\":\"odd \\\"values\\\"\",\"fields\":{\"nan\":null,\"big\":null,\"after\":null}" ) != std::string::npos );
+   formatLogKvText( logPeek(), text, sizeof( text ) );
+   BOOST_CHECK_EQUAL( text, "odd \"values\" nan=nan big=? after=?" );
+
+   /// expandLogKvEntry() makes it plain
+   LogEntry copy = logPeek();
+   expandLogKvEntry( copy );
+   BOOST_CHECK( copy.schema == nullptr );
+   BOOST_CHECK_EQUAL( copy.msg, "odd \"values\" nan=nan big=? after=?" );
+
+   /// So is infinity, even when the build assumes there are none (`-Ofast`)
+   LOG_INFO_KV( "Limits", "low", -std::numeric_limits< double >::infinity(), "high", 1.5 );
+   formatLogEntryJson( logPeek(), json, sizeof( json ) );
+   BOOST_CHECK( std::string( json ).find( "\"fields\":{\"low\":null,\"high\":1.5}" ) != std::string::npos );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_query ) {
+   logReset();
+
+   LOG_DEBUG( "Sector 1,1 mined" );
+   LOG_INFO( "Nation %d joined", 4 );
+   LOG_WARN( "Sector %d,%d has plague", 2, 3 );
+   LOG_ERROR( "Nation %d bankrupt", 5 );
+   LOG_INFO_KV( "ship built", "nation", 4, "type", "frigate" );
+
+   BOOST_CHECK_EQUAL( queryLog( {} ).size(), 5 );
+
+   /// Severity range
+   std::vector< LogEntry > found = queryLog( { .minSeverity = LogSeverity::info, .maxSeverity = LogSeverity::warning } );
+   BOOST_REQUIRE_EQUAL( found.size(), 3 );
+   BOOST_CHECK_EQUAL( found[ 0 ].msg, "Nation 4 joined" );  // Deferred arguments are expanded
+   BOOST_CHECK_EQUAL( found[ 1 ].msg, "Sector 2,3 has plague" );
+   BOOST_CHECK( found[ 2 ].schema != nullptr );
+
+   /// Substring (a structured LogEntry matches its text form)
+   found = queryLog( { .contains = "Nation" } );
+   BOOST_REQUIRE_EQUAL( found.size(), 2 );
+   BOOST_CHECK_EQUAL( found[ 1 ].msg, "Nation 5 bankrupt" );
+   BOOST_CHECK_EQUAL( queryLog( { .contains = "type=\"frigate\"" } ).size(), 1 );
+   BOOST_CHECK( queryLog( { .contains = "nothing like this" } ).empty() );
+
+   /// Module
+   BOOST_CHECK_EQUAL( queryLog( { .module = "test_Log" } ).size(), 5 );
+   BOOST_CHECK( queryLog( { .module = "LogConsumer" } ).empty() );
+
+   /// Time window (the timestamps are wall-clock nanoseconds)
+   found = queryLog( {} );
+   BOOST_CHECK_GE( found[ 0 ].logTimestamp, 1'600'000'000ULL * 1'000'000'000ULL );
+   BOOST_CHECK_EQUAL( queryLog( { .sinceNs = found[ 2 ].logTimestamp } ).size(), 3 );
+   BOOST_CHECK_EQUAL( queryLog( { .untilNs = found[ 1 ].logTimestamp } ).size(), 2 );
+
+   /// Limit keeps the newest
+   found = queryLog( { .limit = 2 } );
+   BOOST_REQUIRE_EQUAL( found.size(), 2 );
+   BOOST_CHECK_EQUAL( found[ 0 ].msg, "Nation 5 bankrupt" );
+
+   /// Producers keep going while the ring is searched
+   std::atomic< bool > done { false };
+   std::thread producer( [ &done ]() {
+      for( size_t n = 0 ; n < 4 * SIZE_OF_QUEUE ; n++ ) {
+         LOG_TEST( "Busy %zu", n );
+      }
+      done.store( true );
+   } );
+   size_t checked = 0;
+   while( !done.load() || checked == 0 ) {
+      for( const LogEntry& entry : queryLog( { .maxSeverity = LogSeverity::test, .contains = "Busy" } ) ) {
+         unsigned long n = 0;
+         BOOST_REQUIRE_EQUAL( sscanf( entry.msg, "Busy %lu", &n ), 1 );  // A LogEntry is never torn
+         checked++;
+      }
+   }
+   producer.join();
+   BOOST_CHECK_GT( checked, 0 );
+
+   logReset();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
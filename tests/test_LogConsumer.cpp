@@ -0,0 +1,796 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Test the LogConsumer thread and its LogSink objects
+///
+/// @file      tests/test_LogConsumer.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+/// @cond Suppress Doxygen warnings
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Tests will have magic numbers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+
+#include <boost/test/unit_test.hpp>
+#include <zlib.h>  // For gzopen() gzread() gzclose()
+
+#include <array>       // For array<>
+#include <atomic>      // For atomic<>
+#include <chrono>      // For milliseconds
+#include <cstddef>     // For offsetof()
+#include <cstdint>     // For uint8_t uint16_t uint32_t uint64_t
+#include <cstdio>      // For sscanf()
+#include <filesystem>  // For temp_directory_path()
+#include <fstream>     // For ifstream ofstream fstream
+#include <iterator>    // For istreambuf_iterator<>
+#include <memory>      // For make_unique<>()
+#include <span>        // For span<>
+#include <sstream>     // For ostringstream
+#include <string>      // For string getline()
+#include <thread>      // For thread sleep_for()
+#include <utility>     // For pair<>
+
+#include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "test_LogConsumer" };
+
+/// Logs at and above `MIN_LOG_SEVERITY` will be available.  Logs below
+/// `MIN_LOG_SEVERITY` will not be compiled into the source file.
+#define MIN_LOG_SEVERITY LOG_SEVERITY_TEST
+#include "../src/lib/Log.hpp"
+
+#include "../src/lib/LogClock.hpp"   // For NS_PER_SECOND
+#include "../src/lib/LogConsumer.hpp"
+#include "../src/lib/LogSinkConsole.hpp"
+#include "../src/lib/LogSinkFile.hpp"
+#include "../src/lib/LogSinkMapped.hpp"
+#include "../src/lib/LogSinkMemory.hpp"
+#include "../src/lib/LogSinkRotatingFile.hpp"
+#include "../src/lib/LogSinkStructured.hpp"
+
+
+/* ****************************************************************************
+   White Box Test Declarations
+
+   These declarations may contain duplicate code or code that needs to be in
+   sync with the code under test.  Because these are white box tests, it's on
+   the tester to ensure the code is in sync.                                 */
+
+namespace empire {
+   extern void logReset();
+} // namespace empire
+
+/* ***************************************************************************/
+
+
+using namespace empire;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE( LogConsumer_suite )
+
+BOOST_AUTO_TEST_CASE( LogConsumer_memory_sink ) {
+   logReset();
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >() ) );
+   consumer.restart();
+   BOOST_CHECK( consumer.isRunning() );
+
+   for( int i = 0 ; i < 100 ; i++ ) {
+      LOG_TEST( "Consumer entry %d", i );
+   }
+   consumer.sync();
+   const uint64_t now = logReadClockNs( CLOCK_REALTIME );
+
+   BOOST_CHECK_EQUAL( consumer.getConsumerIndex(), 100 );
+   const vector< LogEntry > entries = memory.getEntries();
+   BOOST_REQUIRE_EQUAL( entries.size(), 100 );
+   for( size_t i = 0 ; i < entries.size() ; i++ ) {
+      BOOST_CHECK_EQUAL( entries[ i ].msg, "Consumer entry " + to_string( i ) );
+      BOOST_CHECK_EQUAL( logModuleName( entries[ i ].moduleId ), "test_LogConsumer" );
+      BOOST_CHECK_EQUAL( entries[ i ].logSeverity, LogSeverity::test );
+
+      /// The LogConsumer converted the timestamps to wall-clock nanoseconds
+      BOOST_CHECK_LE( entries[ i ].logTimestamp, now + 5'000'000 );
+      BOOST_CHECK_GE( entries[ i ].logTimestamp, now - 1'000'000'000 );
+      if( i > 0 ) {
+         BOOST_CHECK_GE( entries[ i ].logTimestamp, entries[ i - 1 ].logTimestamp );
+      }
+   }
+
+   consumer.stop();
+   BOOST_CHECK( !consumer.isRunning() );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_picks_up_where_it_left_off ) {
+   logReset();
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >() ) );
+   consumer.restart();
+   LOG_TEST( "Before the restart" );
+   consumer.sync();
+   consumer.stop();
+
+   LOG_TEST( "While it was stopped" );
+   consumer.restart();
+   LOG_TEST( "After the restart" );
+   consumer.sync();
+
+   const vector< LogEntry > entries = memory.getEntries();
+   BOOST_REQUIRE_EQUAL( entries.size(), 3 );
+   BOOST_CHECK_EQUAL( entries[ 0 ].msg, "Before the restart" );
+   BOOST_CHECK_EQUAL( entries[ 1 ].msg, "While it was stopped" );
+   BOOST_CHECK_EQUAL( entries[ 2 ].msg, "After the restart" );
+}
+
+
+/// A consumer that restarts behind a lapped queue skips the LogEntry records
+/// that are gone.  They aren't drops:  It wasn't running.
+BOOST_AUTO_TEST_CASE( LogConsumer_restart_behind_a_lapped_queue ) {
+   logReset();
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( SIZE_OF_QUEUE + 1 ) ) );
+   consumer.restart();
+   LOG_TEST( "Before the restart" );
+   consumer.sync();
+   consumer.stop();
+
+   for( size_t i = 0 ; i < SIZE_OF_QUEUE * 2 ; i++ ) {
+      LOG_TEST( "While it was stopped %zu", i );
+   }
+   consumer.restart();
+   consumer.sync();
+
+   BOOST_CHECK_EQUAL( consumer.getDroppedCount(), 0 );
+   BOOST_CHECK_EQUAL( memory.size(), 1 + SIZE_OF_QUEUE );
+   BOOST_CHECK_EQUAL( memory.getEntries().back().msg, "While it was stopped " + to_string( SIZE_OF_QUEUE * 2 - 1 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_several_consumers ) {
+   logReset();
+
+   LogConsumer consumer1;
+   LogConsumer consumer2;
+   auto& memory1 = dynamic_cast< LogSinkMemory& >( consumer1.addSink( make_unique< LogSinkMemory >() ) );
+   auto& memory2 = dynamic_cast< LogSinkMemory& >( consumer2.addSink( make_unique< LogSinkMemory >() ) );
+   consumer1.restart();
+   consumer2.restart();
+
+   for( int i = 0 ; i < 50 ; i++ ) {
+      LOG_TEST( "Shared entry %d", i );
+   }
+   consumer1.sync();
+   consumer2.sync();
+
+   BOOST_CHECK_EQUAL( memory1.size(), 50 );
+   BOOST_CHECK_EQUAL( memory2.size(), 50 );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_too_many_consumers ) {
+   array< LogConsumer, MAX_LOG_CONSUMERS > consumers;
+   for( LogConsumer& consumer : consumers ) {
+      consumer.restart();
+   }
+
+   LogConsumer oneTooMany;
+   BOOST_CHECK_THROW( oneTooMany.restart(), std::range_error );
+   BOOST_CHECK( !oneTooMany.isRunning() );
+
+   consumers[ 0 ].stop();
+   BOOST_CHECK_NO_THROW( oneTooMany.restart() );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_memory_sink_capacity ) {
+   logReset();
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 10 ) ) );
+   consumer.restart();
+
+   for( int i = 0 ; i < 20 ; i++ ) {
+      LOG_TEST( "Capacity entry %d", i );
+   }
+   consumer.sync();
+
+   const vector< LogEntry > entries = memory.getEntries();
+   BOOST_REQUIRE_EQUAL( entries.size(), 10 );
+   BOOST_CHECK_EQUAL( entries.front().msg, "Capacity entry 10" );
+   BOOST_CHECK_EQUAL( entries.back().msg, "Capacity entry 19" );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_console_sink ) {
+   logReset();
+
+   ostringstream console;
+   {
+      LogConsumer consumer;
+      consumer.addSink( make_unique< LogSinkConsole >( console ) );
+      consumer.restart();
+      LOG_TEST( "To the console %d", 1 );
+      consumer.sync();
+   }
+
+   BOOST_CHECK_NE( console.str().find( " test    test_LogConsumer: To the console 1\n" ), string::npos );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_file_sink ) {
+   logReset();
+
+   const filesystem::path path = filesystem::temp_directory_path() / "test_LogConsumer.log";
+   filesystem::remove( path );
+
+   {
+      LogConsumer consumer;
+      consumer.addSink( make_unique< LogSinkFile >( path ) );
+      consumer.restart();
+      LOG_TEST( "To a file %d", 1 );
+      LOG_TEST( "To a file %d", 2 );
+   }  // The LogConsumer drains and flushes when it's destroyed
+
+   ifstream file( path );
+   string line;
+   BOOST_REQUIRE( getline( file, line ) );
+   BOOST_CHECK( line.ends_with( "test_LogConsumer: To a file 1" ) );
+   BOOST_REQUIRE( getline( file, line ) );
+   BOOST_CHECK( line.ends_with( "test_LogConsumer: To a file 2" ) );
+   BOOST_CHECK( !getline( file, line ) );
+
+   filesystem::remove( path );
+
+   BOOST_CHECK_THROW( LogSinkFile( "/no/such/directory/test.log" ), std::system_error );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_structured_sink ) {
+   logReset();
+
+   const filesystem::path jsonPath = filesystem::temp_directory_path() / "test_LogConsumer.jsonl";
+   const filesystem::path binaryPath = filesystem::temp_directory_path() / "test_LogConsumer.bin";
+   filesystem::remove( jsonPath );
+   filesystem::remove( binaryPath );
+
+   {
+      LogConsumer consumer;
+      consumer.addSink( make_unique< LogSinkStructured >( jsonPath, LogStructuredFormat::jsonLines ) );
+      consumer.addSink( make_unique< LogSinkStructured >( binaryPath, LogStructuredFormat::binary ) );
+      auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >() ) );
+      consumer.restart();
+      LOG_INFO_KV( "sector moved", "nation", 3, "x", 2.5 );
+      LOG_TEST( "Plain %d", 2 );
+      consumer.sync();
+
+      /// A text sink sees the fields as text
+      array< char, LOG_LINE_LENGTH > line {};
+      formatLogEntry( memory.getEntries().front(), line.data(), line.size() );
+      BOOST_CHECK( string( line.data() ).ends_with( "test_LogConsumer: sector moved nation=3 x=2.5\n" ) );
+   }
+
+   ifstream json( jsonPath );
+   string line;
+   BOOST_REQUIRE( getline( json, line ) );
+   BOOST_CHECK( line.ends_with( "\"severity\":\"info\",\"module\":\"test_LogConsumer\",\"msg\":\"sector moved\",\"fields\":{\"nation\":3,\"x\":2.5}}" ) );
+   BOOST_REQUIRE( getline( json, line ) );
+   BOOST_CHECK( line.ends_with( "\"severity\":\"test\",\"module\":\"test_LogConsumer\",\"msg\":\"Plain 2\"}" ) );
+   BOOST_CHECK( !getline( json, line ) );
+
+   ifstream binaryFile( binaryPath, ios::binary );
+   const string binary { istreambuf_iterator< char >( binaryFile ), istreambuf_iterator< char >() };
+
+   /// Walk through the first record
+   size_t offset = 0;
+   auto get = [ & ]< typename T >( T value ) {
+      BOOST_REQUIRE( offset + sizeof( T ) <= binary.size() );
+      memcpy( &value, binary.data() + offset, sizeof( T ) );
+      offset += sizeof( T );
+      return value;
+   };
+   auto getString = [ & ]() {
+      const auto length = get( uint16_t {} );
+      BOOST_REQUIRE( offset + length <= binary.size() );
+      const string str = binary.substr( offset, length );
+      offset += length;
+      return str;
+   };
+
+   const auto length = get( uint32_t {} );
+   BOOST_CHECK_GT( get( uint64_t {} ), 0 );
+   BOOST_CHECK_EQUAL( get( uint8_t {} ), static_cast< uint8_t >( LogSeverity::info ) );
+   BOOST_CHECK_EQUAL( get( uint8_t {} ), 2 );
+   BOOST_CHECK_EQUAL( getString(), "test_LogConsumer" );
+   BOOST_CHECK_EQUAL( getString(), "sector moved" );
+   BOOST_CHECK_EQUAL( getString(), "nation" );
+   BOOST_CHECK( get( LogArgType {} ) == LogArgType::signedInt );
+   BOOST_CHECK_EQUAL( get( int {} ), 3 );
+   BOOST_CHECK_EQUAL( getString(), "x" );
+   BOOST_CHECK( get( LogArgType {} ) == LogArgType::floatingPoint );
+   BOOST_CHECK_EQUAL( get( double {} ), 2.5 );
+   BOOST_CHECK_EQUAL( offset, length );
+
+   /// The second record is plain
+   offset += sizeof( uint32_t ) + sizeof( uint64_t ) + sizeof( uint8_t );
+   BOOST_CHECK_EQUAL( get( uint8_t {} ), 0 );
+   BOOST_CHECK_EQUAL( getString(), "test_LogConsumer" );
+   BOOST_CHECK_EQUAL( getString(), "Plain 2" );
+   BOOST_CHECK_EQUAL( offset, binary.size() );
+
+   filesystem::remove( jsonPath );
+   filesystem::remove( binaryPath );
+
+   BOOST_CHECK_THROW( LogSinkStructured( "/no/such/directory/test.jsonl", LogStructuredFormat::jsonLines ), std::system_error );
+}
+
+
+/// Read a file compressed by LogSinkRotatingFile
+///
+/// @param path The `.gz` file
+/// @return Its uncompressed contents
+static string readCompressed( const filesystem::path& path ) {
+   gzFile file = gzopen( path.c_str(), "rb" );
+   BOOST_REQUIRE( file != nullptr );
+   string contents;
+   array< char, 256 > buffer {};
+   int length = 0;
+   while( ( length = gzread( file, buffer.data(), buffer.size() ) ) > 0 ) {
+      contents.append( buffer.data(), static_cast< size_t >( length ) );
+   }
+   gzclose( file );
+   return contents;
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_rotating_file_sink ) {
+   const filesystem::path directory = filesystem::temp_directory_path() / "test_LogConsumer_rotate";
+   filesystem::remove_all( directory );
+   filesystem::create_directory( directory );
+   const filesystem::path path = directory / "empire.log";
+
+   LogEntry entry {};
+   entry.moduleId = registerLogModule( "test_rotate" );
+   entry.logSeverity = LogSeverity::info;
+   entry.logTimestamp = NS_PER_SECOND;
+
+   /// Write one LogEntry with a message of `Entry n`
+   auto writeEntry = [ &entry ]( LogSinkRotatingFile& sink, const int n ) {
+      snprintf( entry.msg, sizeof( entry.msg ), "Entry %d", n );
+      sink.write( span( &entry, 1 ) );
+      sink.flush();
+   };
+
+   /// Rotate by size:  Each line is 59 bytes, so only one fits in a file
+   {
+      LogSinkRotatingFile sink( path, 100, 0, 3 );
+      for( int n = 1 ; n <= 5 ; n++ ) {
+         writeEntry( sink, n );
+      }
+      sink.waitForCompression();
+   }
+
+   BOOST_CHECK( !filesystem::exists( directory / "empire.log.1.gz" ) );  // Pruned
+   for( int n = 2 ; n <= 4 ; n++ ) {
+      const filesystem::path segment = directory / ( "empire.log." + to_string( n ) );
+      BOOST_CHECK( !filesystem::exists( segment ) );
+      BOOST_REQUIRE( filesystem::exists( segment.string() + ".gz" ) );
+      BOOST_CHECK( readCompressed( segment.string() + ".gz" ).ends_with( "test_rotate: Entry " + to_string( n ) + "\n" ) );
+   }
+   {
+      ifstream file( path );
+      string line;
+      BOOST_REQUIRE( getline( file, line ) );
+      BOOST_CHECK( line.ends_with( "test_rotate: Entry 5" ) );
+      BOOST_CHECK( !getline( file, line ) );
+   }
+
+   /// A closed file left uncompressed is compressed when the sink is
+   /// reopened.  The numbers carry on from there.
+   filesystem::rename( path, directory / "empire.log.5" );
+   {
+      LogSinkRotatingFile sink( path, 0, 10, 10 );
+      sink.waitForCompression();
+      BOOST_CHECK( filesystem::exists( directory / "empire.log.5.gz" ) );
+
+      /// Rotate by time:  The third LogEntry is 11 seconds after the first
+      writeEntry( sink, 6 );
+      entry.logTimestamp = 5 * NS_PER_SECOND;
+      writeEntry( sink, 7 );
+      entry.logTimestamp = 12 * NS_PER_SECOND;
+      writeEntry( sink, 8 );
+      sink.waitForCompression();
+
+      const string segment = readCompressed( directory / "empire.log.6.gz" );
+      BOOST_CHECK_NE( segment.find( "test_rotate: Entry 6\n" ), string::npos );
+      BOOST_CHECK_NE( segment.find( "test_rotate: Entry 7\n" ), string::npos );
+      BOOST_CHECK_EQUAL( segment.find( "test_rotate: Entry 8\n" ), string::npos );
+   }
+
+   filesystem::remove_all( directory );
+
+   BOOST_CHECK_THROW( LogSinkRotatingFile( "/no/such/directory/test.log" ), std::system_error );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_mapped_sink ) {
+   logReset();
+
+   const filesystem::path path = filesystem::temp_directory_path() / "test_LogConsumer.elog";
+   filesystem::remove( path );
+
+   {
+      LogConsumer consumer;
+      auto& mapped = dynamic_cast< LogSinkMapped& >( consumer.addSink( make_unique< LogSinkMapped >( path, 16 ) ) );
+      consumer.restart();
+      LOG_TEST( "Mapped %d", 1 );
+      LOG_WARN( "Mapped %d", 2 );
+      consumer.sync();
+      BOOST_CHECK_EQUAL( mapped.getCapacity(), 16 );
+      BOOST_CHECK_EQUAL( mapped.getNextSequence(), 2 );
+
+      /// Only one LogSinkMapped can have the file
+      BOOST_CHECK_THROW( LogSinkMapped( path, 16 ), std::system_error );
+   }
+   BOOST_CHECK_EQUAL( filesystem::file_size( path ), LOG_MAPPED_HEADER_SIZE + 16 * sizeof( LogEntry ) );
+
+   LogMappedFile file = readLogMappedFile( path );
+   BOOST_REQUIRE_EQUAL( file.entries.size(), 2 );
+   BOOST_CHECK_EQUAL( file.entries[ 0 ].msg, "Mapped 1" );
+   BOOST_CHECK_EQUAL( file.entries[ 1 ].msg, "Mapped 2" );
+   BOOST_CHECK_EQUAL( file.entries[ 1 ].logSeverity, LogSeverity::warning );
+   BOOST_CHECK_EQUAL( file.moduleName( file.entries[ 0 ].moduleId ), "test_LogConsumer" );
+   BOOST_CHECK_GT( file.entries[ 1 ].logTimestamp, NS_PER_SECOND );
+
+   /// Reopen it (with a different capacity) and wrap around
+   logReset();
+   {
+      LogConsumer consumer;
+      auto& mapped = dynamic_cast< LogSinkMapped& >( consumer.addSink( make_unique< LogSinkMapped >( path, 1000 ) ) );
+      BOOST_CHECK_EQUAL( mapped.getCapacity(), 16 );
+      BOOST_CHECK_EQUAL( mapped.getNextSequence(), 2 );
+      consumer.restart();
+      for( int i = 3 ; i <= 20 ; i++ ) {
+         LOG_TEST( "Mapped %d", i );
+      }
+   }
+
+   file = readLogMappedFile( path );
+   BOOST_REQUIRE_EQUAL( file.entries.size(), 16 );
+   BOOST_CHECK_EQUAL( file.entries.front().msg, "Mapped 5" );
+   BOOST_CHECK_EQUAL( file.entries.back().msg, "Mapped 20" );
+   BOOST_CHECK_EQUAL( file.entries.back().sequence, 19 );
+
+   /// A record that was half written when the writer crashed is skipped and
+   /// the writer carries on after the newest good record
+   {
+      fstream raw( path, ios::in | ios::out | ios::binary );
+      const size_t slot = 19 % 16;
+      raw.seekp( static_cast< streamoff >( LOG_MAPPED_HEADER_SIZE + slot * sizeof( LogEntry ) + offsetof( LogEntry, ready ) ) );
+      raw.put( 0 );
+   }
+   file = readLogMappedFile( path );
+   BOOST_REQUIRE_EQUAL( file.entries.size(), 15 );
+   BOOST_CHECK_EQUAL( file.entries.back().msg, "Mapped 19" );
+   BOOST_CHECK_EQUAL( LogSinkMapped( path ).getNextSequence(), 19 );
+
+   filesystem::remove( path );
+
+   /// Only LogSinkMapped files are accepted
+   const filesystem::path textPath = filesystem::temp_directory_path() / "test_LogConsumer.txt";
+   {
+      ofstream text( textPath );
+      text << string( LOG_MAPPED_HEADER_SIZE + sizeof( LogEntry ), 'x' );
+   }
+   BOOST_CHECK_THROW( readLogMappedFile( textPath ), std::system_error );
+   BOOST_CHECK_THROW( LogSinkMapped( textPath, 16 ), std::system_error );
+
+   /// ...and other files are left just as they were
+   const auto checkUntouched = [ & ]( const string& contents ) {
+      {
+         ofstream text( textPath, ios::binary | ios::trunc );
+         text << contents;
+      }
+      BOOST_CHECK_THROW( LogSinkMapped( textPath, 16 ), std::system_error );
+      ifstream text( textPath, ios::binary );
+      BOOST_CHECK( string( istreambuf_iterator< char >( text ), {} ) == contents );
+   };
+   checkUntouched( "A small file" );
+   checkUntouched( string( LOG_MAPPED_HEADER_SIZE + 2 * sizeof( LogEntry ), '\0' ) );
+
+   /// An empty file is a new log file
+   {
+      ofstream text( textPath, ios::trunc );
+   }
+   BOOST_CHECK_EQUAL( LogSinkMapped( textPath, 16 ).getCapacity(), 16 );
+
+   /// So is a file that was sized, but never got its header
+   {
+      ofstream text( textPath, ios::binary | ios::trunc );
+      text << string( LOG_MAPPED_HEADER_SIZE + 16 * sizeof( LogEntry ), '\0' );
+   }
+   {
+      LogSinkMapped recovered( textPath, 16 );
+      BOOST_CHECK_EQUAL( recovered.getCapacity(), 16 );
+   }
+   BOOST_CHECK_EQUAL( readLogMappedFile( textPath ).entries.size(), 0 );
+   filesystem::remove( textPath );
+
+   BOOST_CHECK_THROW( readLogMappedFile( "/no/such/file.elog" ), std::system_error );
+}
+
+
+/// A LogSink that holds up its LogConsumer until it's opened
+class GateSink final : public LogSink {
+public:
+   void write( [[maybe_unused]] std::span< const LogEntry > batch ) override {
+      m_open.wait( false );
+   }
+
+   void open() {
+      m_open.store( true );
+      m_open.notify_all();
+   }
+
+private:
+   std::atomic< bool > m_open { false };
+};
+
+
+/// Count the real LogEntry records and the ones that report drops
+///
+/// @param entries The LogEntry records from a LogSinkMemory
+/// @return The number of real LogEntry records and the dropped count the
+///         LogConsumer reported in its `warning` LogEntry records
+static pair< size_t, size_t > countEntries( const vector< LogEntry >& entries ) {
+   size_t real = 0;
+   size_t dropped = 0;
+   for( const LogEntry& entry : entries ) {
+      size_t count = 0;
+      if( sscanf( entry.msg, "Dropped %zu log entries", &count ) == 1 ) {
+         dropped += count;
+      } else {
+         real += 1;
+      }
+   }
+   return { real, dropped };
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_sequence ) {
+   logReset();
+
+   for( size_t i = 0 ; i < SIZE_OF_QUEUE * 3 ; i++ ) {
+      LOG_TEST( "Sequence %zu", i );
+      BOOST_CHECK_EQUAL( logEntryAt( i ).sequence, i );
+   }
+}
+
+
+/// The overrun tests log this many LogEntry records while the LogConsumer is
+/// stuck, so they overrun empire::LogQueue whatever its size
+static constinit const size_t OVERRUN { SIZE_OF_QUEUE + 172 };
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_drop_oldest ) {
+   logReset();
+   setLogOverrunPolicy( LogOverrunPolicy::dropOldest );
+
+   LogConsumer consumer;
+   auto& gate = dynamic_cast< GateSink& >( consumer.addSink( make_unique< GateSink >() ) );
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 2 * OVERRUN ) ) );
+   consumer.restart();
+
+   LOG_TEST( "The consumer gets stuck on this one" );
+   this_thread::sleep_for( 50ms );
+
+   for( size_t i = 0 ; i < OVERRUN ; i++ ) {
+      LOG_TEST( "Lapping entry %zu", i );
+   }
+   gate.open();
+   consumer.sync();
+
+   const auto [ real, reported ] = countEntries( memory.getEntries() );
+   BOOST_CHECK_EQUAL( real + consumer.getDroppedCount(), OVERRUN + 1 );
+   BOOST_CHECK_EQUAL( reported, consumer.getDroppedCount() );
+   BOOST_CHECK_EQUAL( consumer.getDroppedCount(), OVERRUN - SIZE_OF_QUEUE );
+   BOOST_CHECK_EQUAL( memory.getEntries().back().msg, "Lapping entry " + to_string( OVERRUN - 1 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_drop_newest ) {
+   logReset();
+   setLogOverrunPolicy( LogOverrunPolicy::dropNewest );
+
+   LogConsumer consumer;
+   auto& gate = dynamic_cast< GateSink& >( consumer.addSink( make_unique< GateSink >() ) );
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 2 * OVERRUN ) ) );
+   consumer.restart();
+
+   LOG_TEST( "The consumer gets stuck on this one" );
+   this_thread::sleep_for( 50ms );
+
+   for( size_t i = 0 ; i < OVERRUN ; i++ ) {
+      LOG_TEST( "Newest entry %zu", i );
+   }
+   BOOST_CHECK_EQUAL( logDroppedCount(), OVERRUN - SIZE_OF_QUEUE );
+
+   gate.open();
+   consumer.sync();
+
+   const auto [ real, reported ] = countEntries( memory.getEntries() );
+   BOOST_CHECK_EQUAL( real, 1 + SIZE_OF_QUEUE );
+   BOOST_CHECK_EQUAL( reported, OVERRUN - SIZE_OF_QUEUE );
+   BOOST_CHECK_EQUAL( consumer.getDroppedCount(), OVERRUN - SIZE_OF_QUEUE );
+   BOOST_CHECK_EQUAL( memory.getEntries()[ SIZE_OF_QUEUE ].msg, "Newest entry " + to_string( SIZE_OF_QUEUE - 1 ) );
+
+   setLogOverrunPolicy( DEFAULT_LOG_OVERRUN_POLICY );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_block ) {
+   logReset();
+   setLogOverrunPolicy( LogOverrunPolicy::block );
+
+   LogConsumer consumer;
+   auto& gate = dynamic_cast< GateSink& >( consumer.addSink( make_unique< GateSink >() ) );
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 2 * OVERRUN ) ) );
+   consumer.restart();
+
+   LOG_TEST( "The consumer gets stuck on this one" );
+   this_thread::sleep_for( 50ms );
+
+   std::atomic< size_t > produced { 0 };
+   std::thread producer( [ &produced ]() {
+      for( size_t i = 0 ; i < OVERRUN ; i++ ) {
+         LOG_TEST( "Blocking entry %zu", i );
+         produced.fetch_add( 1 );
+      }
+   } );
+
+   for( int tries = 0 ; produced.load() < SIZE_OF_QUEUE && tries < 500 ; tries++ ) {
+      this_thread::sleep_for( 10ms );
+   }
+   this_thread::sleep_for( 50ms );
+   BOOST_CHECK_EQUAL( produced.load(), SIZE_OF_QUEUE );  // The producer is blocked
+
+   gate.open();
+   producer.join();
+   consumer.sync();
+
+   const auto [ real, reported ] = countEntries( memory.getEntries() );
+   BOOST_CHECK_EQUAL( real, OVERRUN + 1 );
+   BOOST_CHECK_EQUAL( reported, 0 );
+   BOOST_CHECK_EQUAL( consumer.getDroppedCount(), 0 );
+
+   setLogOverrunPolicy( DEFAULT_LOG_OVERRUN_POLICY );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_per_thread_rings ) {
+   logReset();
+   setLogQueueMode( LogQueueMode::perThread );
+
+   /// Write everything before the LogConsumer starts, so it can merge all of
+   /// it.  The producers hang on to their rings until it's done.
+   const size_t producers = 8;
+   const size_t entriesPerProducer = SIZE_OF_THREAD_RING / 2;
+   atomic< size_t > finished { 0 };
+   atomic< bool > release { false };
+   vector< thread > threads;
+   for( size_t t = 0 ; t < producers ; t++ ) {
+      threads.emplace_back( [ t, &finished, &release ]() {
+         for( size_t n = 0 ; n < entriesPerProducer ; n++ ) {
+            LOG_TEST( "Ring t=%zu n=%zu", t, n );
+         }
+         finished.fetch_add( 1 );
+         while( !release.load() ) {
+            this_thread::yield();
+         }
+      } );
+   }
+   while( finished.load() < producers ) {
+      this_thread::yield();
+   }
+   BOOST_CHECK_EQUAL( logHead(), 0 );  // Nothing went through LogIndex
+   BOOST_CHECK_GE( logThreadRingCount(), producers );
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 1000 ) ) );
+   consumer.restart();
+   consumer.sync();
+
+   release.store( true );
+   for( thread& producer : threads ) {
+      producer.join();
+   }
+
+   const vector< LogEntry > entries = memory.getEntries();
+   BOOST_REQUIRE_EQUAL( entries.size(), producers * entriesPerProducer );
+
+   vector< long > last( producers, -1 );
+   for( size_t i = 0 ; i < entries.size() ; i++ ) {
+      size_t t = 0;
+      long n = 0;
+      BOOST_REQUIRE_EQUAL( sscanf( entries[ i ].msg, "Ring t=%zu n=%ld", &t, &n ), 2 );
+      BOOST_REQUIRE_LT( t, producers );
+      BOOST_CHECK_EQUAL( n, last[ t ] + 1 );
+      last[ t ] = n;
+
+      if( i > 0 ) {
+         BOOST_CHECK_LE( entries[ i - 1 ].logTimestamp, entries[ i ].logTimestamp );
+      }
+   }
+
+   /// A thread that exits gives its ring back, so these reuse the same rings
+   const size_t rings = logThreadRingCount();
+   for( size_t t = 0 ; t < 3 ; t++ ) {
+      thread( []() { LOG_TEST( "Reused" ); } ).join();
+   }
+   BOOST_CHECK_EQUAL( logThreadRingCount(), rings );
+
+   consumer.sync();
+   BOOST_CHECK_EQUAL( memory.getEntries().size(), producers * entriesPerProducer + 3 );
+
+   setLogQueueMode( DEFAULT_LOG_QUEUE_MODE );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_per_thread_rings_drop_oldest ) {
+   logReset();
+   setLogQueueMode( LogQueueMode::perThread );
+   setLogOverrunPolicy( LogOverrunPolicy::dropOldest );
+
+   LogConsumer consumer;
+   auto& gate = dynamic_cast< GateSink& >( consumer.addSink( make_unique< GateSink >() ) );
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( make_unique< LogSinkMemory >( 1000 ) ) );
+   consumer.restart();
+
+   LOG_TEST( "The consumer gets stuck on this one" );
+   this_thread::sleep_for( 50ms );
+
+   for( int i = 0 ; i < 300 ; i++ ) {
+      LOG_TEST( "Lapping entry %d", i );
+   }
+   gate.open();
+   consumer.sync();
+
+   const auto [ real, reported ] = countEntries( memory.getEntries() );
+   BOOST_CHECK_EQUAL( real + consumer.getDroppedCount(), 301 );
+   BOOST_CHECK_EQUAL( reported, consumer.getDroppedCount() );
+   BOOST_CHECK_EQUAL( consumer.getDroppedCount(), 301 - 1 - SIZE_OF_THREAD_RING );
+   BOOST_CHECK_EQUAL( memory.getEntries().back().msg, "Lapping entry 299" );
+
+   setLogQueueMode( DEFAULT_LOG_QUEUE_MODE );
+}
+
+
+BOOST_AUTO_TEST_CASE( LogConsumer_formatLogEntry ) {
+   LogEntry entry {};
+   strcpy( entry.msg, "Formatted" );
+   entry.moduleId = registerLogModule( "test_format" );
+   entry.logSeverity = LogSeverity::warning;
+   entry.logTimestamp = 0;
+
+   array< char, LOG_LINE_LENGTH > line {};
+   const size_t length = formatLogEntry( entry, line.data(), line.size() );
+   BOOST_CHECK_EQUAL( string( line.data(), length ), "1970-01-01 00:00:00.000000000 warning test_format: Formatted\n" );
+
+   array< char, 16 > shortLine {};
+   BOOST_CHECK_EQUAL( formatLogEntry( entry, shortLine.data(), shortLine.size() ), 15 );
+   BOOST_CHECK_EQUAL( shortLine.data(), "1970-01-01 00:\n" );
+
+   entry.logTimestamp = 86'400'123'456'789;
+   const size_t nsLength = formatLogEntry( entry, line.data(), line.size() );
+   BOOST_CHECK_EQUAL( string( line.data(), nsLength ), "1970-01-02 00:00:00.123456789 warning test_format: Formatted\n" );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+/// @endcond
@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Test deferred formatting (defining `LOG_DEFERRED`)
+///
+/// @file      tests/test_Log_deferred.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+/// @cond Suppress Doxygen warnings
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Tests will have magic numbers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): We use `char[]` arrays here
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>  // For int64_t uint8_t
+#include <cstring>  // For strcpy()
+#include <memory>   // For make_unique<>()
+#include <string>   // For string
+
+#include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "test_Log_deferred" };
+
+/// Logs at and above `MIN_LOG_SEVERITY` will be available.  Logs below
+/// `MIN_LOG_SEVERITY` will not be compiled into the source file.
+#define MIN_LOG_SEVERITY LOG_SEVERITY_TEST
+
+/// Let the LogConsumer format the LogEntry records from this module
+#define LOG_DEFERRED
+#include "../src/lib/Log.hpp"
+
+#include "../src/lib/LogConsumer.hpp"
+#include "../src/lib/LogSinkMemory.hpp"
+
+
+/* ****************************************************************************
+   White Box Test Declarations
+
+   These declarations may contain duplicate code or code that needs to be in
+   sync with the code under test.  Because these are white box tests, it's on
+   the tester to ensure the code is in sync.                                 */
+
+namespace empire {
+   extern void logReset();
+   extern LogEntry& logPeek();
+} // namespace empire
+
+/* ***************************************************************************/
+
+
+using namespace empire;
+
+/// Format the last LogEntry the way a LogConsumer would
+///
+/// @return The formatted message
+static std::string lastMessage() {
+   LogEntry copy = logPeek();
+   expandLogEntry( copy );
+   BOOST_CHECK( copy.fmt == nullptr );
+   return copy.msg;
+}
+
+
+BOOST_AUTO_TEST_SUITE( Log )
+
+BOOST_AUTO_TEST_CASE( Log_deferred_is_deferred ) {
+   logReset();
+   LOG_TEST( "Deferred entry with %d parameter", 1 );
+
+   const LogEntry& entry = logPeek();
+   BOOST_CHECK( entry.ready );
+   BOOST_CHECK( entry.fmt != nullptr );
+   BOOST_CHECK_EQUAL( logModuleName( entry.moduleId ), "test_Log_deferred" );
+   BOOST_CHECK_EQUAL( entry.msg[ 0 ], static_cast< char >( LogArgType::signedInt ) );
+
+   BOOST_CHECK_EQUAL( lastMessage(), "Deferred entry with 1 parameter" );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_deferred_types ) {
+   LOG_TEST( "No parameters and 100%% literal" );
+   BOOST_CHECK_EQUAL( lastMessage(), "No parameters and 100% literal" );
+
+   LOG_TEST( "[%d, %u, %ld, %zu]", -1, 2U, -3L, size_t { 4 } );
+   BOOST_CHECK_EQUAL( lastMessage(), "[-1, 2, -3, 4]" );
+
+   LOG_TEST( "[%lld, %llu, %x, %o]", -5LL, 6ULL, 255, 8 );
+   BOOST_CHECK_EQUAL( lastMessage(), "[-5, 6, ff, 10]" );
+
+   LOG_TEST( "[%06.3f, %.1f, %g, %.2Lf]", 3.0, 2.5F, 1e10, 1.25L );
+   BOOST_CHECK_EQUAL( lastMessage(), "[03.000, 2.5, 1e+10, 1.25]" );
+
+   LOG_TEST( "[%c, %d, %d, %hhd]", 'x', true, static_cast< uint8_t >( 200 ), 300 );
+   BOOST_CHECK_EQUAL( lastMessage(), "[x, 1, 200, 44]" );
+
+   LOG_TEST( "[%s] [%-6s] [%6s] [%.3s]", "one", "two", "six", "truncated" );
+   BOOST_CHECK_EQUAL( lastMessage(), "[one] [two   ] [   six] [tru]" );
+
+   LOG_TEST( "[%*d] [%-*d] [%.*f]", 4, 1, 3, 2, 1, 0.25 );
+   BOOST_CHECK_EQUAL( lastMessage(), "[   1] [2  ] [0.2]" );
+
+   LOG_TEST( "Severity %d", LogSeverity::warning );
+   BOOST_CHECK_EQUAL( lastMessage(), "Severity " + std::to_string( static_cast< int >( LogSeverity::warning ) ) );
+
+   const char* nullString = nullptr;
+   LOG_TEST( "Null %s", nullString );
+   BOOST_CHECK_EQUAL( lastMessage(), "Null (null)" );
+
+   int anInt = 0;
+   LOG_TEST( "Pointer %p", &anInt );
+   char expected[ LOG_MSG_LENGTH ] {};
+   snprintf( expected, sizeof( expected ), "Pointer %p", static_cast< void* >( &anInt ) );
+   BOOST_CHECK_EQUAL( lastMessage(), expected );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_deferred_copies_strings ) {
+   char buffer[ 16 ] { "before" };
+   std::string aString { "a std::string" };
+
+   LOG_TEST( "Copied [%s] [%s]", buffer, aString.c_str() );
+   strcpy( buffer, "after" );
+   aString = "something else entirely, long enough to reallocate";
+
+   BOOST_CHECK_EQUAL( lastMessage(), "Copied [before] [a std::string]" );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_deferred_fallback ) {
+   /// Arguments that don't fit in LogEntry::msg are formatted by the producer
+   const std::string big( LOG_MSG_LENGTH + 32, 'x' );
+   LOG_TEST( "Big %s", big.c_str() );
+
+   BOOST_CHECK( logPeek().fmt == nullptr );
+   BOOST_CHECK_EQUAL( std::string( logPeek().msg ), "Big " + std::string( LOG_MSG_LENGTH - 5, 'x' ) );
+   BOOST_CHECK_EQUAL( lastMessage(), "Big " + std::string( LOG_MSG_LENGTH - 5, 'x' ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_deferred_mismatch ) {
+   /// A bad format can't read the wrong type or past the arguments
+   LOG_TEST( "Wrong [%s] [%d] [%f]", 1, "two", 3 );
+   BOOST_CHECK_EQUAL( lastMessage(), "Wrong [(?)] [(?)] [(?)]" );
+
+   LOG_TEST( "Missing [%d] [%s]", 1 );
+   BOOST_CHECK_EQUAL( lastMessage(), "Missing [1] [(?)]" );
+
+   LOG_TEST( "Wrong length [%d] [%hd]", int64_t { 1 } << 40, 70000 );
+   BOOST_CHECK_EQUAL( lastMessage(), "Wrong length [1099511627776] [4464]" );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_deferred_consumer ) {
+   logReset();
+
+   LogConsumer consumer;
+   auto& memory = dynamic_cast< LogSinkMemory& >( consumer.addSink( std::make_unique< LogSinkMemory >() ) );
+   consumer.restart();
+
+   for( int i = 0 ; i < 50 ; i++ ) {
+      LOG_INFO( "Deferred %s entry %d of %.1f", "consumer", i, 50.0 );
+   }
+   consumer.sync();
+
+   const std::vector< LogEntry > entries = memory.getEntries();
+   BOOST_REQUIRE_EQUAL( entries.size(), 50 );
+   for( size_t i = 0 ; i < entries.size() ; i++ ) {
+      BOOST_CHECK( entries[ i ].fmt == nullptr );
+      BOOST_CHECK_EQUAL( entries[ i ].msg, "Deferred consumer entry " + std::to_string( i ) + " of 50.0" );
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+// NOLINTEND( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays )
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+/// @endcond
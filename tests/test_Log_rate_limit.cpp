@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Test per-call-site rate limiting (defining `LOG_RATE_LIMIT`)
+///
+/// @file      tests/test_Log_rate_limit.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+/// @cond Suppress Doxygen warnings
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Tests will have magic numbers
+/// @NOLINTBEGIN( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay ): For performance reasons, we cast arrays to pointers
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>  // For atomic<>
+#include <chrono>  // For milliseconds
+#include <string>  // For string
+#include <thread>  // For thread sleep_for()
+#include <vector>  // For vector<>
+
+#include "../src/lib/LogSeverity.hpp"  // For LOG_SEVERITY #defines
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "test_Log_rate_limit" };
+
+/// Logs at and above `MIN_LOG_SEVERITY` will be available.  Logs below
+/// `MIN_LOG_SEVERITY` will not be compiled into the source file.
+#define MIN_LOG_SEVERITY LOG_SEVERITY_TEST
+
+/// Rate-limit each `LOG_*` macro in this module
+#define LOG_RATE_LIMIT
+#include "../src/lib/Log.hpp"
+
+#include "../src/lib/LogConsumer.hpp"  // For logHead() logEntryAt()
+
+
+/* ****************************************************************************
+   White Box Test Declarations
+
+   These declarations may contain duplicate code or code that needs to be in
+   sync with the code under test.  Because these are white box tests, it's on
+   the tester to ensure the code is in sync.                                 */
+
+namespace empire {
+   extern void logReset();
+   extern LogEntry& logPeek();
+} // namespace empire
+
+/* ***************************************************************************/
+
+
+using namespace empire;
+using namespace std;
+
+/// @return The messages queued since `start`
+static vector< string > messagesSince( const size_t start ) {
+   vector< string > messages;
+   for( size_t i = start ; i < logHead() ; i++ ) {
+      messages.emplace_back( logEntryAt( i ).msg );
+   }
+   return messages;
+}
+
+
+BOOST_AUTO_TEST_SUITE( Log )
+
+BOOST_AUTO_TEST_CASE( Log_rate_limit_repeats ) {
+   logReset();
+   setLogRateLimit( 0, 0 );
+
+   for( int i = 0 ; i < 50 ; i++ ) {
+      LOG_TEST( "Same %d", 1 );
+   }
+   BOOST_CHECK_EQUAL( logHead(), 1 );
+
+   for( int i = 0 ; i < 3 ; i++ ) {
+      LOG_TEST( "Different %d", i );
+   }
+
+   const vector< string > messages = messagesSince( 0 );
+   BOOST_REQUIRE_EQUAL( messages.size(), 4 );
+   BOOST_CHECK_EQUAL( messages[ 0 ], "Same 1" );
+   BOOST_CHECK_EQUAL( messages[ 1 ], "Different 0" );  // Another call site
+   BOOST_CHECK_EQUAL( messages[ 2 ], "Different 1" );
+   BOOST_CHECK_EQUAL( messages[ 3 ], "Different 2" );
+
+   /// The repeats are reported when the call site logs something else
+   for( int i = 0 ; i < 6 ; i++ ) {
+      LOG_INFO( "Maybe the same %d", i / 5 );
+   }
+   BOOST_CHECK_EQUAL( logEntryAt( logHead() - 2 ).msg, "Previous message repeated 4 times" );
+   BOOST_CHECK( logEntryAt( logHead() - 2 ).logSeverity == LogSeverity::info );
+   BOOST_CHECK_EQUAL( logModuleName( logEntryAt( logHead() - 2 ).moduleId ), "test_Log_rate_limit" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Maybe the same 1" );
+
+   setLogRateLimit( LOG_RATE_LIMIT_PER_SECOND, LOG_RATE_LIMIT_BURST );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_rate_limit_token_bucket ) {
+   logReset();
+   setLogRateLimit( 20, 5 );
+   BOOST_CHECK_EQUAL( getLogRateLimitPerSecond(), 20 );
+   BOOST_CHECK_EQUAL( getLogRateLimitBurst(), 5 );
+
+   /// A burst gets through, then the call site is cut off
+   auto runaway = []( const int i ) { LOG_WARN( "Runaway %d", i ); };
+   for( int i = 0 ; i < 100 ; i++ ) {
+      runaway( i );
+   }
+   BOOST_CHECK_EQUAL( logHead(), 5 );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Runaway 4" );
+
+   /// Other call sites have their own bucket
+   LOG_WARN( "Someone else" );
+   BOOST_CHECK_EQUAL( logPeek().msg, "Someone else" );
+
+   /// The bucket refills at 20 per second
+   this_thread::sleep_for( 120ms );
+   const size_t start = logHead();
+   runaway( 100 );
+
+   const vector< string > messages = messagesSince( start );
+   BOOST_REQUIRE_EQUAL( messages.size(), 2 );
+   BOOST_CHECK_EQUAL( messages[ 0 ], "Rate limit dropped 95 log entries" );
+   BOOST_CHECK_EQUAL( messages[ 1 ], "Runaway 100" );
+
+   setLogRateLimit( LOG_RATE_LIMIT_PER_SECOND, LOG_RATE_LIMIT_BURST );
+}
+
+
+BOOST_AUTO_TEST_CASE( Log_rate_limit_threads ) {
+   logReset();
+   setLogRateLimit( 1, 1000 );
+
+   /// Many threads share a call site's bucket without a lock
+   const size_t producers = 8;
+   atomic< bool > go { false };
+   vector< thread > threads;
+   for( size_t t = 0 ; t < producers ; t++ ) {
+      threads.emplace_back( [ t, &go ]() {
+         while( !go.load() ) {
+            this_thread::yield();
+         }
+         for( int n = 0 ; n < 1000 ; n++ ) {
+            LOG_TEST( "Thread %zu entry %d", t, n );
+         }
+      } );
+   }
+   go.store( true );
+   for( thread& thread : threads ) {
+      thread.join();
+   }
+
+   /// The bucket holds 1000 tokens and it's refilling at 1 per second
+   BOOST_CHECK_GE( logHead(), 1000 );
+   BOOST_CHECK_LE( logHead(), 1002 );
+
+   setLogRateLimit( LOG_RATE_LIMIT_PER_SECOND, LOG_RATE_LIMIT_BURST );
+   logReset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+// NOLINTEND( cppcoreguidelines-pro-bounds-array-to-pointer-decay, hicpp-no-array-decay )
+// NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+/// @endcond
@@ -12,10 +12,18 @@
 
 #include <boost/test/unit_test.hpp>
 
-#define LOG_CHANNEL "test_Singleton"  /// @NOLINT( cppcoreguidelines-macro-usage ): A #define is OK here
+#include <atomic>  // For atomic<>
+#include <thread>  // For thread
+#include <vector>  // For vector<>
+
+/// The name of the module for logging purposes
+/// @NOLINTNEXTLINE( cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays ): A `char[]` array is acceptable here
+[[maybe_unused]] alignas(32) static constinit const char LOG_MODULE[32] { "test_Singleton" };
+
 #include "../src/lib/Log.hpp"
 
 #include "../src/lib/Singleton.hpp"
+#include "../src/lib/StaticSingleton.hpp"
 
 using namespace std;
 using namespace empire;
@@ -323,6 +331,202 @@ BOOST_AUTO_TEST_CASE( Singleton_with_parameters ) {
    BOOST_CHECK( true );
 }
 
+
+/// A Singleton that's slow to construct, so threads pile up in get()
+class TestSingleton4 final : public Singleton< TestSingleton4 > {
+public:
+   explicit TestSingleton4( [[maybe_unused]] token singletonToken ) {
+      this_thread::sleep_for( 1ms );
+   }
+};
+
+
+/// A Singleton that counts its own constructions and destructions, and
+/// notices if two of them are ever alive at once
+class TestCountedSingleton final : public Singleton< TestCountedSingleton > {  /// @NOLINT( cppcoreguidelines-special-member-functions, hicpp-special-member-functions ): Copy and Move assignment constructors are in the template
+public:
+   explicit TestCountedSingleton( [[maybe_unused]] token singletonToken ) {
+      if( live.fetch_add( 1 ) != 0 ) {
+         overlaps.fetch_add( 1 );
+      }
+      constructions.fetch_add( 1 );
+   }
+
+   ~TestCountedSingleton() override {
+      live.fetch_sub( 1 );
+      destructions.fetch_add( 1 );
+   }
+
+   static inline atomic< int >    live { 0 };           ///< The instances that are alive right now
+   static inline atomic< size_t > overlaps { 0 };       ///< Constructions while another instance was alive
+   static inline atomic< size_t > constructions { 0 };  ///< Every construction
+   static inline atomic< size_t > destructions { 0 };   ///< Every destruction
+};
+
+
+/// Start `threads` threads together and run `work( t )` in each of them
+template< typename Work >
+static void runTogether( const size_t threads, Work work ) {
+   atomic< bool > go { false };
+   vector< thread > workers;
+   for( size_t t = 0 ; t < threads ; t++ ) {
+      workers.emplace_back( [ t, &go, &work ]() {
+         while( !go.load() ) {
+            this_thread::yield();
+         }
+         work( t );
+      } );
+   }
+   go.store( true );
+   for( thread& worker : workers ) {
+      worker.join();
+   }
+}
+
+
+BOOST_AUTO_TEST_CASE( Singleton_concurrent_get ) {
+   TestSingleton4::erase();
+   const singleton_counter_t constructed = TestSingleton4::getConstructedCount();
+
+   /// Every thread races to construct it, but only one does
+   const size_t threads = 16;
+   vector< const TestSingleton4* > seen( threads );
+   runTogether( threads, [ &seen ]( const size_t t ) {
+      seen[ t ] = &TestSingleton4::get();
+   } );
+
+   BOOST_CHECK_EQUAL( TestSingleton4::getConstructedCount(), constructed + 1 );
+   for( const TestSingleton4* singleton : seen ) {
+      BOOST_CHECK_EQUAL( singleton, &TestSingleton4::get() );
+   }
+   BOOST_CHECK_NO_THROW( TestSingleton4::validate() );
+
+   TestSingleton4::erase();
+}
+
+
+BOOST_AUTO_TEST_CASE( Singleton_stress_get_and_erase ) {
+   TestCountedSingleton::erase();
+   BOOST_REQUIRE_EQUAL( TestCountedSingleton::live.load(), 0 );
+   const size_t constructions = TestCountedSingleton::constructions.load();
+   const size_t destructions = TestCountedSingleton::destructions.load();
+
+   /// Threads get() and erase() it over and over.  Nobody touches the
+   /// instance after get(), as an erase() on another thread can delete it.
+   runTogether( 8, []( const size_t t ) {
+      for( size_t i = 0 ; i < 2000 ; i++ ) {
+         if( ( i + t ) % 64 == 0 ) {
+            TestCountedSingleton::erase();
+         } else {
+            (void) TestCountedSingleton::get();
+         }
+      }
+   } );
+
+   /// Only one instance was ever alive at a time...
+   BOOST_CHECK_EQUAL( TestCountedSingleton::overlaps.load(), 0 );
+   BOOST_CHECK_LE( TestCountedSingleton::live.load(), 1 );
+   BOOST_CHECK( TestCountedSingleton::isInstantiated() == ( TestCountedSingleton::live.load() == 1 ) );
+
+   /// ...and everything constructed is destroyed exactly once
+   TestCountedSingleton::erase();
+   BOOST_CHECK_EQUAL( TestCountedSingleton::live.load(), 0 );
+   BOOST_CHECK_GT( TestCountedSingleton::constructions.load(), constructions );
+   BOOST_CHECK_EQUAL( TestCountedSingleton::constructions.load() - constructions, TestCountedSingleton::destructions.load() - destructions );
+}
+
+
+/// A Singleton identified by a generation number
+class TestSingleton5 final : public Singleton< TestSingleton5, SingletonGenerationIdentity > {
+public:
+   explicit TestSingleton5( [[maybe_unused]] token singletonToken ) {}
+};
+
+
+/// A Singleton with no identity
+class TestSingleton6 final : public Singleton< TestSingleton6, SingletonNoIdentity > {
+public:
+   explicit TestSingleton6( [[maybe_unused]] token singletonToken ) {}
+};
+
+
+BOOST_AUTO_TEST_CASE( Singleton_identity_policies ) {
+   /// Generations count up and are 0 when it's empty
+   TestSingleton5::erase();
+   const uint64_t generation = TestSingleton5::get().getIdentity();
+   BOOST_CHECK_GT( generation, 0 );
+   BOOST_CHECK_NO_THROW( TestSingleton5::validate() );
+   BOOST_CHECK( TestSingleton5::info().find( " generation=" + to_string( generation ) + " constructed " ) != string::npos );
+
+   TestSingleton5::erase();
+   BOOST_CHECK_NO_THROW( TestSingleton5::validate() );
+   BOOST_CHECK( TestSingleton5::info().find( " generation=0 " ) != string::npos );
+   BOOST_CHECK_GT( TestSingleton5::get().getIdentity(), generation );
+   TestSingleton5::erase();
+
+   /// No identity at all, but the counters are still checked
+   const singleton_counter_t constructed = TestSingleton6::getConstructedCount();
+   BOOST_CHECK_NO_THROW( TestSingleton6::get() );
+   BOOST_CHECK_NO_THROW( TestSingleton6::validate() );
+   BOOST_CHECK_EQUAL( TestSingleton6::getConstructedCount(), constructed + 1 );
+   BOOST_CHECK( TestSingleton6::info().find( "=" ) == string::npos );  // No identity in info()
+   TestSingleton6::erase();
+   BOOST_CHECK_NO_THROW( TestSingleton6::validate() );
+
+   /// UUIDs from the shared generator are still unique
+   TestSingleton1::erase();
+   const boost::uuids::uuid uuid1 = TestSingleton1::get().getUUID();
+   TestSingleton1::erase();
+   BOOST_CHECK_NE( uuid1, TestSingleton1::get().getUUID() );
+   BOOST_CHECK_NE( uuid1, SingletonUuidIdentity::nil() );
+}
+
+
+/// A hot model object in a StaticSingleton
+class TestStatic final {
+public:
+   TestStatic( [[maybe_unused]] StaticSingleton< TestStatic >::token singletonToken, const int startValue ) : value { startValue } {
+      constructed += 1;
+   }
+
+   ~TestStatic() {
+      destroyed += 1;
+   }
+
+   TestStatic( const TestStatic& ) = delete;             ///< Disable copy constructor
+   TestStatic( TestStatic&& ) = delete;                  ///< Disable move constructor
+   TestStatic& operator=( const TestStatic& ) = delete;  ///< Disable copy assignment
+   TestStatic& operator=( TestStatic&& ) = delete;       ///< Disable move assignment
+
+   int value;                             ///< Set by the constructor
+   inline static int constructed { 0 };  ///< The number of times it was constructed
+   inline static int destroyed { 0 };    ///< The number of times it was destroyed
+};
+
+
+BOOST_AUTO_TEST_CASE( Singleton_static ) {
+   BOOST_CHECK( !StaticSingleton< TestStatic >::isConstructed() );
+
+   TestStatic& first = StaticSingleton< TestStatic >::construct( 42 );
+   BOOST_CHECK( StaticSingleton< TestStatic >::isConstructed() );
+   BOOST_CHECK_EQUAL( StaticSingleton< TestStatic >::get().value, 42 );
+   BOOST_CHECK_EQUAL( &first, &StaticSingleton< TestStatic >::get() );
+   BOOST_CHECK_EQUAL( reinterpret_cast< uintptr_t >( &first ) % CACHE_LINE_BYTES, 0 );
+   BOOST_CHECK_THROW( StaticSingleton< TestStatic >::construct( 1 ), logic_error );
+
+   StaticSingleton< TestStatic >::destroy();
+   BOOST_CHECK( !StaticSingleton< TestStatic >::isConstructed() );
+   BOOST_CHECK_EQUAL( TestStatic::destroyed, 1 );
+   StaticSingleton< TestStatic >::destroy();
+   BOOST_CHECK_EQUAL( TestStatic::destroyed, 1 );
+
+   /// It comes back at the same address
+   BOOST_CHECK_EQUAL( &StaticSingleton< TestStatic >::construct( 7 ), &first );
+   BOOST_CHECK_EQUAL( first.value, 7 );
+   BOOST_CHECK_EQUAL( TestStatic::constructed, 2 );
+   StaticSingleton< TestStatic >::destroy();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 /// @NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
 /// @endcond
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+//  Empire V - What you do is what you do
+//
+/// Test the eager, ordered startup of Singletons
+///
+/// @file      tests/test_SingletonRegistry.cpp
+/// @author    Mark Nelson <marknels@hawaii.edu>
+/// @copyright (c) 2023 Mark Nelson.  All rights reserved.
+///////////////////////////////////////////////////////////////////////////////
+/// @cond Suppress Doxygen warnings
+/// @NOLINTBEGIN( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers ): Magic numbers are OK in tests
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>     // For atomic<>
+#include <chrono>     // For milliseconds
+#include <stdexcept>  // For logic_error runtime_error
+#include <string>     // For string
+#include <thread>     // For sleep_for()
+#include <vector>     // For vector<>
+
+#include "../src/lib/Singleton.hpp"
+#include "../src/lib/SingletonRegistry.hpp"
+#include "../src/lib/StaticSingleton.hpp"
+
+
+/* ****************************************************************************
+   White Box Test Declarations
+
+   These declarations may contain duplicate code or code that needs to be in
+   sync with the code under test.  Because these are white box tests, it's on
+   the tester to ensure the code is in sync.                                 */
+
+namespace empire {
+   extern void singletonRegistryReset();
+} // namespace empire
+
+/* ***************************************************************************/
+
+
+using namespace std;
+using namespace empire;
+
+/// Counts constructions, so each Singleton knows when it was constructed
+static atomic< int > Ticket { 0 };  // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's a test
+
+/// The most Singleton constructors that ran at once
+static atomic< int > Running { 0 };     // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's a test
+static atomic< int > MostRunning { 0 };  // NOLINT( cppcoreguidelines-avoid-non-const-global-variables ): It's a test
+
+/// A Singleton that takes a while to construct and remembers when it was
+/// constructed and erased
+template< int N >
+class Startup final : public Singleton< Startup< N > > {
+public:
+   explicit Startup( [[maybe_unused]] typename Singleton< Startup< N > >::token singletonToken ) {
+      const int running = Running.fetch_add( 1 ) + 1;
+      int most = MostRunning.load();
+      while( running > most && !MostRunning.compare_exchange_weak( most, running ) ) {}
+      this_thread::sleep_for( 20ms );
+      Running.fetch_sub( 1 );
+      constructed = Ticket.fetch_add( 1 );
+   }
+
+   ~Startup() override {
+      erased = Ticket.fetch_add( 1 );
+   }
+
+   Startup( const Startup& ) = delete;  ///< Disable copy constructor
+   Startup( Startup&& ) = delete;       ///< Disable move constructor
+
+   inline static int constructed { -1 };  ///< The Ticket when it was constructed
+   inline static int erased { -1 };       ///< The Ticket when it was erased
+};
+
+/// A StaticSingleton that needs Startup< 0 >
+class HotPath final {
+public:
+   explicit HotPath( [[maybe_unused]] StaticSingleton< HotPath >::token singletonToken ) : after { Startup< 0 >::isInstantiated() } {}
+
+   bool after;  ///< `true` if Startup< 0 > was there first
+};
+
+/// A Singleton that can't be constructed
+class Broken final : public Singleton< Broken > {
+public:
+   explicit Broken( [[maybe_unused]] token singletonToken ) {
+      throw runtime_error( "Broken" );
+   }
+};
+
+
+BOOST_AUTO_TEST_SUITE( SingletonRegistry )
+
+BOOST_AUTO_TEST_CASE( SingletonRegistry_order ) {
+   singletonRegistryReset();
+   Ticket.store( 0 );
+   MostRunning.store( 0 );
+
+   /// A diamond:  1 needs 0, 2 needs 0, 3 needs 1 and 2.  3 is registered
+   /// before the things it needs.
+   registerSingleton< Startup< 3 > >( "Three", { "One", "Two" } );
+   registerSingleton< Startup< 0 > >( "Zero" );
+   registerSingleton< Startup< 1 > >( "One", { "Zero" } );
+   registerSingleton< Startup< 2 > >( "Two", { "Zero" } );
+   BOOST_CHECK_THROW( registerSingleton< Startup< 2 > >( "Two" ), logic_error );
+
+   const vector< SingletonInitTime > times = startSingletons( 4 );
+   BOOST_REQUIRE_EQUAL( times.size(), 4 );
+   BOOST_CHECK( Startup< 0 >::isInstantiated() );
+   BOOST_CHECK( Startup< 3 >::isInstantiated() );
+
+   BOOST_CHECK_EQUAL( Startup< 0 >::constructed, 0 );
+   BOOST_CHECK_EQUAL( Startup< 3 >::constructed, 3 );
+   BOOST_CHECK_EQUAL( times[ 0 ].name, "Zero" );
+   BOOST_CHECK_EQUAL( times[ 0 ].depth, 0 );
+   BOOST_CHECK_EQUAL( times[ 1 ].depth, 1 );
+   BOOST_CHECK_EQUAL( times[ 2 ].depth, 1 );
+   BOOST_CHECK_EQUAL( times[ 3 ].name, "Three" );
+   BOOST_CHECK_EQUAL( times[ 3 ].depth, 2 );
+   for( const SingletonInitTime& time : times ) {
+      BOOST_CHECK_GE( time.ns, 20'000'000 );
+   }
+
+   /// One and Two don't depend on each other, so they're built together
+   BOOST_CHECK_EQUAL( MostRunning.load(), 2 );
+
+   BOOST_CHECK_THROW( startSingletons(), logic_error );
+
+   /// Erased in the reverse order
+   stopSingletons();
+   BOOST_CHECK( !Startup< 0 >::isInstantiated() );
+   BOOST_CHECK_EQUAL( Startup< 3 >::erased, 4 );
+   BOOST_CHECK_EQUAL( Startup< 0 >::erased, 7 );
+   BOOST_CHECK_LT( Startup< 1 >::erased, Startup< 0 >::erased );
+   BOOST_CHECK_LT( Startup< 2 >::erased, Startup< 0 >::erased );
+
+   singletonRegistryReset();
+}
+
+
+BOOST_AUTO_TEST_CASE( SingletonRegistry_errors ) {
+   singletonRegistryReset();
+   registerSingleton< Startup< 0 > >( "Zero", { "Missing" } );
+   BOOST_CHECK_THROW( startSingletons(), logic_error );
+
+   singletonRegistryReset();
+   registerSingleton< Startup< 0 > >( "Zero", { "One" } );
+   registerSingleton< Startup< 1 > >( "One", { "Zero" } );
+   BOOST_CHECK_THROW( startSingletons(), logic_error );
+   BOOST_CHECK( !Startup< 0 >::isInstantiated() );
+
+   /// A constructor that throws stops the startup.  What was constructed is
+   /// still erased by stopSingletons().
+   singletonRegistryReset();
+   registerSingleton< Startup< 0 > >( "Zero" );
+   registerSingleton< Broken >( "Broken", { "Zero" } );
+   registerSingleton< Startup< 1 > >( "One", { "Broken" } );
+   BOOST_CHECK_THROW( startSingletons(), runtime_error );
+   BOOST_CHECK( Startup< 0 >::isInstantiated() );
+   BOOST_CHECK( !Startup< 1 >::isInstantiated() );
+   stopSingletons();
+   BOOST_CHECK( !Startup< 0 >::isInstantiated() );
+
+   singletonRegistryReset();
+}
+
+
+BOOST_AUTO_TEST_CASE( SingletonRegistry_static ) {
+   singletonRegistryReset();
+   registerStaticSingleton< HotPath >( "HotPath", { "Zero" } );
+   registerSingleton< Startup< 0 > >( "Zero" );
+
+   startSingletons( 2 );
+   BOOST_REQUIRE( StaticSingleton< HotPath >::isConstructed() );
+   BOOST_CHECK( StaticSingleton< HotPath >::get().after );
+
+   stopSingletons();
+   BOOST_CHECK( !StaticSingleton< HotPath >::isConstructed() );
+   BOOST_CHECK( !Startup< 0 >::isInstantiated() );
+
+   singletonRegistryReset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+/// @NOLINTEND( cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers )
+/// @endcond